@@ -0,0 +1,133 @@
+/* Host microbenchmark: request arena against malloc/free
+
+   Replays the buffer pattern of /hello (three header values and the query
+   string) for sessions served round-robin, like the httpd task does. Each
+   request also leaves a small object behind that lives for a few requests,
+   like a detached request's context, which is what splits the heap between
+   short-lived buffers. Reports ns per request, heap calls per request and
+   the fragmentation of the host heap stand-in at the end of the run.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <esp_heap_caps.h>
+
+#include "arena.h"
+
+#define SESSIONS        7
+#define LINGER          16      /* requests a leftover object lives */
+
+static const char *const values[] = {
+    "192.168.4.1",
+    "Test-Value-2",
+    "Test-Value-1",
+    "query1=value1&query3=value3&query2=value2",
+};
+#define N_VALUES (sizeof(values) / sizeof(values[0]))
+
+static void *linger[LINGER];
+static volatile size_t sink;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void leave_behind(long r)
+{
+    free(linger[r % LINGER]);
+    linger[r % LINGER] = malloc(24 + (r % 5) * 8);
+}
+
+static void clear_linger(void)
+{
+    for (int i = 0; i < LINGER; i++) {
+        free(linger[i]);
+        linger[i] = NULL;
+    }
+}
+
+/* scale stretches the values, 1 is what /hello sees */
+static double run_malloc(long requests, size_t scale, unsigned *frag)
+{
+    double t0 = now_ns();
+
+    for (long r = 0; r < requests; r++) {
+        for (size_t i = 0; i < N_VALUES; i++) {
+            size_t len = strlen(values[i]) * scale + 1;
+            char *buf = malloc(len);
+            memset(buf, values[i][0], len - 1);
+            buf[len - 1] = '\0';
+            sink += buf[0];
+            free(buf);
+        }
+        leave_behind(r);
+    }
+    double ns = (now_ns() - t0) / requests;
+    size_t free_size = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    *frag = free_size ? 100 - heap_caps_get_largest_free_block(MALLOC_CAP_8BIT) * 100 / free_size : 0;
+    clear_linger();
+    return ns;
+}
+
+static double run_arena(long requests, size_t scale, unsigned *frag, arena_stats_t *st)
+{
+    arena_t *arenas[SESSIONS];
+
+    for (int s = 0; s < SESSIONS; s++) {
+        arenas[s] = arena_create(CONFIG_EXAMPLE_ARENA_BLOCK_SIZE);
+    }
+    double t0 = now_ns();
+    for (long r = 0; r < requests; r++) {
+        arena_t *arena = arenas[r % SESSIONS];
+        for (size_t i = 0; i < N_VALUES; i++) {
+            size_t len = strlen(values[i]) * scale + 1;
+            char *buf = arena_alloc(arena, len);
+            memset(buf, values[i][0], len - 1);
+            buf[len - 1] = '\0';
+            sink += buf[0];
+        }
+        arena_end(arena);
+        leave_behind(r);
+    }
+    double ns = (now_ns() - t0) / requests;
+    arena_get_stats(st);
+    *frag = st->fragmentation;
+    clear_linger();
+    for (int s = 0; s < SESSIONS; s++) {
+        arena_destroy(arenas[s]);
+    }
+    return ns;
+}
+
+int main(int argc, char **argv)
+{
+    long requests = argc > 1 ? atol(argv[1]) : 2000000;
+    static const size_t scales[] = { 1, 2, 8 };
+
+    printf("%ld requests, %d sessions, %d byte arenas\n", requests, SESSIONS,
+           CONFIG_EXAMPLE_ARENA_BLOCK_SIZE);
+    printf("bytes/req  malloc ns/req calls frag%%   arena ns/req calls frag%%  speedup\n");
+    for (size_t i = 0; i < sizeof(scales) / sizeof(scales[0]); i++) {
+        arena_stats_t before, after;
+        unsigned frag_m, frag_a;
+        size_t bytes = 0;
+
+        for (size_t v = 0; v < N_VALUES; v++) {
+            bytes += strlen(values[v]) * scales[i] + 1;
+        }
+        double ns_m = run_malloc(requests, scales[i], &frag_m);
+        arena_get_stats(&before);
+        double ns_a = run_arena(requests, scales[i], &frag_a, &after);
+        double calls_a = (double)(after.overflows - before.overflows) * 2 / requests;
+
+        printf("%9zu %15.1f %5d %5u %14.1f %5.2f %5u %7.2fx\n", bytes, ns_m,
+               (int)N_VALUES * 2, frag_m, ns_a, calls_a, frag_a, ns_m / ns_a);
+    }
+    printf("heap calls exclude the object each request leaves behind\n");
+    return (int)(sink & 0);
+}
@@ -0,0 +1,103 @@
+/* Host microbenchmark: UART frame codec throughput
+
+   Encodes and parses streams of frames carrying 1..32 LED commands and
+   compares the codec's CPU throughput with what a UART can carry at
+   common baud rates (10 bits per byte on the wire). The wire columns show
+   commands per second; the old protocol sent one command per 4 byte frame.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "frame.h"
+
+static const long bauds[] = { 115200, 460800, 921600, 2000000, 3000000 };
+#define N_BAUDS (sizeof(bauds) / sizeof(bauds[0]))
+
+static uint8_t stream[1 << 20];
+static volatile size_t parsed;
+
+static void on_frame(uint8_t seq, const uint8_t *payload, size_t len, void *arg)
+{
+    parsed += len;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void run(int cmds, int rounds)
+{
+    uint8_t buf[FRAME_MAX_PAYLOAD];
+    frame_payload_t payload;
+    frame_parser_t parser;
+    size_t frame_len = 0;
+    size_t n = 0;
+    long frames = 0;
+
+    frame_payload_init(&payload, buf, sizeof(buf));
+    for (int i = 0; i < cmds; i++) {
+        uint8_t state = i & 1;
+        frame_payload_add(&payload, FRAME_OP_LED, &state, 1);
+    }
+
+    double t0 = now_ns();
+    for (int r = 0; r < rounds; r++) {
+        n = 0;
+        frames = 0;
+        while (n + FRAME_MAX_LEN <= sizeof(stream)) {
+            frame_len = frame_encode(stream + n, sizeof(stream) - n, (uint8_t)frames, payload.buf, payload.len);
+            n += frame_len;
+            frames++;
+        }
+    }
+    double enc_ns = (now_ns() - t0) / rounds;
+
+    frame_parser_init(&parser);
+    t0 = now_ns();
+    for (int r = 0; r < rounds; r++) {
+        /* 64 byte reads, the size of a typical UART_DATA event */
+        for (size_t i = 0; i < n; i += 64) {
+            frame_parser_feed(&parser, stream + i, n - i < 64 ? n - i : 64, on_frame, NULL);
+        }
+    }
+    double dec_ns = (now_ns() - t0) / rounds;
+
+    double enc_mbs = n / enc_ns * 1e3;
+    double dec_mbs = n / dec_ns * 1e3;
+    printf("%4d %5zu %8.0f %8.0f %9.1f", cmds, frame_len, enc_mbs, dec_mbs,
+           dec_ns / frames);
+    for (size_t b = 0; b < N_BAUDS; b++) {
+        double wire = bauds[b] / 10.0;
+        printf(" %9.0f", wire / frame_len * cmds);
+    }
+    printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+    int rounds = argc > 1 ? atoi(argv[1]) : 20;
+    static const int cmds[] = { 1, 2, 4, 8, 16, 32 };
+
+    printf("codec CPU throughput (MB/s) and wire capacity (LED commands/s)\n");
+    printf("cmds frame   enc MB/s dec MB/s  ns/frame");
+    for (size_t b = 0; b < N_BAUDS; b++) {
+        printf(" %9ld", bauds[b]);
+    }
+    printf("\n");
+    printf("old      4        -        -         -");
+    for (size_t b = 0; b < N_BAUDS; b++) {
+        printf(" %9.0f", bauds[b] / 10.0 / 4);
+    }
+    printf("\n");
+    for (size_t i = 0; i < sizeof(cmds) / sizeof(cmds[0]); i++) {
+        run(cmds[i], rounds);
+    }
+    printf("highest baud rate: %ld bytes/s on the wire\n", bauds[N_BAUDS - 1] / 10);
+    return 0;
+}
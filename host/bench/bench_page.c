@@ -0,0 +1,171 @@
+/* Host microbenchmark: segmented page renderer vs. the old copy-and-scan loop
+
+   The old index_get_handler copied index_htm byte by byte into a stack
+   buffer, replaced the CCC/TTT markers on the fly and sent the result with
+   strlen. All variants below send into the same memory sink so only the
+   rendering cost differs; "cached" is index_get_handler's path on a
+   response cache hit.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "assets_data.h"
+#include "resp_cache.h"
+#include "state.h"
+
+static char sink[4096];
+static size_t sink_len;
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t *r, const char *buf, ssize_t buf_len)
+{
+    if (buf_len == HTTPD_RESP_USE_STRLEN) {
+        buf_len = strlen(buf);
+    }
+    if (buf == NULL || buf_len == 0) {
+        return ESP_OK;
+    }
+    memcpy(sink + sink_len, buf, buf_len);
+    sink_len += buf_len;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, ssize_t buf_len)
+{
+    sink_len = 0;
+    return httpd_resp_send_chunk(r, buf, buf_len);
+}
+
+esp_err_t httpd_resp_set_hdr(httpd_req_t *r, const char *field, const char *value)
+{
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_type(httpd_req_t *r, const char *type)
+{
+    return ESP_OK;
+}
+
+/* The page as it used to be embedded: CCC/TTT markers for the LED slots */
+static unsigned char index_htm[4096];
+static unsigned int index_htm_len;
+
+static void build_legacy_page(void)
+{
+    static const char *const markers[INDEX_SLOT_COUNT] = {
+        [INDEX_SLOT_LED_CLASS] = "CCC",
+        [INDEX_SLOT_LED_TEXT]  = "TTT",
+        [INDEX_SLOT_UPTIME]    = "0",
+        [INDEX_SLOT_HEAP]      = "0",
+    };
+    for (size_t i = 0; i < index_page.n_parts; i++) {
+        const page_part_t *part = &index_page.parts[i];
+        memcpy(index_htm + index_htm_len, part->data, part->len);
+        index_htm_len += part->len;
+        if (part->slot != PAGE_NO_SLOT) {
+            size_t n = strlen(markers[part->slot]);
+            memcpy(index_htm + index_htm_len, markers[part->slot], n);
+            index_htm_len += n;
+        }
+    }
+}
+
+static void legacy_render(httpd_req_t *req, int lvl)
+{
+    int i;
+    char buf[4096] = {0};
+    const char *led_lvl = lvl ? "ON " : "OFF";
+    const char *led_cls = lvl ? "on " : "off";
+    for(i = 0; i < index_htm_len; i++) {
+        buf[i] = index_htm[i];
+        if(i > 3 && buf[i-2] == 'C' && buf[i-1] == 'C' && buf[i] == 'C') {
+            buf[i-2] = led_cls[0];
+            buf[i-1] = led_cls[1];
+            buf[i] = led_cls[2];
+        }
+        if(i > 3 && buf[i-2] == 'T' && buf[i-1] == 'T' && buf[i] == 'T') {
+            buf[i-2] = led_lvl[0];
+            buf[i-1] = led_lvl[1];
+            buf[i] = led_lvl[2];
+        }
+    }
+    buf[i] = 0;
+    httpd_resp_send(req, buf, HTTPD_RESP_USE_STRLEN);
+}
+
+static void index_values(const char **values, int lvl)
+{
+    values[INDEX_SLOT_LED_CLASS] = lvl ? "on" : "off";
+    values[INDEX_SLOT_LED_TEXT]  = lvl ? "ON" : "OFF";
+    values[INDEX_SLOT_UPTIME]    = "0";
+    values[INDEX_SLOT_HEAP]      = "0";
+}
+
+static void segment_render(httpd_req_t *req, int lvl)
+{
+    const char *values[INDEX_SLOT_COUNT];
+
+    index_values(values, lvl);
+    sink_len = 0;
+    page_send(req, &index_page, values);
+}
+
+static void cached_render(httpd_req_t *req, int lvl)
+{
+    const char *values[INDEX_SLOT_COUNT];
+
+    if (resp_cache_send(req) != ESP_ERR_NOT_FOUND) {
+        return;
+    }
+    index_values(values, state_version() & 1);
+    size_t len = page_length(&index_page, values);
+    char *body = resp_cache_reserve(req, state_version(), 0, "text/html", NULL, len);
+    if (body) {
+        page_render(&index_page, values, body, len + 1);
+        resp_cache_commit(req);
+    }
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* The request all variants render for */
+static httpd_req_t req_uri;
+
+static double run(const char *name, void (*render)(httpd_req_t *, int), long iters)
+{
+    httpd_req_t req = req_uri;
+    volatile size_t total = 0;
+    double t0 = now_ns();
+    for (long n = 0; n < iters; n++) {
+        render(&req, n & 1);
+        total += sink_len;
+    }
+    double ns = (now_ns() - t0) / iters;
+    printf("%-8s %9.1f ns/render  %5zu bytes\n", name, ns, total / iters);
+    return ns;
+}
+
+int main(int argc, char **argv)
+{
+    long iters = argc > 1 ? atol(argv[1]) : 200000;
+
+    build_legacy_page();
+    printf("page: %zu constant bytes, %zu segments, %zu slots\n",
+           index_page.size, index_page.n_parts, index_page.n_slots);
+    double old_ns = run("legacy", legacy_render, iters);
+    double new_ns = run("segment", segment_render, iters);
+    printf("speedup  %9.2fx\n", old_ns / new_ns);
+
+    state_init();
+    strcpy((char *)req_uri.uri, "/");
+    double cached_ns = run("cached", cached_render, iters);
+    printf("speedup  %9.2fx\n", old_ns / cached_ns);
+    return 0;
+}
@@ -0,0 +1,191 @@
+/* Host microbenchmark: binary control protocol against the text API
+
+   Bytes on the wire per command and CPU time per decoded command for
+   four commands, each as a text HTTP request, a text WebSocket message
+   (where there is one), a binary WebSocket message and as one of 32
+   requests in a POST /bin. HTTP heads are those a curl-like client sends
+   and the server answers; WebSocket frames count their 6 byte (masked,
+   client) and 2 byte (server) headers.
+
+   The text decode is the work the server does before a handler can act:
+   splitting the request line and headers, finding the route and parsing
+   the arguments. The binary decode is proto_decode() on a body of 32
+   requests.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#include "proto_msgs.h"
+
+#define HOST_HDR        "Host: 192.168.4.1\r\nUser-Agent: curl/8.0\r\nAccept: */*\r\n"
+#define RESP_HEAD(type, len) "HTTP/1.1 200 OK\r\nContent-Type: " type "\r\nContent-Length: " #len "\r\n\r\n"
+#define WS_CLIENT_HDR   6
+#define WS_SERVER_HDR   2
+#define BATCH           32
+
+typedef struct {
+    const char     *name;
+    const char     *http_req;
+    const char     *http_resp;
+    const char     *ws_req;     /* NULL without a text WebSocket command */
+    const char     *ws_resp;
+    proto_msg_t     bin_req;
+    uint8_t         bin_resp;   /* id of the answer */
+} command_t;
+
+static const command_t commands[] = {
+    {
+        "led on",
+        "GET /led_on HTTP/1.1\r\n" HOST_HDR "\r\n",
+        RESP_HEAD("text/html", 1) "1",
+        "on", "{\"v\":12,\"led\":1}",
+        { .id = PROTO_LED, .led = { .level = 1 } }, PROTO_STATE_ANS,
+    },
+    {
+        "state",
+        "GET /state HTTP/1.1\r\n" HOST_HDR "\r\n",
+        RESP_HEAD("application/json", 25) "{\"v\":12,\"led\":1,\"peer\":0}",
+        "state", "{\"v\":12,\"led\":1}",
+        { .id = PROTO_STATE }, PROTO_STATE_ANS,
+    },
+    {
+        "send",
+        "GET /send?dev=2 HTTP/1.1\r\n" HOST_HDR "\r\n",
+        RESP_HEAD("text/html", 1) "1",
+        "send", "{\"send\":\"1\"}",
+        { .id = PROTO_SEND, .send = { .dev = 2 } }, PROTO_SEND_ANS,
+    },
+    {
+        "pins set",
+        "PUT /pins?group=relays HTTP/1.1\r\n" HOST_HDR "Content-Length: 20\r\n\r\nvalue=0x05&mask=0x0f",
+        RESP_HEAD("application/json", 37) "{\"group\":\"relays\",\"value\":5,\"pins\":8}",
+        NULL, NULL,
+        { .id = PROTO_PINS_SET, .pins_set = { .group = 0, .value = 5, .mask = 0x0f } }, PROTO_PINS_ANS,
+    },
+};
+#define N_COMMANDS (sizeof(commands) / sizeof(commands[0]))
+
+static const char *const routes[] = {
+    "/", "/hello", "/echo", "/ctrl", "/led_on", "/led_off", "/send", "/state",
+    "/batch", "/bin", "/pins", "/metrics", "/boot", "/ws",
+};
+
+static volatile unsigned sink;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static unsigned query_value(const char *q, size_t len, const char *key)
+{
+    size_t klen = strlen(key);
+
+    for (const char *p = q; p && p < q + len; p = memchr(p, '&', q + len - p), p = p ? p + 1 : p) {
+        if (strncmp(p, key, klen) == 0 && p[klen] == '=') {
+            return strtoul(p + klen + 1, NULL, 0);
+        }
+    }
+    return 0;
+}
+
+/* Request line, headers, route and arguments of a text request */
+static unsigned text_decode(const char *req, size_t len)
+{
+    const char *end = req + len;
+    const char *uri = memchr(req, ' ', len);
+    const char *ver = memchr(uri + 1, ' ', end - uri - 1);
+    const char *query = memchr(uri, '?', ver - uri);
+    const char *path_end = query ? query : ver;
+    size_t content_len = 0;
+    unsigned v = 0;
+
+    const char *line = memchr(ver, '\n', end - ver) + 1;
+    while (line < end && *line != '\r') {
+        const char *eol = memchr(line, '\n', end - line);
+        const char *colon = memchr(line, ':', eol - line);
+        if (colon && colon - line == 14 && strncasecmp(line, "Content-Length", 14) == 0) {
+            content_len = strtoul(colon + 1, NULL, 10);
+        }
+        line = eol + 1;
+    }
+    const char *body = line + 2;
+
+    for (size_t i = 0; i < sizeof(routes) / sizeof(routes[0]); i++) {
+        if (strlen(routes[i]) == (size_t)(path_end - uri - 1) &&
+                memcmp(routes[i], uri + 1, path_end - uri - 1) == 0) {
+            v = i;
+            break;
+        }
+    }
+    if (query) {
+        v += query_value(query + 1, ver - query - 1, "dev");
+    }
+    if (content_len) {
+        v += query_value(body, content_len, "value") + query_value(body, content_len, "mask");
+    }
+    return v;
+}
+
+int main(int argc, char **argv)
+{
+    int rounds = argc > 1 ? atoi(argv[1]) : 200000;
+    uint8_t body[BATCH * PROTO_MAX_MSG];
+    size_t body_len = 0;
+    const size_t bin_http = strlen("POST /bin HTTP/1.1\r\n" HOST_HDR
+                                   "Content-Type: application/octet-stream\r\nContent-Length: 120\r\n\r\n")
+                          + strlen(RESP_HEAD("application/octet-stream", 184));
+
+    printf("bytes per command, request + answer\n");
+    printf("%-10s %10s %10s %10s %10s\n", "command", "http text", "ws text", "ws binary", "/bin x32");
+    for (size_t i = 0; i < N_COMMANDS; i++) {
+        const command_t *c = &commands[i];
+        size_t req = proto_msg_size(c->bin_req.id);
+        size_t resp = proto_msg_size(c->bin_resp);
+        char ws_text[12] = "-";
+
+        if (c->ws_req) {
+            snprintf(ws_text, sizeof(ws_text), "%zu", WS_CLIENT_HDR + strlen(c->ws_req) +
+                     WS_SERVER_HDR + strlen(c->ws_resp));
+        }
+        printf("%-10s %10zu %10s %10zu %10.1f\n", c->name,
+               strlen(c->http_req) + strlen(c->http_resp), ws_text,
+               WS_CLIENT_HDR + req + WS_SERVER_HDR + resp,
+               req + resp + (double)bin_http / BATCH);
+    }
+
+    for (int i = 0; i < BATCH; i++) {
+        body_len += proto_encode(&commands[i % N_COMMANDS].bin_req, body + body_len,
+                                 sizeof(body) - body_len);
+    }
+
+    printf("\nCPU per decoded command\n");
+    double t0 = now_ns();
+    for (int r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < N_COMMANDS; i++) {
+            sink += text_decode(commands[i].http_req, strlen(commands[i].http_req));
+        }
+    }
+    double text_ns = (now_ns() - t0) / rounds / N_COMMANDS;
+
+    t0 = now_ns();
+    for (int r = 0; r < rounds / 8; r++) {
+        proto_msg_t msg;
+        for (size_t pos = 0; pos < body_len; ) {
+            int used = proto_decode(body + pos, body_len - pos, &msg);
+            sink += msg.id;
+            pos += used;
+        }
+    }
+    double bin_ns = (now_ns() - t0) / (rounds / 8) / BATCH;
+
+    printf("text  %8.1f ns\n", text_ns);
+    printf("bin   %8.1f ns  (%.0fx)\n", bin_ns, text_ns / bin_ns);
+    return 0;
+}
@@ -0,0 +1,2 @@
+/* Host stand-in for esp_eth.h: nothing used on the host */
+#pragma once
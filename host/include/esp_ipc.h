@@ -0,0 +1,14 @@
+/* Host stand-in for esp_ipc.h: there is one address space and no cores to
+ * choose from, the function runs in the caller */
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef void (*esp_ipc_func_t)(void *arg);
+
+static inline esp_err_t esp_ipc_call_blocking(uint32_t cpu_id, esp_ipc_func_t func, void *arg)
+{
+    func(arg);
+    return ESP_OK;
+}
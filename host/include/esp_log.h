@@ -0,0 +1,39 @@
+/* Host stand-in for esp_log.h */
+#pragma once
+
+#include <stdarg.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE
+} esp_log_level_t;
+
+typedef int (*vprintf_like_t)(const char *, va_list);
+
+void esp_log_level_set(const char *tag, esp_log_level_t level);
+vprintf_like_t esp_log_set_vprintf(vprintf_like_t func);
+uint32_t esp_log_timestamp(void);
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+    __attribute__((format(printf, 3, 4)));
+int esp_log_enabled(esp_log_level_t level, const char *tag);
+
+#define LOG_FORMAT(letter, format)  #letter " (%u) %s: " format "\n"
+
+#define ESP_LOG_LEVEL(level, tag, letter, format, ...) do {             \
+        if (esp_log_enabled(level, tag)) {                              \
+            esp_log_write(level, tag, LOG_FORMAT(letter, format),       \
+                          esp_log_timestamp(), tag, ##__VA_ARGS__);     \
+        }                                                               \
+    } while (0)
+
+#define ESP_LOGE(tag, format, ...) ESP_LOG_LEVEL(ESP_LOG_ERROR,   tag, E, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) ESP_LOG_LEVEL(ESP_LOG_WARN,    tag, W, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) ESP_LOG_LEVEL(ESP_LOG_INFO,    tag, I, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) ESP_LOG_LEVEL(ESP_LOG_DEBUG,   tag, D, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) ESP_LOG_LEVEL(ESP_LOG_VERBOSE, tag, V, format, ##__VA_ARGS__)
@@ -0,0 +1,7 @@
+/* Host stand-in for esp_rom_crc.h */
+#pragma once
+
+#include <stdint.h>
+
+/* CRC-32 as in zlib; chain calls by passing the previous result */
+uint32_t esp_rom_crc32_le(uint32_t crc, uint8_t const *buf, uint32_t len);
@@ -0,0 +1,7 @@
+/* Host stand-in for esp_rom_sys.h */
+#pragma once
+
+#include <stdint.h>
+
+/* The host pretends to run at 240 MHz */
+uint32_t esp_rom_get_cpu_ticks_per_us(void);
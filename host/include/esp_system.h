@@ -0,0 +1,12 @@
+/* Host stand-in for esp_system.h */
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#define MACSTR "%02x:%02x:%02x:%02x:%02x:%02x"
+#define MAC2STR(a) (a)[0], (a)[1], (a)[2], (a)[3], (a)[4], (a)[5]
+
+uint32_t esp_get_free_heap_size(void);
+uint32_t esp_get_minimum_free_heap_size(void);
+void esp_restart(void) __attribute__((noreturn));
@@ -0,0 +1,2 @@
+/* Host stand-in for esp_tls_crypto.h: nothing used on the host */
+#pragma once
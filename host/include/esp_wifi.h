@@ -0,0 +1,82 @@
+/* Host stand-in for esp_wifi.h: the softAP is simulated, see port/wifi.c */
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_event.h"
+#include "esp_system.h"
+
+typedef enum {
+    WIFI_MODE_NULL = 0,
+    WIFI_MODE_STA,
+    WIFI_MODE_AP,
+    WIFI_MODE_APSTA,
+} wifi_mode_t;
+
+typedef enum {
+    WIFI_IF_STA = 0,
+    WIFI_IF_AP,
+} wifi_interface_t;
+
+typedef enum {
+    WIFI_AUTH_OPEN = 0,
+    WIFI_AUTH_WEP,
+    WIFI_AUTH_WPA_PSK,
+    WIFI_AUTH_WPA2_PSK,
+    WIFI_AUTH_WPA_WPA2_PSK,
+} wifi_auth_mode_t;
+
+typedef struct {
+    uint8_t ssid[32];
+    uint8_t password[64];
+    uint8_t ssid_len;
+    uint8_t channel;
+    wifi_auth_mode_t authmode;
+    uint8_t ssid_hidden;
+    uint8_t max_connection;
+    uint16_t beacon_interval;
+} wifi_ap_config_t;
+
+typedef union {
+    wifi_ap_config_t ap;
+} wifi_config_t;
+
+typedef struct {
+    int magic;
+} wifi_init_config_t;
+
+#define WIFI_INIT_CONFIG_DEFAULT() { .magic = 0x1F2F3F4F }
+
+typedef enum {
+    WIFI_EVENT_WIFI_READY = 0,
+    WIFI_EVENT_SCAN_DONE,
+    WIFI_EVENT_STA_START,
+    WIFI_EVENT_STA_STOP,
+    WIFI_EVENT_STA_CONNECTED,
+    WIFI_EVENT_STA_DISCONNECTED,
+    WIFI_EVENT_STA_AUTHMODE_CHANGE,
+    WIFI_EVENT_STA_WPS_ER_SUCCESS,
+    WIFI_EVENT_STA_WPS_ER_FAILED,
+    WIFI_EVENT_STA_WPS_ER_TIMEOUT,
+    WIFI_EVENT_STA_WPS_ER_PIN,
+    WIFI_EVENT_STA_WPS_ER_PBC_OVERLAP,
+    WIFI_EVENT_AP_START,
+    WIFI_EVENT_AP_STOP,
+    WIFI_EVENT_AP_STACONNECTED,
+    WIFI_EVENT_AP_STADISCONNECTED,
+} wifi_event_t;
+
+typedef struct {
+    uint8_t mac[6];
+    uint8_t aid;
+} wifi_event_ap_staconnected_t;
+
+typedef struct {
+    uint8_t mac[6];
+    uint8_t aid;
+} wifi_event_ap_stadisconnected_t;
+
+esp_err_t esp_wifi_init(const wifi_init_config_t *config);
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode);
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t *conf);
+esp_err_t esp_wifi_start(void);
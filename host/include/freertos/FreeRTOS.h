@@ -0,0 +1,46 @@
+/* Host stand-in for FreeRTOS.h: tasks are pthreads, see port/freertos.c */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "sdkconfig.h"
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t StackType_t;
+
+#define pdFALSE             ((BaseType_t)0)
+#define pdTRUE              ((BaseType_t)1)
+#define pdPASS              pdTRUE
+#define pdFAIL              pdFALSE
+#define errQUEUE_FULL       ((BaseType_t)0)
+
+#define portMAX_DELAY       ((TickType_t)0xffffffffUL)
+#define configTICK_RATE_HZ  CONFIG_FREERTOS_HZ
+#define portTICK_PERIOD_MS  ((TickType_t)1000 / configTICK_RATE_HZ)
+#define portTICK_RATE_MS    portTICK_PERIOD_MS
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(((TickType_t)(ms) * configTICK_RATE_HZ) / 1000))
+#define portNUM_PROCESSORS  2
+#define configMAX_PRIORITIES 25
+#define tskIDLE_PRIORITY    ((UBaseType_t)0)
+#define tskNO_AFFINITY      0x7FFFFFFF
+
+/* Critical sections are a single process wide recursive lock */
+typedef struct {
+    int unused;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED { 0 }
+
+void vPortEnterCritical(portMUX_TYPE *mux);
+void vPortExitCritical(portMUX_TYPE *mux);
+
+#define portENTER_CRITICAL(mux)         vPortEnterCritical(mux)
+#define portEXIT_CRITICAL(mux)          vPortExitCritical(mux)
+#define portENTER_CRITICAL_ISR(mux)     vPortEnterCritical(mux)
+#define portEXIT_CRITICAL_ISR(mux)      vPortExitCritical(mux)
+
+BaseType_t xPortGetCoreID(void);
@@ -0,0 +1,17 @@
+/* Host stand-in for freertos/queue.h */
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct QueueDefinition *QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize);
+void vQueueDelete(QueueHandle_t xQueue);
+BaseType_t xQueueSend(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait);
+BaseType_t xQueueSendToFront(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait);
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void *pvBuffer, TickType_t xTicksToWait);
+BaseType_t xQueueReset(QueueHandle_t xQueue);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t xQueue);
+
+#define xQueueSendToBack(q, item, ticks)    xQueueSend(q, item, ticks)
+#define xQueueSendFromISR(q, item, woken)   xQueueSend(q, item, 0)
@@ -0,0 +1,14 @@
+/* Host stand-in for freertos/semphr.h: semaphores are queues without payload */
+#pragma once
+
+#include "freertos/queue.h"
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t uxMaxCount, UBaseType_t uxInitialCount);
+
+#define xSemaphoreTake(sem, ticks)  xQueueReceive(sem, NULL, ticks)
+#define xSemaphoreGive(sem)         xQueueSend(sem, NULL, 0)
+#define vSemaphoreDelete(sem)       vQueueDelete(sem)
@@ -0,0 +1,28 @@
+/* Host stand-in for freertos/task.h */
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct tskTaskControlBlock *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pvTaskCode, const char *const pcName,
+                                   const uint32_t usStackDepth, void *const pvParameters,
+                                   UBaseType_t uxPriority, TaskHandle_t *const pvCreatedTask,
+                                   const BaseType_t xCoreID);
+
+static inline BaseType_t xTaskCreate(TaskFunction_t pvTaskCode, const char *const pcName,
+                                     const uint32_t usStackDepth, void *const pvParameters,
+                                     UBaseType_t uxPriority, TaskHandle_t *const pvCreatedTask)
+{
+    return xTaskCreatePinnedToCore(pvTaskCode, pcName, usStackDepth, pvParameters,
+                                   uxPriority, pvCreatedTask, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t xTaskToDelete);
+void vTaskDelay(const TickType_t xTicksToDelay);
+TickType_t xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+TaskHandle_t xTaskGetHandle(const char *pcNameToQuery);
+char *pcTaskGetTaskName(TaskHandle_t xTaskToQuery);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t xTask);
@@ -0,0 +1,8 @@
+/* Host stand-in for hal/cpu_hal.h */
+#pragma once
+
+#include <stdint.h>
+
+/* A 32-bit counter at esp_rom_get_cpu_ticks_per_us() ticks per microsecond,
+ * wrapping like the CCOUNT register */
+uint32_t cpu_hal_get_cycle_count(void);
@@ -0,0 +1,2 @@
+/* Host stand-in for lwip/err.h: nothing used on the host */
+#pragma once
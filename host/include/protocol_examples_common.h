@@ -0,0 +1,2 @@
+/* Host stand-in for protocol_examples_common.h: nothing used on the host */
+#pragma once
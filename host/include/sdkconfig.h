@@ -0,0 +1,43 @@
+/* Host stand-in for the generated sdkconfig.h
+ *
+ * Mirrors the values from the project sdkconfig that the sources in main/
+ * depend on. Keep in sync when adding Kconfig options.
+ */
+#pragma once
+
+#define CONFIG_IDF_TARGET "linux"
+#define CONFIG_FREERTOS_HZ 100
+#define CONFIG_LOG_DEFAULT_LEVEL 3
+#define CONFIG_HTTPD_MAX_REQ_HDR_LEN 512
+#define CONFIG_HTTPD_MAX_URI_LEN 512
+#define CONFIG_HTTPD_ERR_RESP_NO_DELAY 1
+#define CONFIG_HTTPD_PURGE_BUF_LEN 32
+#define CONFIG_HTTPD_WS_SUPPORT 1
+#define CONFIG_LWIP_MAX_SOCKETS 10
+#define CONFIG_LWIP_TCP_WND_DEFAULT 5744
+#define CONFIG_ESP_CONSOLE_UART_NUM 0
+#define CONFIG_ESP_CONSOLE_UART_BAUDRATE 115200
+
+/* main/Kconfig.projbuild */
+#define CONFIG_EXAMPLE_UART_REPLY_TIMEOUT_MS 4000
+#define CONFIG_EXAMPLE_UART_BAUD_RATE 115200
+/* CONFIG_EXAMPLE_UART2_PEER is not set */
+#define CONFIG_EXAMPLE_UART_CAPTURE_SIZE 4096
+#define CONFIG_EXAMPLE_STATE_POLL_TIMEOUT_S 25
+#define CONFIG_EXAMPLE_ARENA_BLOCK_SIZE 256
+#define CONFIG_EXAMPLE_UPLOAD_BUFFER_SIZE 5744
+#define CONFIG_EXAMPLE_UPLOAD_LOG_INTERVAL_MS 1000
+#define CONFIG_EXAMPLE_LOG_DEFER 1
+#define CONFIG_EXAMPLE_LOG_DEFER_SLOTS 32
+#define CONFIG_EXAMPLE_CONN_CLIENT_QUOTA 3
+#define CONFIG_EXAMPLE_CONN_KEEPALIVE_MAX_S 30
+#define CONFIG_EXAMPLE_CONN_KEEPALIVE_MIN_S 2
+#define CONFIG_EXAMPLE_RESP_CACHE_BUDGET 4096
+#define CONFIG_EXAMPLE_PIN_GROUP1_NAME "relays"
+#define CONFIG_EXAMPLE_PIN_GROUP1_PINS ""
+#define CONFIG_EXAMPLE_PIN_GROUP2_NAME "lamps"
+#define CONFIG_EXAMPLE_PIN_GROUP2_PINS ""
+#define CONFIG_EXAMPLE_PERSIST_DELAY_MS 2000
+#define CONFIG_EXAMPLE_PERSIST_MAX_DELAY_MS 10000
+/* CONFIG_EXAMPLE_TRACE is not set, cmake -DHOST_TRACE=ON defines it */
+#define CONFIG_EXAMPLE_SCHED_DEFAULT 1
@@ -0,0 +1,370 @@
+/* FreeRTOS stand-in: tasks are detached pthreads, queues and semaphores are
+ * mutex/condition variable rings, critical sections share one recursive lock.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+#define MAX_TASKS   32
+
+struct tskTaskControlBlock {
+    char            name[16];
+    TaskFunction_t  fn;
+    void           *arg;
+    uint32_t        stack_depth;
+    UBaseType_t     priority;
+    BaseType_t      core_id;
+    pthread_t       thread;
+    bool            used;
+};
+
+static struct tskTaskControlBlock tasks[MAX_TASKS];
+static pthread_mutex_t tasks_lock = PTHREAD_MUTEX_INITIALIZER;
+static __thread struct tskTaskControlBlock *current_task;
+static __thread BaseType_t current_core = -1;
+
+static pthread_mutex_t critical_lock;
+static pthread_once_t critical_once = PTHREAD_ONCE_INIT;
+
+static void critical_init(void)
+{
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&critical_lock, &attr);
+}
+
+void vPortEnterCritical(portMUX_TYPE *mux)
+{
+    pthread_once(&critical_once, critical_init);
+    pthread_mutex_lock(&critical_lock);
+}
+
+void vPortExitCritical(portMUX_TYPE *mux)
+{
+    pthread_mutex_unlock(&critical_lock);
+}
+
+BaseType_t xPortGetCoreID(void)
+{
+    if (current_core < 0) {
+        /* Unpinned threads get a stable pseudo core */
+        current_core = ((uintptr_t)pthread_self() >> 12) % portNUM_PROCESSORS;
+    }
+    return current_core;
+}
+
+static uint64_t now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static uint64_t start_ms;
+
+__attribute__((constructor)) static void tick_init(void)
+{
+    start_ms = now_ms();
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)((now_ms() - start_ms) * configTICK_RATE_HZ / 1000);
+}
+
+static void ticks_to_abstime(TickType_t ticks, struct timespec *ts)
+{
+    uint64_t ms = (uint64_t)ticks * 1000 / configTICK_RATE_HZ;
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    ts->tv_sec += ms / 1000;
+    ts->tv_nsec += (ms % 1000) * 1000000;
+    if (ts->tv_nsec >= 1000000000) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000;
+    }
+}
+
+void vTaskDelay(const TickType_t xTicksToDelay)
+{
+    uint64_t ms = (uint64_t)xTicksToDelay * 1000 / configTICK_RATE_HZ;
+    struct timespec ts = { .tv_sec = ms / 1000, .tv_nsec = (ms % 1000) * 1000000 };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+static void *task_main(void *arg)
+{
+    struct tskTaskControlBlock *tcb = arg;
+    current_task = tcb;
+    if (tcb->core_id == 0 || tcb->core_id == 1) {
+        current_core = tcb->core_id;
+    }
+    tcb->fn(tcb->arg);
+    /* FreeRTOS tasks must not return, but be lenient on the host */
+    vTaskDelete(NULL);
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pvTaskCode, const char *const pcName,
+                                   const uint32_t usStackDepth, void *const pvParameters,
+                                   UBaseType_t uxPriority, TaskHandle_t *const pvCreatedTask,
+                                   const BaseType_t xCoreID)
+{
+    struct tskTaskControlBlock *tcb = NULL;
+
+    pthread_mutex_lock(&tasks_lock);
+    for (int i = 0; i < MAX_TASKS; i++) {
+        if (!tasks[i].used) {
+            tcb = &tasks[i];
+            memset(tcb, 0, sizeof(*tcb));
+            tcb->used = true;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&tasks_lock);
+    if (tcb == NULL) {
+        return pdFAIL;
+    }
+
+    strncpy(tcb->name, pcName ? pcName : "", sizeof(tcb->name) - 1);
+    tcb->fn = pvTaskCode;
+    tcb->arg = pvParameters;
+    tcb->stack_depth = usStackDepth;
+    tcb->priority = uxPriority;
+    tcb->core_id = xCoreID;
+    if (pvCreatedTask) {
+        *pvCreatedTask = tcb;
+    }
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    /* Host code paths (libc, sockets) need more stack than the target */
+    pthread_attr_setstacksize(&attr, usStackDepth < 65536 ? 256 * 1024 : usStackDepth * 4);
+    int ret = pthread_create(&tcb->thread, &attr, task_main, tcb);
+    pthread_attr_destroy(&attr);
+    if (ret != 0) {
+        tcb->used = false;
+        return pdFAIL;
+    }
+    pthread_setname_np(tcb->thread, tcb->name);
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t xTaskToDelete)
+{
+    struct tskTaskControlBlock *tcb = xTaskToDelete ? xTaskToDelete : current_task;
+
+    if (tcb == NULL) {
+        pthread_exit(NULL);
+    }
+    pthread_mutex_lock(&tasks_lock);
+    tcb->used = false;
+    pthread_mutex_unlock(&tasks_lock);
+    if (tcb == current_task) {
+        pthread_exit(NULL);
+    }
+    pthread_cancel(tcb->thread);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return current_task;
+}
+
+TaskHandle_t xTaskGetHandle(const char *pcNameToQuery)
+{
+    TaskHandle_t found = NULL;
+
+    pthread_mutex_lock(&tasks_lock);
+    for (int i = 0; i < MAX_TASKS; i++) {
+        if (tasks[i].used && strcmp(tasks[i].name, pcNameToQuery) == 0) {
+            found = &tasks[i];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&tasks_lock);
+    return found;
+}
+
+char *pcTaskGetTaskName(TaskHandle_t xTaskToQuery)
+{
+    struct tskTaskControlBlock *tcb = xTaskToQuery ? xTaskToQuery : current_task;
+    return tcb ? tcb->name : "main";
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t xTask)
+{
+    /* Stack usage is not tracked on the host, report the whole stack free */
+    struct tskTaskControlBlock *tcb = xTask ? xTask : current_task;
+    return tcb ? tcb->stack_depth : 0;
+}
+
+struct QueueDefinition {
+    pthread_mutex_t lock;
+    pthread_cond_t  not_empty;
+    pthread_cond_t  not_full;
+    UBaseType_t     length;
+    UBaseType_t     item_size;
+    UBaseType_t     count;
+    UBaseType_t     head;
+    uint8_t         items[];
+};
+
+static QueueHandle_t queue_create(UBaseType_t length, UBaseType_t item_size, UBaseType_t count)
+{
+    QueueHandle_t q = calloc(1, sizeof(*q) + (size_t)length * item_size);
+    if (q == NULL) {
+        return NULL;
+    }
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->not_empty, &attr);
+    pthread_cond_init(&q->not_full, &attr);
+    pthread_condattr_destroy(&attr);
+    q->length = length;
+    q->item_size = item_size;
+    q->count = count;
+    return q;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize)
+{
+    return queue_create(uxQueueLength, uxItemSize, 0);
+}
+
+void vQueueDelete(QueueHandle_t xQueue)
+{
+    pthread_mutex_destroy(&xQueue->lock);
+    pthread_cond_destroy(&xQueue->not_empty);
+    pthread_cond_destroy(&xQueue->not_full);
+    free(xQueue);
+}
+
+static bool queue_wait(QueueHandle_t q, pthread_cond_t *cond, bool (*ready)(QueueHandle_t),
+                       TickType_t ticks)
+{
+    struct timespec abstime;
+
+    if (ticks != portMAX_DELAY) {
+        ticks_to_abstime(ticks, &abstime);
+    }
+    while (!ready(q)) {
+        if (ticks == 0) {
+            return false;
+        }
+        if (ticks == portMAX_DELAY) {
+            pthread_cond_wait(cond, &q->lock);
+        } else if (pthread_cond_timedwait(cond, &q->lock, &abstime) == ETIMEDOUT) {
+            return ready(q);
+        }
+    }
+    return true;
+}
+
+static bool queue_has_space(QueueHandle_t q)
+{
+    return q->count < q->length;
+}
+
+static bool queue_has_items(QueueHandle_t q)
+{
+    return q->count > 0;
+}
+
+static BaseType_t queue_send(QueueHandle_t q, const void *item, TickType_t ticks, bool front)
+{
+    pthread_mutex_lock(&q->lock);
+    if (!queue_wait(q, &q->not_full, queue_has_space, ticks)) {
+        pthread_mutex_unlock(&q->lock);
+        return errQUEUE_FULL;
+    }
+    if (q->item_size) {
+        UBaseType_t slot;
+        if (front) {
+            q->head = (q->head + q->length - 1) % q->length;
+            slot = q->head;
+        } else {
+            slot = (q->head + q->count) % q->length;
+        }
+        memcpy(q->items + (size_t)slot * q->item_size, item, q->item_size);
+    }
+    q->count++;
+    pthread_cond_signal(&q->not_empty);
+    pthread_mutex_unlock(&q->lock);
+    return pdTRUE;
+}
+
+BaseType_t xQueueSend(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait)
+{
+    return queue_send(xQueue, pvItemToQueue, xTicksToWait, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait)
+{
+    return queue_send(xQueue, pvItemToQueue, xTicksToWait, true);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void *pvBuffer, TickType_t xTicksToWait)
+{
+    QueueHandle_t q = xQueue;
+
+    pthread_mutex_lock(&q->lock);
+    if (!queue_wait(q, &q->not_empty, queue_has_items, xTicksToWait)) {
+        pthread_mutex_unlock(&q->lock);
+        return pdFALSE;
+    }
+    if (q->item_size) {
+        memcpy(pvBuffer, q->items + (size_t)q->head * q->item_size, q->item_size);
+        q->head = (q->head + 1) % q->length;
+    }
+    q->count--;
+    pthread_cond_signal(&q->not_full);
+    pthread_mutex_unlock(&q->lock);
+    return pdTRUE;
+}
+
+BaseType_t xQueueReset(QueueHandle_t xQueue)
+{
+    pthread_mutex_lock(&xQueue->lock);
+    xQueue->count = 0;
+    xQueue->head = 0;
+    pthread_cond_broadcast(&xQueue->not_full);
+    pthread_mutex_unlock(&xQueue->lock);
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t xQueue)
+{
+    pthread_mutex_lock(&xQueue->lock);
+    UBaseType_t n = xQueue->count;
+    pthread_mutex_unlock(&xQueue->lock);
+    return n;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return queue_create(1, 0, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return queue_create(1, 0, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t uxMaxCount, UBaseType_t uxInitialCount)
+{
+    return queue_create(uxMaxCount, 0, uxInitialCount);
+}
@@ -0,0 +1,100 @@
+/* In-memory GPIO backend: output levels are kept in one word, like the
+ * chip's out registers, and every change of an output is logged, so the
+ * board state can be followed on the console. gpio_bank_hw writes the word
+ * with a single atomic store.
+ */
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#include "driver/gpio.h"
+#include "esp_log.h"
+#include "gpio_bank.h"
+
+static const char *TAG = "gpio-mem";
+
+static _Atomic uint64_t levels;
+static gpio_mode_t modes[GPIO_NUM_MAX];
+
+static bool gpio_valid(gpio_num_t gpio_num)
+{
+    return gpio_num >= 0 && gpio_num < GPIO_NUM_MAX;
+}
+
+esp_err_t gpio_reset_pin(gpio_num_t gpio_num)
+{
+    if (!gpio_valid(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    modes[gpio_num] = GPIO_MODE_INPUT;
+    atomic_fetch_and(&levels, ~(1ULL << gpio_num));
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode)
+{
+    if (!gpio_valid(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    modes[gpio_num] = mode;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+    uint64_t bit;
+    uint64_t old;
+
+    if (!gpio_valid(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    bit = 1ULL << gpio_num;
+    old = level ? atomic_fetch_or(&levels, bit) : atomic_fetch_and(&levels, ~bit);
+    if (!(old & bit) != !level) {
+        ESP_LOGD(TAG, "GPIO%d -> %d", gpio_num, level ? 1 : 0);
+    }
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num)
+{
+    if (!gpio_valid(gpio_num)) {
+        return 0;
+    }
+    return (atomic_load(&levels) >> gpio_num) & 1;
+}
+
+static void mem_write(uint64_t mask, uint64_t value)
+{
+    uint64_t old = atomic_load(&levels);
+
+    while (!atomic_compare_exchange_weak(&levels, &old, (old & ~mask) | (value & mask))) {
+    }
+    if ((old ^ value) & mask) {
+        ESP_LOGD(TAG, "GPIO mask 0x%llx -> 0x%llx", (unsigned long long)mask,
+                 (unsigned long long)(value & mask));
+    }
+}
+
+static esp_err_t mem_configure(uint64_t mask)
+{
+    for (int i = 0; i < GPIO_NUM_MAX; i++) {
+        if (mask & (1ULL << i)) {
+            modes[i] = GPIO_MODE_INPUT_OUTPUT;
+        }
+    }
+    mem_write(mask, 0);
+    return ESP_OK;
+}
+
+static uint64_t mem_read(void)
+{
+    return atomic_load(&levels);
+}
+
+const gpio_bank_t gpio_bank_hw = {
+    .name      = "gpio-mem",
+    .configure = mem_configure,
+    .write     = mem_write,
+    .read      = mem_read,
+};
@@ -0,0 +1,19 @@
+/* Host entry point: runs app_main() and keeps the process alive for the
+ * tasks it started, like the FreeRTOS scheduler would. */
+
+#include <signal.h>
+#include <stdio.h>
+#include <unistd.h>
+
+void app_main(void);
+
+int main(void)
+{
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    signal(SIGPIPE, SIG_IGN);
+    app_main();
+    for (;;) {
+        pause();
+    }
+    return 0;
+}
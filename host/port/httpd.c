@@ -0,0 +1,1413 @@
+/* esp_http_server stand-in on POSIX sockets.
+ *
+ * Follows the ESP-IDF implementation closely enough for handler code to
+ * behave the same: one server task owns the listening socket, all sessions
+ * and the work queue; requests are parsed into a fixed size scratch buffer;
+ * headers are lost once the response has started; a handler returning an
+ * error closes the session; LRU purging closes the least recently used
+ * session when a new client arrives and all slots are taken. WebSocket
+ * sessions (CONFIG_HTTPD_WS_SUPPORT) are handshaked before the handler runs,
+ * later frames call the handler with method 0, PING and CLOSE are answered
+ * here unless the URI asks for control frames.
+ *
+ * HOST_HTTPD_PORT overrides config->server_port (port 80 needs root).
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "esp_http_server.h"
+#include "esp_log.h"
+#include "freertos/task.h"
+
+static const char *TAG = "httpd";
+
+#define HTTPD_MAX_REQ_HDRS  32
+
+struct sock_db {
+    int                 fd;
+    httpd_handle_t      handle;
+    httpd_send_func_t   send_fn;    /* NULL: the socket itself */
+    httpd_recv_func_t   recv_fn;
+    void               *ctx;
+    httpd_free_ctx_fn_t free_ctx;
+    uint64_t            lru_counter;
+    bool                ws_handshake_done;
+    bool                ws_control_frames;
+    esp_err_t         (*ws_handler)(httpd_req_t *r);
+    void               *ws_user_ctx;
+    size_t              pending_len;
+    char                pending[HTTPD_MAX_REQ_HDR_LEN];
+};
+
+struct resp_hdr {
+    const char *field;
+    const char *value;
+};
+
+struct httpd_req_aux {
+    struct sock_db *sd;
+    char            scratch[HTTPD_MAX_REQ_HDR_LEN + 1];
+    size_t          remaining_len;
+    const char     *status;
+    const char     *content_type;
+    bool            first_chunk_sent;
+    unsigned        req_hdrs_count;
+    const char     *req_hdr_field[HTTPD_MAX_REQ_HDRS];
+    const char     *req_hdr_value[HTTPD_MAX_REQ_HDRS];
+    const char     *query;
+    unsigned        resp_hdrs_count;
+    bool            ws_hdr_done;
+    bool            ws_final;
+    uint8_t         ws_type;
+    uint8_t         ws_mask[4];
+    struct resp_hdr *resp_hdrs;
+};
+
+struct httpd_work {
+    httpd_work_fn_t fn;
+    void           *arg;
+};
+
+struct httpd_data {
+    httpd_config_t          config;
+    int                     listen_fd;
+    int                     ctrl_fd[2];
+    TaskHandle_t            task;
+    volatile bool           running;
+    httpd_uri_t            *hd_calls;
+    httpd_err_handler_func_t err_handler_fns[HTTPD_ERR_CODE_MAX];
+    struct sock_db         *sd;
+    uint64_t                lru_counter;
+    httpd_req_t             hd_req;
+    struct httpd_req_aux    hd_req_aux;
+};
+
+static const char *const methods[] = {
+    [HTTP_DELETE] = "DELETE",
+    [HTTP_GET]    = "GET",
+    [HTTP_HEAD]   = "HEAD",
+    [HTTP_POST]   = "POST",
+    [HTTP_PUT]    = "PUT",
+};
+
+/* -------------------------------------------------------------------------- */
+/* Sessions                                                                   */
+/* -------------------------------------------------------------------------- */
+
+static struct sock_db *sess_get(struct httpd_data *hd, int fd)
+{
+    for (int i = 0; i < hd->config.max_open_sockets; i++) {
+        if (hd->sd[i].fd == fd) {
+            return &hd->sd[i];
+        }
+    }
+    return NULL;
+}
+
+static int sess_count(struct httpd_data *hd)
+{
+    int n = 0;
+    for (int i = 0; i < hd->config.max_open_sockets; i++) {
+        if (hd->sd[i].fd != -1) {
+            n++;
+        }
+    }
+    return n;
+}
+
+static void sess_delete(struct httpd_data *hd, struct sock_db *sd)
+{
+    if (sd->fd == -1) {
+        return;
+    }
+    ESP_LOGD(TAG, "closing session %d", sd->fd);
+    if (sd->ctx) {
+        if (sd->free_ctx) {
+            sd->free_ctx(sd->ctx);
+        } else {
+            free(sd->ctx);
+        }
+    }
+    /* The close function is responsible for closing the socket */
+    if (hd->config.close_fn) {
+        hd->config.close_fn(hd, sd->fd);
+    } else {
+        close(sd->fd);
+    }
+    sd->fd = -1;
+    sd->ctx = NULL;
+    sd->free_ctx = NULL;
+    sd->pending_len = 0;
+    sd->ws_handshake_done = false;
+    sd->ws_handler = NULL;
+    sd->send_fn = NULL;
+    sd->recv_fn = NULL;
+}
+
+static void sess_purge_lru(struct httpd_data *hd)
+{
+    struct sock_db *lru = NULL;
+    for (int i = 0; i < hd->config.max_open_sockets; i++) {
+        struct sock_db *sd = &hd->sd[i];
+        if (sd->fd != -1 && (lru == NULL || sd->lru_counter < lru->lru_counter)) {
+            lru = sd;
+        }
+    }
+    if (lru) {
+        ESP_LOGD(TAG, "purging LRU session %d", lru->fd);
+        sess_delete(hd, lru);
+    }
+}
+
+static void sess_new(struct httpd_data *hd)
+{
+    int fd = accept(hd->listen_fd, NULL, NULL);
+    if (fd < 0) {
+        return;
+    }
+    if (sess_count(hd) == hd->config.max_open_sockets) {
+        if (!hd->config.lru_purge_enable) {
+            ESP_LOGW(TAG, "no free session slot for %d", fd);
+            close(fd);
+            return;
+        }
+        sess_purge_lru(hd);
+    }
+
+    struct timeval tv = { .tv_sec = hd->config.recv_wait_timeout };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    tv.tv_sec = hd->config.send_wait_timeout;
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    struct sock_db *sd = sess_get(hd, -1);
+    sd->fd = fd;
+    sd->lru_counter = ++hd->lru_counter;
+    sd->pending_len = 0;
+    if (hd->config.open_fn && hd->config.open_fn(hd, fd) != ESP_OK) {
+        sess_delete(hd, sd);
+    }
+}
+
+static int sess_recv(struct sock_db *sd, char *buf, size_t len, bool nowait)
+{
+    if (sd->pending_len) {
+        size_t n = len < sd->pending_len ? len : sd->pending_len;
+        memcpy(buf, sd->pending, n);
+        memmove(sd->pending, sd->pending + n, sd->pending_len - n);
+        sd->pending_len -= n;
+        return n;
+    }
+    if (sd->recv_fn) {
+        return sd->recv_fn(sd->handle, sd->fd, buf, len, nowait ? MSG_DONTWAIT : 0);
+    }
+    ssize_t ret = recv(sd->fd, buf, len, nowait ? MSG_DONTWAIT : 0);
+    if (ret < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            return HTTPD_SOCK_ERR_TIMEOUT;
+        }
+        return HTTPD_SOCK_ERR_FAIL;
+    }
+    return ret;
+}
+
+static int sock_send_all(int fd, const char *buf, size_t len)
+{
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = send(fd, buf + done, len - done, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? HTTPD_SOCK_ERR_TIMEOUT
+                                                            : HTTPD_SOCK_ERR_FAIL;
+        }
+        done += n;
+    }
+    return done;
+}
+
+/* Like httpd_send_all() on the target: an override may send partially */
+static int sess_send(struct sock_db *sd, const char *buf, size_t len)
+{
+    size_t done = 0;
+
+    if (sd->send_fn == NULL) {
+        return sock_send_all(sd->fd, buf, len);
+    }
+    while (done < len) {
+        int n = sd->send_fn(sd->handle, sd->fd, buf + done, len - done, 0);
+        if (n < 0) {
+            return n;
+        }
+        done += n;
+    }
+    return done;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Requests                                                                   */
+/* -------------------------------------------------------------------------- */
+
+static const struct {
+    const char *status;
+    const char *msg;
+} err_msgs[HTTPD_ERR_CODE_MAX] = {
+    [HTTPD_500_INTERNAL_SERVER_ERROR]   = { "500 Internal Server Error", "Server has encountered an unexpected error" },
+    [HTTPD_501_METHOD_NOT_IMPLEMENTED]  = { "501 Method Not Implemented", "Request method is not supported by server" },
+    [HTTPD_505_VERSION_NOT_SUPPORTED]   = { "505 Version Not Supported", "HTTP version not supported by server" },
+    [HTTPD_400_BAD_REQUEST]             = { "400 Bad Request", "Server unable to understand request due to invalid syntax" },
+    [HTTPD_401_UNAUTHORIZED]            = { "401 Unauthorized", "Server known the client's identify and it must authenticate itself to get he requested resource" },
+    [HTTPD_403_FORBIDDEN]               = { "403 Forbidden", "Server is refusing to give requested resource to client" },
+    [HTTPD_404_NOT_FOUND]               = { "404 Not Found", "This URI does not exist" },
+    [HTTPD_405_METHOD_NOT_ALLOWED]      = { "405 Method Not Allowed", "Request method for this URI is not handled by server" },
+    [HTTPD_408_REQ_TIMEOUT]             = { "408 Request Timeout", "Server closed this connection" },
+    [HTTPD_411_LENGTH_REQUIRED]         = { "411 Length Required", "Chunked encoding not supported" },
+    [HTTPD_414_URI_TOO_LONG]            = { "414 URI Too Long", "URI is too long" },
+    [HTTPD_431_REQ_HDR_FIELDS_TOO_LARGE] = { "431 Request Header Fields Too Large", "Header fields are too long" },
+};
+
+static esp_err_t req_handle_err(httpd_req_t *req, httpd_err_code_t error)
+{
+    struct httpd_data *hd = req->handle;
+    if (hd->err_handler_fns[error]) {
+        return hd->err_handler_fns[error](req, error);
+    }
+    httpd_resp_send_err(req, error, NULL);
+    return ESP_FAIL;
+}
+
+#define HEAD_CLOSED     0
+#define HEAD_ERROR      -1      /* answer with *error, then close */
+#define HEAD_DROP       -2      /* close silently */
+
+/* Reads the request head into the scratch buffer. Returns the number of
+ * header bytes or one of the HEAD_ codes above. */
+static int req_read_head(struct sock_db *sd, char *scratch, httpd_err_code_t *error)
+{
+    size_t len = 0;
+    for (;;) {
+        int ret = sess_recv(sd, scratch + len, HTTPD_MAX_REQ_HDR_LEN - len, false);
+        if (ret == 0) {
+            *error = HTTPD_400_BAD_REQUEST;
+            return len ? HEAD_ERROR : HEAD_CLOSED;
+        }
+        if (ret < 0) {
+            *error = HTTPD_408_REQ_TIMEOUT;
+            return len ? HEAD_ERROR : HEAD_DROP;
+        }
+        len += ret;
+        scratch[len] = '\0';
+        char *end = strstr(scratch, "\r\n\r\n");
+        if (end) {
+            size_t head = end + 4 - scratch;
+            /* Keep what belongs to the body or the next request */
+            sd->pending_len = len - head;
+            memcpy(sd->pending, scratch + head, sd->pending_len);
+            scratch[head] = '\0';
+            return head;
+        }
+        if (len == HTTPD_MAX_REQ_HDR_LEN) {
+            *error = HTTPD_431_REQ_HDR_FIELDS_TOO_LARGE;
+            return HEAD_ERROR;
+        }
+    }
+}
+
+static esp_err_t req_parse(httpd_req_t *r, httpd_err_code_t *error)
+{
+    struct httpd_req_aux *ra = r->aux;
+    char *line = ra->scratch;
+    char *eol = strstr(line, "\r\n");
+    *eol = '\0';
+
+    char *sp1 = strchr(line, ' ');
+    char *sp2 = sp1 ? strchr(sp1 + 1, ' ') : NULL;
+    if (sp1 == NULL || sp2 == NULL) {
+        *error = HTTPD_400_BAD_REQUEST;
+        return ESP_FAIL;
+    }
+    *sp1 = '\0';
+    *sp2 = '\0';
+    r->method = -1;
+    for (size_t i = 0; i < sizeof(methods) / sizeof(methods[0]); i++) {
+        if (strcmp(line, methods[i]) == 0) {
+            r->method = i;
+        }
+    }
+    if (r->method < 0) {
+        *error = HTTPD_501_METHOD_NOT_IMPLEMENTED;
+        return ESP_FAIL;
+    }
+    if (strncmp(sp2 + 1, "HTTP/1.", 7) != 0) {
+        *error = HTTPD_505_VERSION_NOT_SUPPORTED;
+        return ESP_FAIL;
+    }
+    if (strlen(sp1 + 1) > HTTPD_MAX_URI_LEN) {
+        *error = HTTPD_414_URI_TOO_LONG;
+        return ESP_FAIL;
+    }
+    strcpy((char *)r->uri, sp1 + 1);
+    char *q = strchr(r->uri, '?');
+    ra->query = q ? q + 1 : NULL;
+
+    ra->req_hdrs_count = 0;
+    r->content_len = 0;
+    for (line = eol + 2; *line && strncmp(line, "\r\n", 2) != 0; line = eol + 2) {
+        eol = strstr(line, "\r\n");
+        *eol = '\0';
+        char *colon = strchr(line, ':');
+        if (colon == NULL || ra->req_hdrs_count == HTTPD_MAX_REQ_HDRS) {
+            continue;
+        }
+        *colon = '\0';
+        char *value = colon + 1;
+        while (*value == ' ' || *value == '\t') {
+            value++;
+        }
+        ra->req_hdr_field[ra->req_hdrs_count] = line;
+        ra->req_hdr_value[ra->req_hdrs_count] = value;
+        ra->req_hdrs_count++;
+        if (strcasecmp(line, "Content-Length") == 0) {
+            r->content_len = strtoul(value, NULL, 10);
+        } else if (strcasecmp(line, "Transfer-Encoding") == 0 && strcasecmp(value, "chunked") == 0) {
+            *error = HTTPD_411_LENGTH_REQUIRED;
+            return ESP_FAIL;
+        }
+    }
+    ra->remaining_len = r->content_len;
+    return ESP_OK;
+}
+
+static const httpd_uri_t *uri_find(struct httpd_data *hd, const char *uri, size_t uri_len,
+                                   int method, httpd_err_code_t *err)
+{
+    *err = HTTPD_404_NOT_FOUND;
+    for (int i = 0; i < hd->config.max_uri_handlers; i++) {
+        const httpd_uri_t *h = &hd->hd_calls[i];
+        if (h->uri == NULL) {
+            continue;
+        }
+        bool match = hd->config.uri_match_fn
+                     ? hd->config.uri_match_fn(h->uri, uri, uri_len)
+                     : (strlen(h->uri) == uri_len && strncmp(h->uri, uri, uri_len) == 0);
+        if (!match) {
+            continue;
+        }
+        if ((int)h->method == method) {
+            *err = 0;
+            return h;
+        }
+        *err = HTTPD_405_METHOD_NOT_ALLOWED;
+    }
+    return NULL;
+}
+
+static void req_init(struct httpd_data *hd, struct sock_db *sd)
+{
+    httpd_req_t *r = &hd->hd_req;
+    struct httpd_req_aux *ra = &hd->hd_req_aux;
+    struct resp_hdr *resp_hdrs = ra->resp_hdrs;
+
+    memset(r, 0, sizeof(*r));
+    memset(ra, 0, offsetof(struct httpd_req_aux, resp_hdrs));
+    ra->resp_hdrs = resp_hdrs;
+    ra->sd = sd;
+    ra->status = HTTPD_200;
+    ra->content_type = HTTPD_TYPE_TEXT;
+    r->handle = hd;
+    r->aux = ra;
+    r->sess_ctx = sd->ctx;
+    r->free_ctx = sd->free_ctx;
+}
+
+/* -------------------------------------------------------------------------- */
+/* WebSocket                                                                  */
+/* -------------------------------------------------------------------------- */
+
+#define WS_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+/* SHA-1 of a short message, only used for Sec-WebSocket-Accept */
+static void sha1(const uint8_t *msg, size_t len, uint8_t digest[20])
+{
+    uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+    uint8_t block[64];
+    uint64_t bits = (uint64_t)len * 8;
+    size_t total = (len + 8) / 64 * 64 + 64;
+
+    for (size_t off = 0; off < total; off += 64) {
+        for (size_t i = 0; i < 64; i++) {
+            size_t pos = off + i;
+            if (pos < len) {
+                block[i] = msg[pos];
+            } else if (pos == len) {
+                block[i] = 0x80;
+            } else if (pos >= total - 8) {
+                block[i] = bits >> (8 * (total - 1 - pos));
+            } else {
+                block[i] = 0;
+            }
+        }
+        uint32_t w[80];
+        for (int i = 0; i < 16; i++) {
+            w[i] = (uint32_t)block[4 * i] << 24 | block[4 * i + 1] << 16 | block[4 * i + 2] << 8 | block[4 * i + 3];
+        }
+        for (int i = 16; i < 80; i++) {
+            uint32_t x = w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16];
+            w[i] = x << 1 | x >> 31;
+        }
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; i++) {
+            uint32_t f, k;
+            if (i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            } else if (i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            } else if (i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            uint32_t t = (a << 5 | a >> 27) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = b << 30 | b >> 2;
+            b = a;
+            a = t;
+        }
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+    }
+    for (int i = 0; i < 5; i++) {
+        digest[4 * i] = h[i] >> 24;
+        digest[4 * i + 1] = h[i] >> 16;
+        digest[4 * i + 2] = h[i] >> 8;
+        digest[4 * i + 3] = h[i];
+    }
+}
+
+static void base64(const uint8_t *in, size_t len, char *out)
+{
+    static const char tbl[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t i;
+    for (i = 0; i + 2 < len; i += 3) {
+        *out++ = tbl[in[i] >> 2];
+        *out++ = tbl[(in[i] & 3) << 4 | in[i + 1] >> 4];
+        *out++ = tbl[(in[i + 1] & 15) << 2 | in[i + 2] >> 6];
+        *out++ = tbl[in[i + 2] & 63];
+    }
+    if (i < len) {
+        *out++ = tbl[in[i] >> 2];
+        if (i + 1 < len) {
+            *out++ = tbl[(in[i] & 3) << 4 | in[i + 1] >> 4];
+            *out++ = tbl[(in[i + 1] & 15) << 2];
+        } else {
+            *out++ = tbl[(in[i] & 3) << 4];
+            *out++ = '=';
+        }
+        *out++ = '=';
+    }
+    *out = '\0';
+}
+
+static const char *req_hdr(httpd_req_t *r, const char *field);
+
+static bool ws_is_upgrade(httpd_req_t *r)
+{
+    const char *upgrade = req_hdr(r, "Upgrade");
+    return r->method == HTTP_GET && upgrade && strcasecmp(upgrade, "websocket") == 0;
+}
+
+static esp_err_t ws_handshake(httpd_req_t *r)
+{
+    const char *key = req_hdr(r, "Sec-WebSocket-Key");
+    char buf[192];
+    uint8_t digest[20];
+    char accept[32];
+
+    if (key == NULL || strlen(key) > 64) {
+        httpd_resp_send_err(r, HTTPD_400_BAD_REQUEST, NULL);
+        return ESP_FAIL;
+    }
+    int n = snprintf(buf, sizeof(buf), "%s" WS_GUID, key);
+    sha1((const uint8_t *)buf, n, digest);
+    base64(digest, sizeof(digest), accept);
+    n = snprintf(buf, sizeof(buf), "HTTP/1.1 101 Switching Protocols\r\n"
+                 "Upgrade: websocket\r\nConnection: Upgrade\r\n"
+                 "Sec-WebSocket-Accept: %s\r\n\r\n", accept);
+    return httpd_send(r, buf, n) == n ? ESP_OK : ESP_FAIL;
+}
+
+static esp_err_t ws_recv_all(struct sock_db *sd, uint8_t *buf, size_t len)
+{
+    while (len > 0) {
+        int n = sess_recv(sd, (char *)buf, len, false);
+        if (n <= 0) {
+            return ESP_FAIL;
+        }
+        buf += n;
+        len -= n;
+    }
+    return ESP_OK;
+}
+
+/* Reads the rest of the frame header: length and mask */
+static esp_err_t ws_read_header(struct httpd_req_aux *ra)
+{
+    uint8_t b[8];
+
+    if (ws_recv_all(ra->sd, b, 1) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    if (!(b[0] & 0x80)) {
+        ESP_LOGW(TAG, "unmasked frame from client");
+        return ESP_FAIL;
+    }
+    uint64_t len = b[0] & 0x7f;
+    if (len == 126 || len == 127) {
+        size_t n = len == 126 ? 2 : 8;
+        if (ws_recv_all(ra->sd, b, n) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        len = 0;
+        for (size_t i = 0; i < n; i++) {
+            len = len << 8 | b[i];
+        }
+    }
+    if (ws_recv_all(ra->sd, ra->ws_mask, 4) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    ra->remaining_len = len;
+    ra->ws_hdr_done = true;
+    return ESP_OK;
+}
+
+esp_err_t httpd_ws_recv_frame(httpd_req_t *req, httpd_ws_frame_t *frame, size_t max_len)
+{
+    struct httpd_req_aux *ra = req->aux;
+
+    if (!ra->ws_hdr_done && ws_read_header(ra) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    frame->type = ra->ws_type;
+    frame->final = ra->ws_final;
+    frame->len = ra->remaining_len;
+    if (max_len == 0) {
+        return ESP_OK;
+    }
+    if (frame->len > max_len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (frame->payload == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (ws_recv_all(ra->sd, frame->payload, frame->len) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    for (size_t i = 0; i < frame->len; i++) {
+        frame->payload[i] ^= ra->ws_mask[i % 4];
+    }
+    ra->remaining_len = 0;
+    return ESP_OK;
+}
+
+esp_err_t httpd_ws_send_frame_async(httpd_handle_t hd, int fd, httpd_ws_frame_t *frame)
+{
+    struct sock_db *sd = sess_get(hd, fd);
+    uint8_t head[10];
+    size_t n = 2;
+
+    if (frame == NULL || sd == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    head[0] = ((frame->fragmented && !frame->final) ? 0 : 0x80) | frame->type;
+    if (frame->len < 126) {
+        head[1] = frame->len;
+    } else if (frame->len <= 0xffff) {
+        head[1] = 126;
+        head[2] = frame->len >> 8;
+        head[3] = frame->len;
+        n = 4;
+    } else {
+        head[1] = 127;
+        for (int i = 0; i < 8; i++) {
+            head[2 + i] = (uint64_t)frame->len >> (8 * (7 - i));
+        }
+        n = 10;
+    }
+    if (sess_send(sd, (const char *)head, n) != (int)n) {
+        return ESP_FAIL;
+    }
+    if (frame->len && sess_send(sd, (const char *)frame->payload, frame->len) != (int)frame->len) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t httpd_ws_send_frame(httpd_req_t *req, httpd_ws_frame_t *frame)
+{
+    return httpd_ws_send_frame_async(req->handle, httpd_req_to_sockfd(req), frame);
+}
+
+httpd_ws_client_info_t httpd_ws_get_fd_info(httpd_handle_t hd, int fd)
+{
+    struct sock_db *sd = sess_get(hd, fd);
+    if (sd == NULL) {
+        return HTTPD_WS_CLIENT_INVALID;
+    }
+    return sd->ws_handshake_done ? HTTPD_WS_CLIENT_WEBSOCKET : HTTPD_WS_CLIENT_HTTP;
+}
+
+/* Processes one frame on a WebSocket session. Returns ESP_FAIL if the
+ * session has to be closed. */
+static esp_err_t ws_process(struct httpd_data *hd, struct sock_db *sd)
+{
+    httpd_req_t *r = &hd->hd_req;
+    struct httpd_req_aux *ra = &hd->hd_req_aux;
+    uint8_t first;
+    esp_err_t ret = ESP_OK;
+
+    if (ws_recv_all(sd, &first, 1) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    sd->lru_counter = ++hd->lru_counter;
+    ra->ws_final = first & 0x80;
+    ra->ws_type = first & 0x0f;
+    r->user_ctx = sd->ws_user_ctx;
+
+    if (ra->ws_type >= HTTPD_WS_TYPE_CLOSE && !sd->ws_control_frames) {
+        uint8_t buf[125];
+        httpd_ws_frame_t frame = { .payload = buf };
+        if (httpd_ws_recv_frame(r, &frame, sizeof(buf)) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        if (frame.type == HTTPD_WS_TYPE_PING) {
+            frame.type = HTTPD_WS_TYPE_PONG;
+            return httpd_ws_send_frame(r, &frame);
+        }
+        if (frame.type == HTTPD_WS_TYPE_CLOSE) {
+            frame.len = 0;
+            httpd_ws_send_frame(r, &frame);
+            return ESP_FAIL;
+        }
+        return ESP_OK;
+    }
+
+    ret = sd->ws_handler(r);
+    if (ret == ESP_OK && !ra->ws_hdr_done) {
+        ret = ws_read_header(ra);
+    }
+    /* Discard whatever the handler did not read */
+    uint8_t dummy[64];
+    while (ret == ESP_OK && ra->remaining_len > 0) {
+        size_t n = ra->remaining_len < sizeof(dummy) ? ra->remaining_len : sizeof(dummy);
+        ret = ws_recv_all(sd, dummy, n);
+        ra->remaining_len -= n;
+    }
+    if (ra->ws_type == HTTPD_WS_TYPE_CLOSE) {
+        return ESP_FAIL;
+    }
+    return ret;
+}
+
+/* Processes one request on a readable session. Returns ESP_FAIL if the
+ * session has to be closed. */
+static esp_err_t req_process(struct httpd_data *hd, struct sock_db *sd)
+{
+    httpd_req_t *r = &hd->hd_req;
+    struct httpd_req_aux *ra = &hd->hd_req_aux;
+    httpd_err_code_t error = HTTPD_400_BAD_REQUEST;
+    esp_err_t ret;
+
+    req_init(hd, sd);
+    if (sd->ws_handshake_done) {
+        return ws_process(hd, sd);
+    }
+    int head = req_read_head(sd, ra->scratch, &error);
+    if (head == HEAD_CLOSED || head == HEAD_DROP) {
+        return ESP_FAIL;
+    }
+    sd->lru_counter = ++hd->lru_counter;
+    if (head == HEAD_ERROR || req_parse(r, &error) != ESP_OK) {
+        req_handle_err(r, error);
+        return ESP_FAIL;
+    }
+
+    const char *q = strchr(r->uri, '?');
+    size_t uri_len = q ? (size_t)(q - r->uri) : strlen(r->uri);
+    const httpd_uri_t *uri = uri_find(hd, r->uri, uri_len, r->method, &error);
+    if (uri == NULL) {
+        ret = req_handle_err(r, error);
+    } else if (uri->is_websocket && ws_is_upgrade(r)) {
+        if (ws_handshake(r) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        sd->ws_handshake_done = true;
+        sd->ws_handler = uri->handler;
+        sd->ws_control_frames = uri->handle_ws_control_frames;
+        sd->ws_user_ctx = uri->user_ctx;
+        r->user_ctx = uri->user_ctx;
+        ret = uri->handler(r);
+    } else {
+        r->user_ctx = uri->user_ctx;
+        ret = uri->handler(r);
+    }
+
+    /* Session context handed over by the handler */
+    if (!r->ignore_sess_ctx_changes && r->sess_ctx != sd->ctx) {
+        if (sd->ctx) {
+            if (sd->free_ctx) {
+                sd->free_ctx(sd->ctx);
+            } else {
+                free(sd->ctx);
+            }
+        }
+        sd->ctx = r->sess_ctx;
+    }
+    sd->free_ctx = r->free_ctx;
+    if (ret != ESP_OK) {
+        return ESP_FAIL;
+    }
+
+    /* Discard whatever the handler did not read */
+    char dummy[64];
+    while (ra->remaining_len > 0) {
+        int n = httpd_req_recv(r, dummy, sizeof(dummy));
+        if (n <= 0) {
+            return ESP_FAIL;
+        }
+    }
+    return ESP_OK;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Server task                                                                */
+/* -------------------------------------------------------------------------- */
+
+static void httpd_thread(void *arg)
+{
+    struct httpd_data *hd = arg;
+
+    while (hd->running) {
+        fd_set fds;
+        int maxfd = hd->listen_fd > hd->ctrl_fd[0] ? hd->listen_fd : hd->ctrl_fd[0];
+
+        FD_ZERO(&fds);
+        FD_SET(hd->listen_fd, &fds);
+        FD_SET(hd->ctrl_fd[0], &fds);
+        for (int i = 0; i < hd->config.max_open_sockets; i++) {
+            if (hd->sd[i].fd != -1) {
+                FD_SET(hd->sd[i].fd, &fds);
+                if (hd->sd[i].fd > maxfd) {
+                    maxfd = hd->sd[i].fd;
+                }
+            }
+        }
+        if (select(maxfd + 1, &fds, NULL, NULL, NULL) < 0) {
+            if (errno != EINTR && errno != EBADF) {
+                ESP_LOGE(TAG, "select failed: %s", strerror(errno));
+            }
+            continue;
+        }
+
+        if (FD_ISSET(hd->ctrl_fd[0], &fds)) {
+            struct httpd_work work;
+            if (read(hd->ctrl_fd[0], &work, sizeof(work)) == sizeof(work) && work.fn) {
+                work.fn(work.arg);
+            }
+        }
+        for (int i = 0; i < hd->config.max_open_sockets; i++) {
+            struct sock_db *sd = &hd->sd[i];
+            if (sd->fd != -1 && FD_ISSET(sd->fd, &fds)) {
+                do {
+                    if (req_process(hd, sd) != ESP_OK) {
+                        sess_delete(hd, sd);
+                        break;
+                    }
+                    /* Pipelined requests already buffered */
+                } while (sd->pending_len > 0);
+            }
+        }
+        if (FD_ISSET(hd->listen_fd, &fds)) {
+            sess_new(hd);
+        }
+    }
+
+    for (int i = 0; i < hd->config.max_open_sockets; i++) {
+        sess_delete(hd, &hd->sd[i]);
+    }
+    close(hd->listen_fd);
+    close(hd->ctrl_fd[0]);
+    close(hd->ctrl_fd[1]);
+    vTaskDelete(NULL);
+}
+
+esp_err_t httpd_start(httpd_handle_t *handle, const httpd_config_t *config)
+{
+    if (handle == NULL || config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    struct httpd_data *hd = calloc(1, sizeof(*hd));
+    if (hd == NULL) {
+        return ESP_ERR_HTTPD_ALLOC_MEM;
+    }
+    hd->config = *config;
+    const char *port = getenv("HOST_HTTPD_PORT");
+    if (port) {
+        hd->config.server_port = atoi(port);
+    }
+    hd->hd_calls = calloc(config->max_uri_handlers, sizeof(httpd_uri_t));
+    hd->sd = calloc(config->max_open_sockets, sizeof(struct sock_db));
+    hd->hd_req_aux.resp_hdrs = calloc(config->max_resp_headers, sizeof(struct resp_hdr));
+    if (!hd->hd_calls || !hd->sd || !hd->hd_req_aux.resp_hdrs) {
+        goto fail;
+    }
+    for (int i = 0; i < config->max_open_sockets; i++) {
+        hd->sd[i].fd = -1;
+        hd->sd[i].handle = hd;
+    }
+
+    hd->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    int on = 1;
+    setsockopt(hd->listen_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(hd->config.server_port),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    if (bind(hd->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0
+            || listen(hd->listen_fd, hd->config.backlog_conn) != 0) {
+        ESP_LOGE(TAG, "cannot listen on port %d: %s", hd->config.server_port, strerror(errno));
+        close(hd->listen_fd);
+        goto fail;
+    }
+    if (pipe2(hd->ctrl_fd, O_CLOEXEC) != 0) {
+        close(hd->listen_fd);
+        goto fail;
+    }
+
+    hd->running = true;
+    if (xTaskCreatePinnedToCore(httpd_thread, "httpd", hd->config.stack_size, hd,
+                                hd->config.task_priority, &hd->task,
+                                hd->config.core_id) != pdPASS) {
+        close(hd->listen_fd);
+        close(hd->ctrl_fd[0]);
+        close(hd->ctrl_fd[1]);
+        goto fail;
+    }
+    ESP_LOGI(TAG, "listening on port %d", hd->config.server_port);
+    *handle = hd;
+    return ESP_OK;
+
+fail:
+    free(hd->hd_req_aux.resp_hdrs);
+    free(hd->sd);
+    free(hd->hd_calls);
+    free(hd);
+    return ESP_ERR_HTTPD_TASK;
+}
+
+static void httpd_stop_work(void *arg)
+{
+    struct httpd_data *hd = arg;
+    hd->running = false;
+}
+
+esp_err_t httpd_stop(httpd_handle_t handle)
+{
+    /* The server task releases its sockets itself; the handle is leaked on
+     * purpose as queued work may still refer to it. */
+    return httpd_queue_work(handle, httpd_stop_work, handle);
+}
+
+esp_err_t httpd_queue_work(httpd_handle_t handle, httpd_work_fn_t work, void *arg)
+{
+    struct httpd_data *hd = handle;
+    struct httpd_work msg = { .fn = work, .arg = arg };
+
+    if (hd == NULL || work == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (write(hd->ctrl_fd[1], &msg, sizeof(msg)) != sizeof(msg)) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+void *httpd_get_global_user_ctx(httpd_handle_t handle)
+{
+    return ((struct httpd_data *)handle)->config.global_user_ctx;
+}
+
+/* -------------------------------------------------------------------------- */
+/* URI handlers                                                               */
+/* -------------------------------------------------------------------------- */
+
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t *uri_handler)
+{
+    struct httpd_data *hd = handle;
+    httpd_uri_t *slot = NULL;
+
+    for (int i = 0; i < hd->config.max_uri_handlers; i++) {
+        httpd_uri_t *h = &hd->hd_calls[i];
+        if (h->uri == NULL) {
+            if (slot == NULL) {
+                slot = h;
+            }
+        } else if (h->method == uri_handler->method && strcmp(h->uri, uri_handler->uri) == 0) {
+            ESP_LOGW(TAG, "handler %s already registered", uri_handler->uri);
+            return ESP_ERR_HTTPD_HANDLER_EXISTS;
+        }
+    }
+    if (slot == NULL) {
+        ESP_LOGW(TAG, "no slots left for registering handler");
+        return ESP_ERR_HTTPD_HANDLERS_FULL;
+    }
+    *slot = *uri_handler;
+    slot->uri = strdup(uri_handler->uri);
+    return ESP_OK;
+}
+
+esp_err_t httpd_unregister_uri_handler(httpd_handle_t handle, const char *uri, httpd_method_t method)
+{
+    struct httpd_data *hd = handle;
+    for (int i = 0; i < hd->config.max_uri_handlers; i++) {
+        httpd_uri_t *h = &hd->hd_calls[i];
+        if (h->uri && h->method == method && strcmp(h->uri, uri) == 0) {
+            free((char *)h->uri);
+            memset(h, 0, sizeof(*h));
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t httpd_unregister_uri(httpd_handle_t handle, const char *uri)
+{
+    struct httpd_data *hd = handle;
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    for (int i = 0; i < hd->config.max_uri_handlers; i++) {
+        httpd_uri_t *h = &hd->hd_calls[i];
+        if (h->uri && strcmp(h->uri, uri) == 0) {
+            free((char *)h->uri);
+            memset(h, 0, sizeof(*h));
+            ret = ESP_OK;
+        }
+    }
+    return ret;
+}
+
+esp_err_t httpd_register_err_handler(httpd_handle_t handle, httpd_err_code_t error,
+                                     httpd_err_handler_func_t handler_fn)
+{
+    struct httpd_data *hd = handle;
+    if (hd == NULL || error >= HTTPD_ERR_CODE_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    hd->err_handler_fns[error] = handler_fn;
+    return ESP_OK;
+}
+
+bool httpd_uri_match_wildcard(const char *uri_template, const char *uri_to_match, size_t match_upto)
+{
+    size_t tpl_len = strlen(uri_template);
+    size_t exact = tpl_len;
+    char last = tpl_len > 0 ? uri_template[tpl_len - 1] : 0;
+    char prevlast = tpl_len > 1 ? uri_template[tpl_len - 2] : 0;
+    bool asterisk = last == '*' || (prevlast == '*' && last == '?');
+    bool quest = last == '?' || (prevlast == '?' && last == '*');
+
+    if (asterisk) {
+        exact--;
+    }
+    if (quest) {
+        /* "/path/?" matches "/path" as well as "/path/" */
+        exact--;
+        if (match_upto == exact - 1 && strncmp(uri_template, uri_to_match, exact - 1) == 0) {
+            return true;
+        }
+    }
+    if (match_upto < exact || strncmp(uri_template, uri_to_match, exact) != 0) {
+        return false;
+    }
+    return asterisk || match_upto == exact;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Request accessors                                                          */
+/* -------------------------------------------------------------------------- */
+
+int httpd_req_recv(httpd_req_t *r, char *buf, size_t buf_len)
+{
+    struct httpd_req_aux *ra = r->aux;
+
+    if (buf_len > ra->remaining_len) {
+        buf_len = ra->remaining_len;
+    }
+    if (buf_len == 0) {
+        return 0;
+    }
+    int ret = sess_recv(ra->sd, buf, buf_len, false);
+    if (ret > 0) {
+        ra->remaining_len -= ret;
+    } else if (ret == 0) {
+        ret = HTTPD_SOCK_ERR_FAIL;
+    }
+    return ret;
+}
+
+static const char *req_hdr(httpd_req_t *r, const char *field)
+{
+    struct httpd_req_aux *ra = r->aux;
+    for (unsigned i = 0; i < ra->req_hdrs_count; i++) {
+        if (strcasecmp(ra->req_hdr_field[i], field) == 0) {
+            return ra->req_hdr_value[i];
+        }
+    }
+    return NULL;
+}
+
+size_t httpd_req_get_hdr_value_len(httpd_req_t *r, const char *field)
+{
+    const char *val = req_hdr(r, field);
+    return val ? strlen(val) : 0;
+}
+
+esp_err_t httpd_req_get_hdr_value_str(httpd_req_t *r, const char *field, char *val, size_t val_size)
+{
+    const char *v = req_hdr(r, field);
+    if (v == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (val_size == 0) {
+        return ESP_ERR_HTTPD_RESULT_TRUNC;
+    }
+    strncpy(val, v, val_size - 1);
+    val[val_size - 1] = '\0';
+    return strlen(v) >= val_size ? ESP_ERR_HTTPD_RESULT_TRUNC : ESP_OK;
+}
+
+size_t httpd_req_get_url_query_len(httpd_req_t *r)
+{
+    struct httpd_req_aux *ra = r->aux;
+    return ra->query ? strlen(ra->query) : 0;
+}
+
+esp_err_t httpd_req_get_url_query_str(httpd_req_t *r, char *buf, size_t buf_len)
+{
+    struct httpd_req_aux *ra = r->aux;
+    if (ra->query == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (buf_len == 0) {
+        return ESP_ERR_HTTPD_RESULT_TRUNC;
+    }
+    strncpy(buf, ra->query, buf_len - 1);
+    buf[buf_len - 1] = '\0';
+    return strlen(ra->query) >= buf_len ? ESP_ERR_HTTPD_RESULT_TRUNC : ESP_OK;
+}
+
+esp_err_t httpd_query_key_value(const char *qry, const char *key, char *val, size_t val_size)
+{
+    size_t key_len = strlen(key);
+    const char *p = qry;
+
+    while (p && *p) {
+        const char *end = strchr(p, '&');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        if (len > key_len && strncmp(p, key, key_len) == 0 && p[key_len] == '=') {
+            const char *v = p + key_len + 1;
+            size_t vlen = len - key_len - 1;
+            if (val_size == 0) {
+                return ESP_ERR_HTTPD_RESULT_TRUNC;
+            }
+            size_t n = vlen < val_size - 1 ? vlen : val_size - 1;
+            memcpy(val, v, n);
+            val[n] = '\0';
+            return vlen >= val_size ? ESP_ERR_HTTPD_RESULT_TRUNC : ESP_OK;
+        }
+        p = end ? end + 1 : NULL;
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+int httpd_req_to_sockfd(httpd_req_t *r)
+{
+    struct httpd_req_aux *ra = r ? r->aux : NULL;
+    return ra ? ra->sd->fd : -1;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Responses                                                                  */
+/* -------------------------------------------------------------------------- */
+
+esp_err_t httpd_resp_set_status(httpd_req_t *r, const char *status)
+{
+    ((struct httpd_req_aux *)r->aux)->status = status;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_type(httpd_req_t *r, const char *type)
+{
+    ((struct httpd_req_aux *)r->aux)->content_type = type;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_hdr(httpd_req_t *r, const char *field, const char *value)
+{
+    struct httpd_req_aux *ra = r->aux;
+    struct httpd_data *hd = r->handle;
+    if (ra->resp_hdrs_count >= hd->config.max_resp_headers) {
+        return ESP_ERR_HTTPD_RESP_HDR;
+    }
+    ra->resp_hdrs[ra->resp_hdrs_count].field = field;
+    ra->resp_hdrs[ra->resp_hdrs_count].value = value;
+    ra->resp_hdrs_count++;
+    return ESP_OK;
+}
+
+int httpd_send(httpd_req_t *r, const char *buf, size_t buf_len)
+{
+    struct httpd_req_aux *ra = r->aux;
+    return sess_send(ra->sd, buf, buf_len);
+}
+
+static esp_err_t resp_send_head(httpd_req_t *r, const char *length_hdr)
+{
+    struct httpd_req_aux *ra = r->aux;
+    char head[HTTPD_MAX_REQ_HDR_LEN];
+    int len = snprintf(head, sizeof(head), "HTTP/1.1 %s\r\nContent-Type: %s\r\n%s\r\n",
+                       ra->status, ra->content_type, length_hdr);
+
+    for (unsigned i = 0; i < ra->resp_hdrs_count && len < (int)sizeof(head); i++) {
+        len += snprintf(head + len, sizeof(head) - len, "%s: %s\r\n",
+                        ra->resp_hdrs[i].field, ra->resp_hdrs[i].value);
+    }
+    if (len + 2 >= (int)sizeof(head)) {
+        return ESP_ERR_HTTPD_RESP_HDR;
+    }
+    memcpy(head + len, "\r\n", 2);
+    len += 2;
+
+    /* The scratch buffer is reused for the response on the target, so the
+     * request headers are lost from here on */
+    ra->req_hdrs_count = 0;
+    if (httpd_send(r, head, len) != len) {
+        return ESP_ERR_HTTPD_RESP_SEND;
+    }
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, ssize_t buf_len)
+{
+    char length_hdr[32];
+    esp_err_t ret;
+
+    if (buf_len == HTTPD_RESP_USE_STRLEN) {
+        buf_len = buf ? strlen(buf) : 0;
+    }
+    snprintf(length_hdr, sizeof(length_hdr), "Content-Length: %d", (int)buf_len);
+    ret = resp_send_head(r, length_hdr);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (buf && buf_len && httpd_send(r, buf, buf_len) != buf_len) {
+        return ESP_ERR_HTTPD_RESP_SEND;
+    }
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t *r, const char *buf, ssize_t buf_len)
+{
+    struct httpd_req_aux *ra = r->aux;
+    char chunk_len[12];
+    esp_err_t ret;
+
+    if (buf_len == HTTPD_RESP_USE_STRLEN) {
+        buf_len = buf ? strlen(buf) : 0;
+    }
+    if (!ra->first_chunk_sent) {
+        ret = resp_send_head(r, "Transfer-Encoding: chunked");
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        ra->first_chunk_sent = true;
+    }
+
+    int n = snprintf(chunk_len, sizeof(chunk_len), "%x\r\n", (unsigned)buf_len);
+    if (httpd_send(r, chunk_len, n) != n) {
+        return ESP_ERR_HTTPD_RESP_SEND;
+    }
+    if (buf && buf_len && httpd_send(r, buf, buf_len) != buf_len) {
+        return ESP_ERR_HTTPD_RESP_SEND;
+    }
+    if (httpd_send(r, "\r\n", 2) != 2) {
+        return ESP_ERR_HTTPD_RESP_SEND;
+    }
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send_err(httpd_req_t *req, httpd_err_code_t error, const char *msg)
+{
+    if (error >= HTTPD_ERR_CODE_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    httpd_resp_set_status(req, err_msgs[error].status);
+    httpd_resp_set_type(req, HTTPD_TYPE_TEXT);
+    return httpd_resp_send(req, msg ? msg : err_msgs[error].msg, HTTPD_RESP_USE_STRLEN);
+}
+
+/* -------------------------------------------------------------------------- */
+/* Raw sockets and session helpers                                            */
+/* -------------------------------------------------------------------------- */
+
+int httpd_socket_send(httpd_handle_t hd, int sockfd, const char *buf, size_t buf_len, int flags)
+{
+    struct sock_db *sd = sess_get(hd, sockfd);
+    if (sd == NULL) {
+        return HTTPD_SOCK_ERR_INVALID;
+    }
+    /* Like the target, a non-blocking send is one call and may be partial */
+    if (flags & MSG_DONTWAIT) {
+        if (sd->send_fn) {
+            return sd->send_fn(sd->handle, sd->fd, buf, buf_len, flags);
+        }
+        int n = send(sd->fd, buf, buf_len, flags | MSG_NOSIGNAL);
+        if (n < 0) {
+            return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? HTTPD_SOCK_ERR_TIMEOUT
+                                                                               : HTTPD_SOCK_ERR_FAIL;
+        }
+        return n;
+    }
+    return sess_send(sd, buf, buf_len);
+}
+
+int httpd_socket_recv(httpd_handle_t hd, int sockfd, char *buf, size_t buf_len, int flags)
+{
+    struct sock_db *sd = sess_get(hd, sockfd);
+    if (sd == NULL) {
+        return HTTPD_SOCK_ERR_INVALID;
+    }
+    return sess_recv(sd, buf, buf_len, flags & MSG_DONTWAIT);
+}
+
+void *httpd_sess_get_ctx(httpd_handle_t handle, int sockfd)
+{
+    struct sock_db *sd = sess_get(handle, sockfd);
+    return sd ? sd->ctx : NULL;
+}
+
+void httpd_sess_set_ctx(httpd_handle_t handle, int sockfd, void *ctx, httpd_free_ctx_fn_t free_fn)
+{
+    struct sock_db *sd = sess_get(handle, sockfd);
+    if (sd == NULL) {
+        return;
+    }
+    if (sd->ctx && sd->ctx != ctx) {
+        if (sd->free_ctx) {
+            sd->free_ctx(sd->ctx);
+        } else {
+            free(sd->ctx);
+        }
+    }
+    sd->ctx = ctx;
+    sd->free_ctx = free_fn;
+}
+
+esp_err_t httpd_sess_set_recv_override(httpd_handle_t hd, int sockfd, httpd_recv_func_t recv_func)
+{
+    struct sock_db *sd = sess_get(hd, sockfd);
+    if (sd == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    sd->recv_fn = recv_func;
+    return ESP_OK;
+}
+
+esp_err_t httpd_sess_set_send_override(httpd_handle_t hd, int sockfd, httpd_send_func_t send_func)
+{
+    struct sock_db *sd = sess_get(hd, sockfd);
+    if (sd == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    sd->send_fn = send_func;
+    return ESP_OK;
+}
+
+struct close_work {
+    struct httpd_data *hd;
+    int fd;
+};
+
+static void sess_close_work(void *arg)
+{
+    struct close_work *w = arg;
+    struct sock_db *sd = sess_get(w->hd, w->fd);
+    if (sd) {
+        sess_delete(w->hd, sd);
+    }
+    free(w);
+}
+
+esp_err_t httpd_sess_trigger_close(httpd_handle_t handle, int sockfd)
+{
+    struct close_work *w;
+
+    if (sess_get(handle, sockfd) == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    w = malloc(sizeof(*w));
+    if (w == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    w->hd = handle;
+    w->fd = sockfd;
+    if (httpd_queue_work(handle, sess_close_work, w) != ESP_OK) {
+        free(w);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t httpd_sess_update_lru_counter(httpd_handle_t handle, int sockfd)
+{
+    struct httpd_data *hd = handle;
+    struct sock_db *sd = sess_get(hd, sockfd);
+    if (sd == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    sd->lru_counter = ++hd->lru_counter;
+    return ESP_OK;
+}
+
+esp_err_t httpd_get_client_list(httpd_handle_t handle, size_t *fds, int *client_fds)
+{
+    struct httpd_data *hd = handle;
+    size_t n = 0;
+
+    for (int i = 0; i < hd->config.max_open_sockets && n < *fds; i++) {
+        if (hd->sd[i].fd != -1) {
+            client_fds[n++] = hd->sd[i].fd;
+        }
+    }
+    *fds = n;
+    return ESP_OK;
+}
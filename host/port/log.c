@@ -0,0 +1,79 @@
+/* esp_log stand-in: same format and vprintf hook as the target */
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#define MAX_TAG_LEVELS  16
+
+static vprintf_like_t log_vprintf = vprintf;
+static esp_log_level_t default_level = CONFIG_LOG_DEFAULT_LEVEL;
+static struct {
+    char tag[16];
+    esp_log_level_t level;
+} tag_levels[MAX_TAG_LEVELS];
+static int tag_levels_count;
+static pthread_mutex_t log_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    pthread_mutex_lock(&log_lock);
+    if (strcmp(tag, "*") == 0) {
+        default_level = level;
+        tag_levels_count = 0;
+    } else {
+        int i;
+        for (i = 0; i < tag_levels_count; i++) {
+            if (strcmp(tag_levels[i].tag, tag) == 0) {
+                break;
+            }
+        }
+        if (i < MAX_TAG_LEVELS) {
+            strncpy(tag_levels[i].tag, tag, sizeof(tag_levels[i].tag) - 1);
+            tag_levels[i].level = level;
+            if (i == tag_levels_count) {
+                tag_levels_count++;
+            }
+        }
+    }
+    pthread_mutex_unlock(&log_lock);
+}
+
+int esp_log_enabled(esp_log_level_t level, const char *tag)
+{
+    esp_log_level_t limit = default_level;
+
+    for (int i = 0; i < tag_levels_count; i++) {
+        if (strcmp(tag_levels[i].tag, tag) == 0) {
+            limit = tag_levels[i].level;
+            break;
+        }
+    }
+    return level <= limit;
+}
+
+vprintf_like_t esp_log_set_vprintf(vprintf_like_t func)
+{
+    vprintf_like_t prev = log_vprintf;
+    log_vprintf = func;
+    return prev;
+}
+
+uint32_t esp_log_timestamp(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    log_vprintf(format, args);
+    va_end(args);
+    if (log_vprintf == vprintf) {
+        fflush(stdout);
+    }
+}
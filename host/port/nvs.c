@@ -0,0 +1,246 @@
+/* nvs_flash stand-in
+ *
+ * Blobs are kept in memory per namespace and key. If HOST_NVS names a file
+ * they are loaded from it by nvs_flash_init() and the file is rewritten on
+ * every change, like a set lands in flash on the target, so state survives
+ * a restart of the host build. Every set is logged at debug level to make
+ * flash writes easy to follow.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "nvs.h"
+
+static const char *TAG = "nvs";
+
+#define NVS_MAX_HANDLES     8
+
+typedef struct nvs_entry {
+    char                ns[NVS_KEY_NAME_MAX_SIZE];
+    char                key[NVS_KEY_NAME_MAX_SIZE];
+    size_t              len;
+    struct nvs_entry   *next;
+    uint8_t             data[];
+} nvs_entry_t;
+
+static pthread_mutex_t nvs_lock = PTHREAD_MUTEX_INITIALIZER;
+static nvs_entry_t *entries;
+static char handles[NVS_MAX_HANDLES][NVS_KEY_NAME_MAX_SIZE];   /* namespace, "" if free */
+
+static void nvs_clear(void)
+{
+    while (entries) {
+        nvs_entry_t *e = entries;
+        entries = e->next;
+        free(e);
+    }
+}
+
+static nvs_entry_t *nvs_find(const char *ns, const char *key)
+{
+    for (nvs_entry_t *e = entries; e; e = e->next) {
+        if (strcmp(e->ns, ns) == 0 && strcmp(e->key, key) == 0) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+/* File format: per entry namespace and key (NUL padded), a 32-bit length
+ * and the data */
+static void nvs_save(void)
+{
+    const char *path = getenv("HOST_NVS");
+    FILE *f;
+
+    if (path == NULL || (f = fopen(path, "wb")) == NULL) {
+        return;
+    }
+    for (nvs_entry_t *e = entries; e; e = e->next) {
+        uint32_t len = e->len;
+        fwrite(e->ns, sizeof(e->ns), 1, f);
+        fwrite(e->key, sizeof(e->key), 1, f);
+        fwrite(&len, sizeof(len), 1, f);
+        fwrite(e->data, 1, e->len, f);
+    }
+    fclose(f);
+}
+
+static void nvs_load(void)
+{
+    const char *path = getenv("HOST_NVS");
+    char ns[NVS_KEY_NAME_MAX_SIZE];
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    uint32_t len;
+    FILE *f;
+
+    if (path == NULL || (f = fopen(path, "rb")) == NULL) {
+        return;
+    }
+    while (fread(ns, sizeof(ns), 1, f) == 1 && fread(key, sizeof(key), 1, f) == 1 &&
+           fread(&len, sizeof(len), 1, f) == 1) {
+        nvs_entry_t *e = malloc(sizeof(nvs_entry_t) + len);
+        if (e == NULL || fread(e->data, 1, len, f) != len) {
+            free(e);
+            break;
+        }
+        memcpy(e->ns, ns, sizeof(ns));
+        memcpy(e->key, key, sizeof(key));
+        e->ns[sizeof(e->ns) - 1] = '\0';
+        e->key[sizeof(e->key) - 1] = '\0';
+        e->len = len;
+        e->next = entries;
+        entries = e;
+    }
+    fclose(f);
+    ESP_LOGI(TAG, "loaded %s", path);
+}
+
+esp_err_t nvs_flash_init(void)
+{
+    pthread_mutex_lock(&nvs_lock);
+    nvs_clear();
+    nvs_load();
+    pthread_mutex_unlock(&nvs_lock);
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void)
+{
+    pthread_mutex_lock(&nvs_lock);
+    nvs_clear();
+    nvs_save();
+    pthread_mutex_unlock(&nvs_lock);
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle)
+{
+    esp_err_t ret = ESP_ERR_NO_MEM;
+
+    if (strlen(name) >= NVS_KEY_NAME_MAX_SIZE) {
+        return ESP_ERR_NVS_KEY_TOO_LONG;
+    }
+    pthread_mutex_lock(&nvs_lock);
+    for (int i = 0; i < NVS_MAX_HANDLES; i++) {
+        if (handles[i][0] == '\0') {
+            strcpy(handles[i], name);
+            *out_handle = i + 1;
+            ret = ESP_OK;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    return ret;
+}
+
+static const char *nvs_namespace(nvs_handle_t handle)
+{
+    if (handle == 0 || handle > NVS_MAX_HANDLES || handles[handle - 1][0] == '\0') {
+        return NULL;
+    }
+    return handles[handle - 1];
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+    pthread_mutex_lock(&nvs_lock);
+    if (nvs_namespace(handle)) {
+        handles[handle - 1][0] = '\0';
+    }
+    pthread_mutex_unlock(&nvs_lock);
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    return nvs_namespace(handle) ? ESP_OK : ESP_ERR_NVS_INVALID_HANDLE;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    esp_err_t ret = ESP_OK;
+    const char *ns;
+    nvs_entry_t *e;
+
+    if (strlen(key) >= NVS_KEY_NAME_MAX_SIZE) {
+        return ESP_ERR_NVS_KEY_TOO_LONG;
+    }
+    pthread_mutex_lock(&nvs_lock);
+    if ((ns = nvs_namespace(handle)) == NULL) {
+        ret = ESP_ERR_NVS_INVALID_HANDLE;
+    } else if ((e = malloc(sizeof(nvs_entry_t) + length)) == NULL) {
+        ret = ESP_ERR_NO_MEM;
+    } else {
+        nvs_entry_t *old = nvs_find(ns, key);
+        strcpy(e->ns, ns);
+        strcpy(e->key, key);
+        e->len = length;
+        memcpy(e->data, value, length);
+        e->next = entries;
+        entries = e;
+        if (old) {
+            for (nvs_entry_t **p = &entries; *p; p = &(*p)->next) {
+                if (*p == old) {
+                    *p = old->next;
+                    break;
+                }
+            }
+            free(old);
+        }
+        nvs_save();
+        ESP_LOGD(TAG, "set %s.%s, %u bytes", ns, key, (unsigned)length);
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    return ret;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length)
+{
+    esp_err_t ret = ESP_OK;
+    const char *ns;
+    nvs_entry_t *e;
+
+    pthread_mutex_lock(&nvs_lock);
+    if ((ns = nvs_namespace(handle)) == NULL) {
+        ret = ESP_ERR_NVS_INVALID_HANDLE;
+    } else if ((e = nvs_find(ns, key)) == NULL) {
+        ret = ESP_ERR_NVS_NOT_FOUND;
+    } else if (out_value == NULL) {
+        *length = e->len;
+    } else if (*length < e->len) {
+        ret = ESP_ERR_NVS_INVALID_LENGTH;
+    } else {
+        memcpy(out_value, e->data, e->len);
+        *length = e->len;
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    return ret;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key)
+{
+    esp_err_t ret = ESP_ERR_NVS_NOT_FOUND;
+    const char *ns;
+
+    pthread_mutex_lock(&nvs_lock);
+    if ((ns = nvs_namespace(handle)) == NULL) {
+        ret = ESP_ERR_NVS_INVALID_HANDLE;
+    } else {
+        for (nvs_entry_t **p = &entries; *p; p = &(*p)->next) {
+            if (strcmp((*p)->ns, ns) == 0 && strcmp((*p)->key, key) == 0) {
+                nvs_entry_t *e = *p;
+                *p = e->next;
+                free(e);
+                nvs_save();
+                ret = ESP_OK;
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    return ret;
+}
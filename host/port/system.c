@@ -0,0 +1,283 @@
+/* esp_system / esp_err / esp_timer stand-ins */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_rom_crc.h"
+#include "esp_rom_sys.h"
+#include "hal/cpu_hal.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_http_server.h"
+#include "nvs_flash.h"
+
+/* Pretend to have the internal DRAM of an ESP32 */
+#define HOST_HEAP_SIZE  (300 * 1024)
+
+static uint32_t heap_low_water = HOST_HEAP_SIZE;
+
+uint32_t esp_get_free_heap_size(void)
+{
+    struct mallinfo2 mi = mallinfo2();
+    uint32_t used = mi.uordblks > HOST_HEAP_SIZE ? HOST_HEAP_SIZE : (uint32_t)mi.uordblks;
+    uint32_t free_size = HOST_HEAP_SIZE - used;
+    if (free_size < heap_low_water) {
+        heap_low_water = free_size;
+    }
+    return free_size;
+}
+
+uint32_t esp_get_minimum_free_heap_size(void)
+{
+    esp_get_free_heap_size();
+    return heap_low_water;
+}
+
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+    return esp_get_free_heap_size();
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps)
+{
+    return esp_get_minimum_free_heap_size();
+}
+
+/* Free chunks below the top of the malloc arena are the holes; what is left
+ * of the pretended heap beyond them is one contiguous block */
+size_t heap_caps_get_largest_free_block(uint32_t caps)
+{
+    struct mallinfo2 mi = mallinfo2();
+    size_t free_size = esp_get_free_heap_size();
+    size_t holes = mi.fordblks - mi.keepcost;
+
+    return holes < free_size ? free_size - holes : 0;
+}
+
+uint32_t esp_rom_crc32_le(uint32_t crc, uint8_t const *buf, uint32_t len)
+{
+    static uint32_t table[256];
+
+    if (table[1] == 0) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xedb88320 ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+    }
+    crc = ~crc;
+    while (len--) {
+        crc = table[(crc ^ *buf++) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+void esp_restart(void)
+{
+    exit(0);
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+    case ESP_OK:                        return "ESP_OK";
+    case ESP_FAIL:                      return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:                return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:           return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:         return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:          return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:             return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:         return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:               return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_NVS_NOT_FOUND:         return "ESP_ERR_NVS_NOT_FOUND";
+    case ESP_ERR_NVS_INVALID_HANDLE:    return "ESP_ERR_NVS_INVALID_HANDLE";
+    case ESP_ERR_NVS_KEY_TOO_LONG:      return "ESP_ERR_NVS_KEY_TOO_LONG";
+    case ESP_ERR_NVS_INVALID_LENGTH:    return "ESP_ERR_NVS_INVALID_LENGTH";
+    case ESP_ERR_HTTPD_HANDLERS_FULL:   return "ESP_ERR_HTTPD_HANDLERS_FULL";
+    case ESP_ERR_HTTPD_HANDLER_EXISTS:  return "ESP_ERR_HTTPD_HANDLER_EXISTS";
+    case ESP_ERR_HTTPD_INVALID_REQ:     return "ESP_ERR_HTTPD_INVALID_REQ";
+    case ESP_ERR_HTTPD_RESULT_TRUNC:    return "ESP_ERR_HTTPD_RESULT_TRUNC";
+    case ESP_ERR_HTTPD_RESP_HDR:        return "ESP_ERR_HTTPD_RESP_HDR";
+    case ESP_ERR_HTTPD_RESP_SEND:       return "ESP_ERR_HTTPD_RESP_SEND";
+    case ESP_ERR_HTTPD_ALLOC_MEM:       return "ESP_ERR_HTTPD_ALLOC_MEM";
+    case ESP_ERR_HTTPD_TASK:            return "ESP_ERR_HTTPD_TASK";
+    default:                            return "UNKNOWN ERROR";
+    }
+}
+
+static int64_t monotonic_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* Process start stands in for boot */
+static int64_t boot_us;
+
+__attribute__((constructor)) static void boot_time_init(void)
+{
+    boot_us = monotonic_us();
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return monotonic_us() - boot_us;
+}
+
+#define HOST_CPU_MHZ    240
+
+uint32_t esp_rom_get_cpu_ticks_per_us(void)
+{
+    return HOST_CPU_MHZ;
+}
+
+uint32_t cpu_hal_get_cycle_count(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(((uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec) * HOST_CPU_MHZ / 1000);
+}
+
+/* All timers are dispatched from one thread, like the esp_timer task */
+struct esp_timer {
+    esp_timer_create_args_t args;
+    int64_t                 alarm;      /* 0 when not armed */
+    uint64_t                period;
+    struct esp_timer       *next;
+};
+
+static pthread_mutex_t timer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t timer_cond;
+static struct esp_timer *timer_list;
+static pthread_once_t timer_once = PTHREAD_ONCE_INIT;
+
+static void *timer_task(void *arg)
+{
+    pthread_mutex_lock(&timer_lock);
+    for (;;) {
+        int64_t now = esp_timer_get_time();
+        int64_t next = 0;
+        struct esp_timer *due = NULL;
+
+        for (struct esp_timer *t = timer_list; t; t = t->next) {
+            if (t->alarm == 0) {
+                continue;
+            }
+            if (t->alarm <= now) {
+                due = t;
+                break;
+            }
+            if (next == 0 || t->alarm < next) {
+                next = t->alarm;
+            }
+        }
+        if (due) {
+            due->alarm = due->period ? now + due->period : 0;
+            esp_timer_cb_t cb = due->args.callback;
+            void *cb_arg = due->args.arg;
+            pthread_mutex_unlock(&timer_lock);
+            cb(cb_arg);
+            pthread_mutex_lock(&timer_lock);
+            continue;
+        }
+        if (next == 0) {
+            pthread_cond_wait(&timer_cond, &timer_lock);
+        } else {
+            int64_t abs_us = next + boot_us;
+            struct timespec ts = { .tv_sec = abs_us / 1000000, .tv_nsec = (abs_us % 1000000) * 1000 };
+            pthread_cond_timedwait(&timer_cond, &timer_lock, &ts);
+        }
+    }
+    return NULL;
+}
+
+static void timer_init(void)
+{
+    pthread_condattr_t attr;
+    pthread_t thread;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&timer_cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_create(&thread, NULL, timer_task, NULL);
+    pthread_setname_np(thread, "esp_timer");
+    pthread_detach(thread);
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args, esp_timer_handle_t *out_handle)
+{
+    pthread_once(&timer_once, timer_init);
+    struct esp_timer *t = calloc(1, sizeof(*t));
+    if (t == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    t->args = *create_args;
+    pthread_mutex_lock(&timer_lock);
+    t->next = timer_list;
+    timer_list = t;
+    pthread_mutex_unlock(&timer_lock);
+    *out_handle = t;
+    return ESP_OK;
+}
+
+static esp_err_t timer_arm(esp_timer_handle_t timer, uint64_t timeout_us, uint64_t period)
+{
+    pthread_mutex_lock(&timer_lock);
+    if (timer->alarm != 0) {
+        pthread_mutex_unlock(&timer_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->alarm = esp_timer_get_time() + (timeout_us ? timeout_us : 1);
+    timer->period = period;
+    pthread_cond_signal(&timer_cond);
+    pthread_mutex_unlock(&timer_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    return timer_arm(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period)
+{
+    return timer_arm(timer, period, period);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    esp_err_t err = ESP_OK;
+
+    pthread_mutex_lock(&timer_lock);
+    if (timer->alarm == 0) {
+        err = ESP_ERR_INVALID_STATE;
+    }
+    timer->alarm = 0;
+    pthread_mutex_unlock(&timer_lock);
+    return err;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    pthread_mutex_lock(&timer_lock);
+    for (struct esp_timer **p = &timer_list; *p; p = &(*p)->next) {
+        if (*p == timer) {
+            *p = timer->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&timer_lock);
+    free(timer);
+    return ESP_OK;
+}
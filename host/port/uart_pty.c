@@ -0,0 +1,349 @@
+/* UART stand-in backed by pseudo terminals.
+ *
+ * Each installed port opens a pty pair in raw mode. Bytes written with
+ * uart_write_bytes() appear on the slave side, bytes written to the slave
+ * are received into the driver ring buffer and announced on the event queue
+ * just like the ESP-IDF driver does. The slave path is logged at install; if
+ * HOST_UART_DIR is set a symlink <dir>/uart<N> is created as well.
+ *
+ * HOST_UART=null selects the null backend instead: writes are discarded and
+ * nothing is ever received.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "driver/uart.h"
+#include "esp_log.h"
+
+static const char *TAG = "uart-pty";
+
+typedef struct {
+    const char *name;
+    esp_err_t (*open)(uart_port_t port, int *master);
+    int (*write)(int master, const void *src, size_t size);
+} uart_backend_t;
+
+typedef struct {
+    bool            installed;
+    int             master;
+    int             baud_rate;
+    pthread_t       reader;
+    pthread_mutex_t lock;
+    pthread_cond_t  rx_cond;
+    uint8_t        *rx_buf;
+    size_t          rx_size;
+    size_t          rx_head;
+    size_t          rx_len;
+    QueueHandle_t   queue;
+} uart_obj_t;
+
+static uart_obj_t uarts[UART_NUM_MAX];
+static const uart_backend_t *backend;
+
+static esp_err_t pty_open(uart_port_t port, int *master)
+{
+    int fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0) {
+        ESP_LOGE(TAG, "UART%d: cannot allocate a pty: %s", port, strerror(errno));
+        if (fd >= 0) {
+            close(fd);
+        }
+        return ESP_FAIL;
+    }
+
+    /* Raw mode on the slave so frame bytes pass unchanged */
+    const char *slave = ptsname(fd);
+    int sfd = open(slave, O_RDWR | O_NOCTTY);
+    if (sfd >= 0) {
+        struct termios tio;
+        tcgetattr(sfd, &tio);
+        cfmakeraw(&tio);
+        tcsetattr(sfd, TCSANOW, &tio);
+        /* Deliberately kept open: the pty stays usable while no peer is attached */
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    const char *dir = getenv("HOST_UART_DIR");
+    if (dir) {
+        char link[256];
+        snprintf(link, sizeof(link), "%s/uart%d", dir, port);
+        unlink(link);
+        if (symlink(slave, link) != 0) {
+            ESP_LOGW(TAG, "UART%d: cannot create %s: %s", port, link, strerror(errno));
+        }
+    }
+    ESP_LOGI(TAG, "UART%d is %s", port, slave);
+    *master = fd;
+    return ESP_OK;
+}
+
+static int pty_write(int master, const void *src, size_t size)
+{
+    const uint8_t *p = src;
+    size_t done = 0;
+
+    while (done < size) {
+        ssize_t n = write(master, p + done, size - done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            /* Nobody drains the slave side: drop like a disconnected wire */
+            break;
+        }
+        done += n;
+    }
+    return (int)size;
+}
+
+static esp_err_t null_open(uart_port_t port, int *master)
+{
+    ESP_LOGI(TAG, "UART%d is the null backend", port);
+    *master = -1;
+    return ESP_OK;
+}
+
+static int null_write(int master, const void *src, size_t size)
+{
+    return (int)size;
+}
+
+static const uart_backend_t backends[] = {
+    { "pty",  pty_open,  pty_write },
+    { "null", null_open, null_write },
+};
+
+static const uart_backend_t *uart_backend(void)
+{
+    if (backend == NULL) {
+        const char *name = getenv("HOST_UART");
+        backend = &backends[0];
+        for (size_t i = 0; name && i < sizeof(backends) / sizeof(backends[0]); i++) {
+            if (strcmp(backends[i].name, name) == 0) {
+                backend = &backends[i];
+            }
+        }
+    }
+    return backend;
+}
+
+static void *uart_reader(void *arg)
+{
+    uart_obj_t *u = arg;
+    uint8_t buf[128];
+
+    for (;;) {
+        struct pollfd pfd = { .fd = u->master, .events = POLLIN };
+        if (poll(&pfd, 1, -1) < 0) {
+            continue;
+        }
+        ssize_t n = read(u->master, buf, sizeof(buf));
+        if (n <= 0) {
+            /* EIO while no peer is attached, retry later */
+            usleep(10000);
+            continue;
+        }
+
+        size_t stored = 0;
+        pthread_mutex_lock(&u->lock);
+        for (ssize_t i = 0; i < n && u->rx_len < u->rx_size; i++) {
+            u->rx_buf[(u->rx_head + u->rx_len) % u->rx_size] = buf[i];
+            u->rx_len++;
+            stored++;
+        }
+        pthread_cond_broadcast(&u->rx_cond);
+        pthread_mutex_unlock(&u->lock);
+
+        if (u->queue) {
+            uart_event_t event = {
+                .type = stored < (size_t)n ? UART_BUFFER_FULL : UART_DATA,
+                .size = stored,
+            };
+            xQueueSend(u->queue, &event, 0);
+        }
+    }
+    return NULL;
+}
+
+static uart_obj_t *uart_get(uart_port_t uart_num)
+{
+    if (uart_num < 0 || uart_num >= UART_NUM_MAX || !uarts[uart_num].installed) {
+        return NULL;
+    }
+    return &uarts[uart_num];
+}
+
+esp_err_t uart_driver_install(uart_port_t uart_num, int rx_buffer_size, int tx_buffer_size,
+                              int queue_size, QueueHandle_t *uart_queue, int intr_alloc_flags)
+{
+    if (uart_num < 0 || uart_num >= UART_NUM_MAX || rx_buffer_size <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uart_obj_t *u = &uarts[uart_num];
+    if (u->installed) {
+        return ESP_FAIL;
+    }
+    esp_err_t err = uart_backend()->open(uart_num, &u->master);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&u->lock, NULL);
+    pthread_cond_init(&u->rx_cond, &attr);
+    pthread_condattr_destroy(&attr);
+    u->rx_buf = malloc(rx_buffer_size);
+    u->rx_size = rx_buffer_size;
+    u->rx_head = 0;
+    u->rx_len = 0;
+    u->baud_rate = 115200;
+    u->queue = NULL;
+    if (queue_size > 0) {
+        u->queue = xQueueCreate(queue_size, sizeof(uart_event_t));
+        if (uart_queue) {
+            *uart_queue = u->queue;
+        }
+    }
+    u->installed = true;
+
+    if (u->master >= 0) {
+        pthread_create(&u->reader, NULL, uart_reader, u);
+        pthread_detach(u->reader);
+    }
+    return ESP_OK;
+}
+
+esp_err_t uart_driver_delete(uart_port_t uart_num)
+{
+    uart_obj_t *u = uart_get(uart_num);
+    if (u == NULL) {
+        return ESP_FAIL;
+    }
+    if (u->master >= 0) {
+        pthread_cancel(u->reader);
+        close(u->master);
+    }
+    u->installed = false;
+    return ESP_OK;
+}
+
+esp_err_t uart_param_config(uart_port_t uart_num, const uart_config_t *uart_config)
+{
+    uart_obj_t *u = uart_get(uart_num);
+    if (u) {
+        u->baud_rate = uart_config->baud_rate;
+    }
+    return ESP_OK;
+}
+
+esp_err_t uart_set_baudrate(uart_port_t uart_num, uint32_t baudrate)
+{
+    uart_obj_t *u = uart_get(uart_num);
+    if (u == NULL) {
+        return ESP_FAIL;
+    }
+    u->baud_rate = baudrate;
+    return ESP_OK;
+}
+
+esp_err_t uart_set_pin(uart_port_t uart_num, int tx_io_num, int rx_io_num, int rts_io_num, int cts_io_num)
+{
+    return ESP_OK;
+}
+
+int uart_write_bytes(uart_port_t uart_num, const void *src, size_t size)
+{
+    uart_obj_t *u = uart_get(uart_num);
+    if (u == NULL) {
+        return -1;
+    }
+    return uart_backend()->write(u->master, src, size);
+}
+
+int uart_read_bytes(uart_port_t uart_num, void *buf, uint32_t length, TickType_t ticks_to_wait)
+{
+    uart_obj_t *u = uart_get(uart_num);
+    uint8_t *p = buf;
+    uint32_t done = 0;
+    struct timespec abstime;
+
+    if (u == NULL) {
+        return -1;
+    }
+    uint64_t ms = (uint64_t)ticks_to_wait * 1000 / configTICK_RATE_HZ;
+    clock_gettime(CLOCK_MONOTONIC, &abstime);
+    abstime.tv_sec += ms / 1000;
+    abstime.tv_nsec += (ms % 1000) * 1000000;
+    if (abstime.tv_nsec >= 1000000000) {
+        abstime.tv_sec++;
+        abstime.tv_nsec -= 1000000000;
+    }
+
+    pthread_mutex_lock(&u->lock);
+    while (done < length) {
+        while (u->rx_len > 0 && done < length) {
+            p[done++] = u->rx_buf[u->rx_head];
+            u->rx_head = (u->rx_head + 1) % u->rx_size;
+            u->rx_len--;
+        }
+        if (done == length || ticks_to_wait == 0) {
+            break;
+        }
+        if (ticks_to_wait == portMAX_DELAY) {
+            pthread_cond_wait(&u->rx_cond, &u->lock);
+        } else if (pthread_cond_timedwait(&u->rx_cond, &u->lock, &abstime) == ETIMEDOUT) {
+            ticks_to_wait = 0;
+        }
+    }
+    pthread_mutex_unlock(&u->lock);
+    return (int)done;
+}
+
+esp_err_t uart_flush_input(uart_port_t uart_num)
+{
+    uart_obj_t *u = uart_get(uart_num);
+    if (u == NULL) {
+        return ESP_FAIL;
+    }
+    pthread_mutex_lock(&u->lock);
+    u->rx_head = 0;
+    u->rx_len = 0;
+    pthread_mutex_unlock(&u->lock);
+    return ESP_OK;
+}
+
+esp_err_t uart_get_buffered_data_len(uart_port_t uart_num, size_t *size)
+{
+    uart_obj_t *u = uart_get(uart_num);
+    if (u == NULL) {
+        return ESP_FAIL;
+    }
+    pthread_mutex_lock(&u->lock);
+    *size = u->rx_len;
+    pthread_mutex_unlock(&u->lock);
+    return ESP_OK;
+}
+
+esp_err_t uart_wait_tx_done(uart_port_t uart_num, TickType_t ticks_to_wait)
+{
+    uart_obj_t *u = uart_get(uart_num);
+    if (u == NULL) {
+        return ESP_FAIL;
+    }
+    if (u->master >= 0) {
+        tcdrain(u->master);
+    }
+    return ESP_OK;
+}
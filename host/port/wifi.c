@@ -0,0 +1,97 @@
+/* Wi-Fi / netif / event loop stand-ins: the host network is used as is, the
+ * softAP calls only log what would have been configured. Events posted with
+ * esp_event_post() are delivered synchronously to registered handlers.
+ */
+
+#include <string.h>
+
+#include "esp_event.h"
+#include "esp_log.h"
+#include "esp_netif.h"
+#include "esp_wifi.h"
+
+static const char *TAG = "wifi-host";
+
+#define MAX_EVENT_HANDLERS  8
+
+esp_event_base_t const WIFI_EVENT = "WIFI_EVENT";
+esp_event_base_t const IP_EVENT = "IP_EVENT";
+
+static struct {
+    esp_event_base_t    base;
+    int32_t             id;
+    esp_event_handler_t handler;
+    void               *arg;
+} handlers[MAX_EVENT_HANDLERS];
+static int handlers_count;
+
+esp_err_t esp_event_loop_create_default(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_event_handler_instance_register(esp_event_base_t event_base, int32_t event_id,
+                                              esp_event_handler_t event_handler,
+                                              void *event_handler_arg,
+                                              esp_event_handler_instance_t *instance)
+{
+    if (handlers_count == MAX_EVENT_HANDLERS) {
+        return ESP_ERR_NO_MEM;
+    }
+    handlers[handlers_count].base = event_base;
+    handlers[handlers_count].id = event_id;
+    handlers[handlers_count].handler = event_handler;
+    handlers[handlers_count].arg = event_handler_arg;
+    if (instance) {
+        *instance = &handlers[handlers_count];
+    }
+    handlers_count++;
+    return ESP_OK;
+}
+
+esp_err_t esp_event_post(esp_event_base_t event_base, int32_t event_id,
+                         const void *event_data, size_t event_data_size,
+                         TickType_t ticks_to_wait)
+{
+    for (int i = 0; i < handlers_count; i++) {
+        if (handlers[i].base == event_base
+                && (handlers[i].id == ESP_EVENT_ANY_ID || handlers[i].id == event_id)) {
+            handlers[i].handler(handlers[i].arg, event_base, event_id, (void *)event_data);
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_init(void)
+{
+    return ESP_OK;
+}
+
+esp_netif_t *esp_netif_create_default_wifi_ap(void)
+{
+    static int netif;
+    return (esp_netif_t *)&netif;
+}
+
+esp_err_t esp_wifi_init(const wifi_init_config_t *config)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t *conf)
+{
+    ESP_LOGI(TAG, "softAP stand-in: SSID %.*s, channel %d, max %d stations",
+             conf->ap.ssid_len, (const char *)conf->ap.ssid, conf->ap.channel,
+             conf->ap.max_connection);
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_start(void)
+{
+    return esp_event_post(WIFI_EVENT, WIFI_EVENT_AP_START, NULL, 0, 0);
+}
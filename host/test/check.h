@@ -0,0 +1,17 @@
+/* Check macro of the host unit tests
+
+   CHECK() reports a failed condition with its location and counts it in
+   failures; a test's main() returns non-zero if any check failed.
+*/
+#pragma once
+
+#include <stdio.h>
+
+static int failures;
+
+#define CHECK(cond) do {                                                    \
+        if (!(cond)) {                                                      \
+            printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                     \
+        }                                                                   \
+    } while (0)
@@ -0,0 +1,74 @@
+/* Host unit tests for the request arena (main/arena.c) */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "arena.h"
+#include "check.h"
+
+static void test_inline(void)
+{
+    arena_stats_t st0, st;
+    arena_t *arena = arena_create(64);
+
+    arena_get_stats(&st0);
+    CHECK(st0.sessions == 1);
+
+    char *a = arena_alloc(arena, 10);
+    char *b = arena_alloc(arena, 3);
+    CHECK(a && b);
+    CHECK(b >= a + 10);
+    CHECK(((uintptr_t)b % sizeof(void *)) == 0);
+    memset(a, 'a', 10);
+    memset(b, 'b', 3);
+    CHECK(a[9] == 'a');
+
+    arena_end(arena);
+    /* Rewound: the same memory is handed out again */
+    CHECK(arena_alloc(arena, 10) == a);
+    arena_end(arena);
+
+    arena_get_stats(&st);
+    CHECK(st.overflows == st0.overflows);
+    CHECK(st.allocs == st0.allocs + 3);
+    CHECK(st.requests == st0.requests + 2);
+    arena_destroy(arena);
+    arena_get_stats(&st);
+    CHECK(st.sessions == 0);
+}
+
+static void test_overflow(void)
+{
+    arena_stats_t st0, st;
+    arena_t *arena = arena_create(32);
+
+    arena_get_stats(&st0);
+    char *a = arena_alloc(arena, 24);
+    char *b = arena_alloc(arena, 24);   /* first overflow block, 32 bytes */
+    char *c = arena_alloc(arena, 8);    /* fits behind b */
+    char *d = arena_alloc(arena, 100);  /* oversized block of its own */
+    CHECK(a && b && c && d);
+    memset(d, 'd', 100);
+    arena_get_stats(&st);
+    CHECK(st.overflows == st0.overflows + 2);
+
+    arena_end(arena);
+    arena_get_stats(&st);
+    CHECK(st.peak >= 24 + 24 + 8 + 104);
+    /* Back to the inline block */
+    CHECK(arena_alloc(arena, 24) == a);
+    arena_destroy(arena);
+}
+
+int main(void)
+{
+    test_inline();
+    test_overflow();
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("arena: all tests passed\n");
+    return 0;
+}
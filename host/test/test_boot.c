@@ -0,0 +1,89 @@
+/* Host unit tests for the staged startup (main/boot.c) */
+
+#include <stdio.h>
+#include <esp_timer.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "boot.h"
+#include "check.h"
+#include "router.h"
+
+/* /boot is not served here */
+esp_err_t router_register_uri(httpd_handle_t server, const httpd_uri_t *uri)
+{
+    return ESP_OK;
+}
+
+static void step_slow(void)
+{
+    vTaskDelay(pdMS_TO_TICKS(100));
+}
+
+static void step_fast(void)
+{
+}
+
+enum { A, B, C, D };
+
+static void test_order(void)
+{
+    /* A and B run side by side, C after A, D after both */
+    static const boot_step_t steps[] = {
+        [A] = { "a", step_slow },
+        [B] = { "b", step_slow },
+        [C] = { "c", step_fast, BOOT_AFTER(A) },
+        [D] = { "d", step_fast, BOOT_AFTER(B) | BOOT_AFTER(C) },
+    };
+    boot_stage_t st[BOOT_MAX_STEPS];
+    int64_t start = esp_timer_get_time();
+
+    CHECK(boot_run(steps, 4) == ESP_OK);
+    CHECK(esp_timer_get_time() - start < 180000);
+    CHECK(boot_get_stages(st, BOOT_MAX_STEPS) == 4);
+    for (int i = 0; i < 4; i++) {
+        CHECK(st[i].start_us > 0 && st[i].end_us >= st[i].start_us);
+    }
+    CHECK(st[A].end_us - st[A].start_us >= 100000);
+    CHECK(st[B].start_us < st[A].end_us);
+    CHECK(st[C].start_us >= st[A].end_us);
+    CHECK(st[D].start_us >= st[B].end_us && st[D].start_us >= st[C].end_us);
+}
+
+static void test_cycle(void)
+{
+    static const boot_step_t steps[] = {
+        [A] = { "a", step_fast },
+        [B] = { "b", step_fast, BOOT_AFTER(C) },
+        [C] = { "c", step_fast, BOOT_AFTER(B) },
+    };
+    boot_stage_t st[3];
+
+    CHECK(boot_run(steps, 3) == ESP_ERR_INVALID_ARG);
+    CHECK(boot_get_stages(st, 3) == 3);
+    CHECK(st[A].end_us > 0);
+    CHECK(st[B].start_us == 0 && st[C].start_us == 0);
+}
+
+static void test_served(void)
+{
+    CHECK(boot_first_response_us() == -1);
+    boot_served();
+    int64_t first = boot_first_response_us();
+    CHECK(first > 0);
+    boot_served();
+    CHECK(boot_first_response_us() == first);
+}
+
+int main(void)
+{
+    test_order();
+    test_cycle();
+    test_served();
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("boot: all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,121 @@
+/* Host unit tests for the UART capture ring (main/capture_ring.c) */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "capture_ring.h"
+#include "check.h"
+
+#define RING_SIZE   16
+
+static uint8_t storage[RING_SIZE];
+
+static void fill(uint8_t *buf, size_t len, uint8_t first)
+{
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = first + i;
+    }
+}
+
+static void test_wrap(void)
+{
+    capture_ring_t ring;
+    uint8_t in[12];
+    const uint8_t *data;
+    uint32_t cursor = 0;
+    uint32_t skipped;
+
+    capture_ring_init(&ring, storage, RING_SIZE);
+    CHECK(capture_ring_peek(&ring, &cursor, 64, &data, &skipped) == 0);
+
+    fill(in, sizeof(in), 0);
+    capture_ring_write(&ring, in, sizeof(in));
+    CHECK(capture_ring_head(&ring) == 12 && capture_ring_tail(&ring) == 0);
+    CHECK(capture_ring_peek(&ring, &cursor, 5, &data, &skipped) == 5);
+    CHECK(data == storage && skipped == 0);
+    cursor = 10;
+
+    /* A write across the end: the span stops there, the rest follows */
+    fill(in, 8, 12);
+    capture_ring_write(&ring, in, 8);
+    CHECK(capture_ring_head(&ring) == 20 && capture_ring_tail(&ring) == 4);
+    CHECK(capture_ring_peek(&ring, &cursor, 64, &data, &skipped) == 6);
+    CHECK(data[0] == 10 && data[5] == 15);
+    cursor += 6;
+    CHECK(capture_ring_peek(&ring, &cursor, 64, &data, &skipped) == 4);
+    CHECK(data == storage && data[0] == 16 && data[3] == 19);
+    CHECK(!capture_ring_lost(&ring, cursor));
+}
+
+static void test_overrun(void)
+{
+    capture_ring_t ring;
+    uint8_t in[40];
+    const uint8_t *data;
+    uint32_t cursor = 0;
+    uint32_t skipped;
+
+    capture_ring_init(&ring, storage, RING_SIZE);
+    fill(in, 4, 0);
+    capture_ring_write(&ring, in, 4);
+    CHECK(capture_ring_peek(&ring, &cursor, 64, &data, &skipped) == 4);
+
+    /* The reader is peeking at byte 0 when the writer laps it */
+    fill(in, 14, 4);
+    capture_ring_write(&ring, in, 14);
+    CHECK(capture_ring_lost(&ring, 0));
+    CHECK(capture_ring_lost(&ring, 1));
+    CHECK(!capture_ring_lost(&ring, 2));
+
+    /* A reader too far behind moves on to the oldest byte */
+    CHECK(capture_ring_peek(&ring, &cursor, 64, &data, &skipped) == 14);
+    CHECK(skipped == 2 && cursor == 2 && data[0] == 2);
+
+    /* Only the last ring's worth of a long write is kept */
+    fill(in, sizeof(in), 100);
+    capture_ring_write(&ring, in, sizeof(in));
+    CHECK(capture_ring_head(&ring) == 18 + sizeof(in));
+    cursor = capture_ring_tail(&ring);
+    size_t n = capture_ring_peek(&ring, &cursor, 64, &data, &skipped);
+    CHECK(skipped == 0 && data[0] == 100 + sizeof(in) - RING_SIZE);
+    cursor += n;
+    n = capture_ring_peek(&ring, &cursor, 64, &data, &skipped);
+    CHECK(cursor + n == capture_ring_head(&ring) && data[n - 1] == 100 + sizeof(in) - 1);
+}
+
+static void test_counter_wrap(void)
+{
+    capture_ring_t ring;
+    uint8_t in[8];
+    const uint8_t *data;
+    uint32_t cursor = UINT32_MAX - 3;
+    uint32_t skipped;
+
+    /* Positions are free running and may wrap around 2^32 */
+    capture_ring_init(&ring, storage, RING_SIZE);
+    atomic_store(&ring.head, cursor);
+    atomic_store(&ring.claim, cursor);
+    atomic_store(&ring.full, true);
+    fill(in, sizeof(in), 0);
+    capture_ring_write(&ring, in, sizeof(in));
+    CHECK(capture_ring_head(&ring) == 4);
+    CHECK(capture_ring_peek(&ring, &cursor, 64, &data, &skipped) == 4 && skipped == 0);
+    CHECK(data[0] == 0 && data[3] == 3);
+    cursor += 4;
+    CHECK(cursor == 0);
+    CHECK(capture_ring_peek(&ring, &cursor, 64, &data, &skipped) == 4);
+    CHECK(data[0] == 4 && !capture_ring_lost(&ring, cursor));
+}
+
+int main(void)
+{
+    test_wrap();
+    test_overrun();
+    test_counter_wrap();
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("capture_ring: all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,135 @@
+/* Host unit tests for persistent settings (main/persist.c) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <nvs_flash.h>
+
+#include "check.h"
+#include "persist.h"
+
+typedef struct {
+    char    value[16];
+    char    restored[16];
+    int     restores;
+} setting_t;
+
+static size_t setting_save(void *buf, size_t size, void *arg)
+{
+    setting_t *s = arg;
+    size_t len = strlen(s->value);
+
+    memcpy(buf, s->value, len);
+    return len;
+}
+
+static void setting_restore(const void *buf, size_t len, void *arg)
+{
+    setting_t *s = arg;
+
+    memcpy(s->restored, buf, len);
+    s->restored[len] = '\0';
+    s->restores++;
+}
+
+static void test_coalesce(void)
+{
+    static setting_t a, b;
+    persist_stats_t st;
+    int id_a = persist_add("a", setting_save, setting_restore, &a);
+    int id_b = persist_add("b", setting_save, setting_restore, &b);
+
+    CHECK(id_a >= 0 && id_b >= 0 && id_a != id_b);
+    CHECK(a.restores == 0 && b.restores == 0);
+
+    /* A burst of changes to a is one write, b is written with it */
+    for (int i = 0; i < 5; i++) {
+        snprintf(a.value, sizeof(a.value), "a%d", i);
+        persist_touch(id_a);
+    }
+    strcpy(b.value, "b0");
+    persist_touch(id_b);
+    persist_flush();
+    persist_get_stats(&st);
+    CHECK(st.changes == 6);
+    CHECK(st.writes == 2);
+    CHECK(st.commits == 1);
+    CHECK(st.coalesced == 4);
+
+    /* Nothing dirty, nothing written */
+    persist_flush();
+    persist_get_stats(&st);
+    CHECK(st.writes == 2 && st.commits == 1);
+
+    /* A value that went back to what is stored is not written again */
+    strcpy(a.value, "a0");
+    persist_touch(id_a);
+    strcpy(a.value, "a4");
+    persist_touch(id_a);
+    persist_flush();
+    persist_get_stats(&st);
+    CHECK(st.writes == 2);
+    CHECK(st.unchanged == 1);
+    CHECK(st.coalesced == 5);
+}
+
+/* What a restart would find: the last written values */
+static void test_restore(void)
+{
+    static setting_t a2, b2, c;
+    persist_stats_t st;
+
+    CHECK(nvs_flash_init() == ESP_OK);
+    persist_add("a", setting_save, setting_restore, &a2);
+    persist_add("b", setting_save, setting_restore, &b2);
+    persist_add("c", setting_save, setting_restore, &c);
+    CHECK(a2.restores == 1 && strcmp(a2.restored, "a4") == 0);
+    CHECK(b2.restores == 1 && strcmp(b2.restored, "b0") == 0);
+    CHECK(c.restores == 0);
+    persist_get_stats(&st);
+    CHECK(st.restored == 2);
+}
+
+/* Without persist_flush() the writer task commits after the delay */
+static void test_deferred(void)
+{
+    static setting_t d;
+    persist_stats_t st0, st;
+    int id = persist_add("d", setting_save, setting_restore, &d);
+
+    persist_get_stats(&st0);
+    strcpy(d.value, "d0");
+    persist_touch(id);
+    persist_get_stats(&st);
+    CHECK(st.writes == st0.writes);
+    for (int i = 0; i < 400 && st.writes == st0.writes; i++) {
+        usleep(10000);
+        persist_get_stats(&st);
+    }
+    CHECK(st.writes == st0.writes + 1);
+    CHECK(st.commits == st0.commits + 1);
+}
+
+int main(void)
+{
+    char path[] = "/tmp/test_persist.XXXXXX";
+    int fd = mkstemp(path);
+
+    CHECK(fd >= 0);
+    close(fd);
+    setenv("HOST_NVS", path, 1);
+    CHECK(nvs_flash_erase() == ESP_OK);
+    CHECK(nvs_flash_init() == ESP_OK);
+    CHECK(persist_init() == ESP_OK);
+    test_coalesce();
+    test_restore();
+    test_deferred();
+    unlink(path);
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("persist: all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,134 @@
+/* Host unit tests for the GPIO output groups (main/pin_group.c) */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "check.h"
+#include "pin_group.h"
+#include "router.h"
+
+/* A bank that counts its register accesses */
+static uint64_t out;
+static uint64_t outputs;
+static int writes;
+static int reads;
+
+static esp_err_t test_configure(uint64_t mask)
+{
+    outputs |= mask;
+    out &= ~mask;
+    return ESP_OK;
+}
+
+static void test_write(uint64_t mask, uint64_t levels)
+{
+    out = (out & ~mask) | (levels & mask);
+    writes++;
+}
+
+static uint64_t test_read(void)
+{
+    reads++;
+    return out;
+}
+
+static const gpio_bank_t test_bank = {
+    .name      = "test",
+    .configure = test_configure,
+    .write     = test_write,
+    .read      = test_read,
+};
+
+/* The HTTP side is not under test */
+esp_err_t router_register_uri(httpd_handle_t server, const httpd_uri_t *uri)
+{
+    return ESP_OK;
+}
+
+static const gpio_num_t relay_pins[] = {
+    GPIO_NUM_13, GPIO_NUM_14, GPIO_NUM_18, GPIO_NUM_19, GPIO_NUM_NC
+};
+static const gpio_num_t split_pins[] = {
+    GPIO_NUM_33, GPIO_NUM_2, GPIO_NUM_NC
+};
+static const gpio_num_t shared_pins[] = {
+    GPIO_NUM_2, GPIO_NUM_NC
+};
+
+static void test_config(void)
+{
+    const pin_group_config_t bad[] = {
+        { "split",  split_pins },
+        { "shared", shared_pins },
+    };
+    const pin_group_config_t good[] = {
+        { "relays", relay_pins },
+        { "split",  split_pins },
+    };
+
+    /* No groups configured: nothing is touched */
+    out = ~0ULL;
+    CHECK(pin_group_init(&test_bank, NULL, 0) == ESP_OK);
+    CHECK(outputs == 0);
+    CHECK(out == ~0ULL);
+    CHECK(pin_group_count() == 0);
+
+    CHECK(pin_group_init(&test_bank, bad, 2) == ESP_ERR_INVALID_ARG);
+
+    out = ~0ULL;
+    CHECK(pin_group_init(&test_bank, good, 2) == ESP_OK);
+    CHECK(outputs == ((1ULL << 13) | (1ULL << 14) | (1ULL << 18) | (1ULL << 19) |
+                      (1ULL << 33) | (1ULL << 2)));
+    /* Configured pins start low, others are left alone */
+    CHECK((out & outputs) == 0);
+    CHECK(out & (1ULL << 22));
+    CHECK(pin_group_count() == 2);
+    CHECK(pin_group_find("split") == 1);
+    CHECK(pin_group_find("lamps") == -1);
+    CHECK(pin_group_pins(0) == 4);
+}
+
+static void test_set_get(void)
+{
+    int relays = pin_group_find("relays");
+    int split = pin_group_find("split");
+    uint64_t others = out & ~outputs;
+
+    writes = 0;
+    CHECK(pin_group_set(relays, 0x9, 0xf) == ESP_OK);
+    CHECK(writes == 1);
+    CHECK((out & outputs) == ((1ULL << 13) | (1ULL << 19)));
+
+    /* Only the masked pins change, all in the same write */
+    CHECK(pin_group_set(relays, 0x6, 0x3) == ESP_OK);
+    CHECK(writes == 2);
+    CHECK(pin_group_get(relays) == 0xa);
+    CHECK(pin_group_set(split, 0x3, 0x3) == ESP_OK);
+    CHECK(writes == 3);
+    CHECK(out & (1ULL << 33));
+    CHECK(out & (1ULL << 2));
+    CHECK(pin_group_get(relays) == 0xa);
+
+    /* One bank read per get */
+    reads = 0;
+    CHECK(pin_group_get(split) == 0x3);
+    CHECK(reads == 1);
+
+    /* Bits beyond the group and unknown groups are refused without a write */
+    CHECK(pin_group_set(relays, 0, 0x10) == ESP_ERR_INVALID_ARG);
+    CHECK(pin_group_set(5, 0, 1) == ESP_ERR_INVALID_ARG);
+    CHECK(writes == 3);
+    CHECK((out & ~outputs) == others);
+}
+
+int main(void)
+{
+    test_config();
+    test_set_get();
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("pin_group: all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,91 @@
+/* Host unit tests for the generated binary protocol codec (proto.schema) */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "check.h"
+#include "proto_msgs.h"
+
+static void test_layout(void)
+{
+    static const uint8_t want[] = { PROTO_PINS_SET, 1, 0x78, 0x56, 0x34, 0x12, 0x0f, 0, 0, 0 };
+    const proto_msg_t msg = {
+        .id = PROTO_PINS_SET,
+        .pins_set = { .group = 1, .value = 0x12345678, .mask = 0x0f },
+    };
+    uint8_t buf[PROTO_MAX_MSG];
+
+    /* Id, then the fields in schema order, little endian */
+    CHECK(proto_encode(&msg, buf, sizeof(buf)) == sizeof(want));
+    CHECK(memcmp(buf, want, sizeof(want)) == 0);
+    CHECK(proto_msg_size(PROTO_LED) == 2);
+    CHECK(proto_msg_size(PROTO_STATE) == 1);
+    CHECK(proto_msg_size(PROTO_STATE_ANS) == 7);
+    CHECK(proto_msg_size(0x7f) == 0);
+    CHECK(strcmp(proto_msg_name(PROTO_SEND_ANS), "send_ans") == 0);
+    CHECK(proto_msg_name(0x7f) == NULL);
+    /* Enum values are wire numbers, not the /send characters */
+    CHECK(PROTO_ANSWER_OFF == 0 && PROTO_ANSWER_ON == 1 && PROTO_ANSWER_NO_REPLY == 2);
+    CHECK(PROTO_ANSWER_BAD_REPLY == 3 && PROTO_ANSWER_BUSY == 4);
+}
+
+static void test_roundtrip(void)
+{
+    const proto_msg_t msgs[] = {
+        { .id = PROTO_LED, .led = { .level = 1 } },
+        { .id = PROTO_STATE },
+        { .id = PROTO_PEER, .peer = { .dev = 2, .level = 1 } },
+        { .id = PROTO_STATE_ANS, .state_ans = { .version = 0xdeadbeef, .led = 1, .peer = 0 } },
+        { .id = PROTO_ERROR, .error = { .id = 0x42, .code = 3 } },
+    };
+    uint8_t buf[64];
+    size_t len = 0;
+    proto_msg_t out;
+
+    for (size_t i = 0; i < sizeof(msgs) / sizeof(msgs[0]); i++) {
+        len += proto_encode(&msgs[i], buf + len, sizeof(buf) - len);
+    }
+    CHECK(len == 2 + 1 + 3 + 7 + 3);
+
+    /* A stream of messages decodes back one by one */
+    size_t pos = 0;
+    for (size_t i = 0; i < sizeof(msgs) / sizeof(msgs[0]); i++) {
+        int used = proto_decode(buf + pos, len - pos, &out);
+        CHECK(used == (int)proto_msg_size(msgs[i].id));
+        CHECK(out.id == msgs[i].id);
+        pos += used;
+    }
+    CHECK(pos == len);
+
+    proto_decode(buf + 6, len - 6, &out);
+    CHECK(out.state_ans.version == 0xdeadbeef && out.state_ans.led == 1);
+}
+
+static void test_errors(void)
+{
+    const uint8_t truncated[] = { PROTO_PINS_SET, 1, 2, 3 };
+    const uint8_t unknown[] = { 0x7f, 0 };
+    const proto_msg_t big = { .id = PROTO_PINS_SET };
+    const proto_msg_t bad = { .id = 0x7f };
+    uint8_t buf[4];
+    proto_msg_t out;
+
+    CHECK(proto_decode(truncated, sizeof(truncated), &out) == 0);
+    CHECK(proto_decode(truncated, 0, &out) == 0);
+    CHECK(proto_decode(unknown, sizeof(unknown), &out) == -1);
+    CHECK(proto_encode(&big, buf, sizeof(buf)) == 0);
+    CHECK(proto_encode(&bad, buf, sizeof(buf)) == 0);
+}
+
+int main(void)
+{
+    test_layout();
+    test_roundtrip();
+    test_errors();
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("proto: all tests passed\n");
+    return 0;
+}
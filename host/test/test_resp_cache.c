@@ -0,0 +1,157 @@
+/* Host unit tests for the response cache (main/resp_cache.c) */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "check.h"
+#include "resp_cache.h"
+#include "state.h"
+
+/* What the last response would have put on the wire */
+static char sent[4096];
+static size_t sent_len;
+static const char *sent_type;
+static int sent_hdrs;
+
+esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, ssize_t buf_len)
+{
+    memcpy(sent, buf, buf_len);
+    sent_len = buf_len;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_type(httpd_req_t *r, const char *type)
+{
+    sent_type = type;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_hdr(httpd_req_t *r, const char *field, const char *value)
+{
+    sent_hdrs++;
+    return ESP_OK;
+}
+
+static httpd_req_t *request(const char *uri)
+{
+    static httpd_req_t req;
+
+    memset(&req, 0, sizeof(req));
+    strcpy((char *)req.uri, uri);
+    sent_len = 0;
+    sent_type = NULL;
+    sent_hdrs = 0;
+    return &req;
+}
+
+static void test_hit_and_invalidate(void)
+{
+    static const char *const hdrs[] = { "A", "1", "B", "2", NULL };
+    resp_cache_stats_t st0, st;
+    uint32_t v = state_version();
+
+    resp_cache_get_stats(&st0);
+    CHECK(resp_cache_send(request("/hello")) == ESP_ERR_NOT_FOUND);
+    CHECK(resp_cache_answer(request("/hello"), v, 0, "text/plain", hdrs, "hi", 2) == ESP_OK);
+    CHECK(sent_len == 2 && memcmp(sent, "hi", 2) == 0);
+
+    CHECK(resp_cache_send(request("/hello")) == ESP_OK);
+    CHECK(sent_len == 2 && memcmp(sent, "hi", 2) == 0);
+    CHECK(sent_type && strcmp(sent_type, "text/plain") == 0);
+    CHECK(sent_hdrs == 2);
+    /* Other routes and requests with a query are separate */
+    CHECK(resp_cache_send(request("/hello2")) == ESP_ERR_NOT_FOUND);
+    CHECK(resp_cache_send(request("/hello?x=1")) == ESP_ERR_NOT_FOUND);
+
+    resp_cache_get_stats(&st);
+    CHECK(st.hits == st0.hits + 1);
+    CHECK(st.misses == st0.misses + 2);
+    CHECK(st.bypassed == st0.bypassed + 1);
+    CHECK(st.entries == st0.entries + 1);
+
+    /* A state change makes it stale */
+    state_set_led(!0);
+    CHECK(state_version() != v);
+    CHECK(resp_cache_send(request("/hello")) == ESP_ERR_NOT_FOUND);
+    resp_cache_get_stats(&st);
+    CHECK(st.stale == st0.stale + 1);
+    CHECK(st.entries == st0.entries);
+}
+
+static void test_ttl(void)
+{
+    uint32_t v = state_version();
+
+    resp_cache_answer(request("/"), v, 20, "text/html", NULL, "page", 4);
+    CHECK(resp_cache_send(request("/")) == ESP_OK);
+    usleep(30000);
+    CHECK(resp_cache_send(request("/")) == ESP_ERR_NOT_FOUND);
+}
+
+static void test_budget(void)
+{
+    static char body[1000];
+    resp_cache_stats_t st0, st;
+    uint32_t v = state_version();
+    char uri[8];
+
+    memset(body, 'x', sizeof(body));
+    resp_cache_get_stats(&st0);
+    for (int i = 0; i < 3; i++) {
+        snprintf(uri, sizeof(uri), "/b%d", i);
+        resp_cache_answer(request(uri), v, 0, "text/plain", NULL, body, sizeof(body));
+    }
+    /* /b0 is used last, so /b1 goes first */
+    CHECK(resp_cache_send(request("/b0")) == ESP_OK);
+    resp_cache_answer(request("/b3"), v, 0, "text/plain", NULL, body, sizeof(body));
+    resp_cache_get_stats(&st);
+    CHECK(st.bytes <= CONFIG_EXAMPLE_RESP_CACHE_BUDGET);
+    CHECK(st.evicted == st0.evicted + 1);
+    CHECK(resp_cache_send(request("/b1")) == ESP_ERR_NOT_FOUND);
+    CHECK(resp_cache_send(request("/b0")) == ESP_OK);
+    CHECK(resp_cache_send(request("/b3")) == ESP_OK);
+
+    /* Too large for the whole budget: answered, not kept */
+    static char big[CONFIG_EXAMPLE_RESP_CACHE_BUDGET];
+    CHECK(resp_cache_answer(request("/big"), v, 0, "text/plain", NULL, big, sizeof(big)) == ESP_OK);
+    CHECK(sent_len == sizeof(big));
+    CHECK(resp_cache_send(request("/big")) == ESP_ERR_NOT_FOUND);
+    resp_cache_get_stats(&st);
+    CHECK(st.too_large == st0.too_large + 1);
+}
+
+static void test_reserve(void)
+{
+    uint32_t v = state_version();
+    char *body;
+
+    /* Rendered in place, kept and sent from the entry */
+    body = resp_cache_reserve(request("/page"), v, 0, "text/html", NULL, 5);
+    CHECK(body != NULL);
+    memcpy(body, "hello", 5);
+    CHECK(body[5] == '\0');
+    CHECK(resp_cache_commit(request("/page")) == ESP_OK);
+    CHECK(sent_len == 5 && memcmp(sent, "hello", 5) == 0);
+    CHECK(resp_cache_send(request("/page")) == ESP_OK && sent_len == 5);
+
+    /* Left to the handler: query strings and answers over the budget */
+    CHECK(resp_cache_reserve(request("/page?x=1"), v, 0, "text/html", NULL, 5) == NULL);
+    CHECK(resp_cache_reserve(request("/page"), v, 0, "text/html", NULL,
+                             CONFIG_EXAMPLE_RESP_CACHE_BUDGET) == NULL);
+}
+
+int main(void)
+{
+    state_init();
+    test_hit_and_invalidate();
+    test_ttl();
+    test_budget();
+    test_reserve();
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("resp_cache: all tests passed\n");
+    return 0;
+}
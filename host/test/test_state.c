@@ -0,0 +1,138 @@
+/* Host unit tests for the device state store (main/state.c) */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "check.h"
+#include "state.h"
+
+#define WRITES_PER_WRITER   20000
+#define WRITERS             2
+#define READERS             3
+
+static uint32_t seen[8];
+static int n_seen;
+
+static void record(const device_state_t *state, void *arg)
+{
+    if (n_seen < 8) {
+        seen[n_seen] = state->version;
+    }
+    n_seen++;
+}
+
+/* Writers keep led == peer_led in every published state */
+static void flip_both(device_state_t *state, void *arg)
+{
+    state->led = !state->led;
+    state->peer_led = state->led;
+}
+
+static void no_change(device_state_t *state, void *arg)
+{
+}
+
+static void test_versions(void)
+{
+    device_state_t s;
+
+    state_get(&s);
+    uint32_t v0 = s.version;
+    CHECK(v0 == state_version());
+    CHECK(state_listen(record, NULL) == ESP_OK);
+
+    CHECK(state_set_led(!s.led) == v0 + 1);
+    /* same value again: nothing published */
+    CHECK(state_set_led(!s.led) == v0 + 1);
+    CHECK(state_update(no_change, NULL, &s) == v0 + 1);
+    CHECK(s.version == v0 + 1);
+    CHECK(state_update(flip_both, NULL, &s) == v0 + 2);
+    CHECK(s.led == s.peer_led);
+    CHECK(n_seen == 2 && seen[0] == v0 + 1 && seen[1] == v0 + 2);
+}
+
+static volatile int stop;
+static uint32_t listener_last;
+static int listener_out_of_order;
+
+static void ordered(const device_state_t *state, void *arg)
+{
+    if (state->version != listener_last + 1 && listener_last != 0) {
+        listener_out_of_order++;
+    }
+    listener_last = state->version;
+}
+
+static void *writer(void *arg)
+{
+    for (int i = 0; i < WRITES_PER_WRITER; i++) {
+        state_update(flip_both, NULL, NULL);
+    }
+    return NULL;
+}
+
+static void *reader(void *arg)
+{
+    long *torn = arg;
+    uint32_t last = 0;
+    device_state_t s;
+
+    while (!stop) {
+        state_get(&s);
+        if (s.led != s.peer_led || s.version < last) {
+            (*torn)++;
+        }
+        last = s.version;
+    }
+    return NULL;
+}
+
+static void test_concurrent(void)
+{
+    pthread_t w[WRITERS], r[READERS];
+    long torn[READERS] = {0};
+    device_state_t s;
+
+    /* make led == peer_led before the readers start checking */
+    state_get(&s);
+    if (s.led != s.peer_led) {
+        state_update(flip_both, NULL, NULL);
+    }
+    state_get(&s);
+    uint32_t v0 = s.version;
+    listener_last = v0;
+    CHECK(state_listen(ordered, NULL) == ESP_OK);
+
+    for (int i = 0; i < READERS; i++) {
+        pthread_create(&r[i], NULL, reader, &torn[i]);
+    }
+    for (int i = 0; i < WRITERS; i++) {
+        pthread_create(&w[i], NULL, writer, NULL);
+    }
+    for (int i = 0; i < WRITERS; i++) {
+        pthread_join(w[i], NULL);
+    }
+    stop = 1;
+    for (int i = 0; i < READERS; i++) {
+        pthread_join(r[i], NULL);
+        CHECK(torn[i] == 0);
+    }
+    state_get(&s);
+    CHECK(s.version == v0 + WRITERS * WRITES_PER_WRITER);
+    CHECK(listener_out_of_order == 0);
+    CHECK(listener_last == s.version);
+}
+
+int main(void)
+{
+    CHECK(state_init() == ESP_OK);
+    test_versions();
+    test_concurrent();
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("state: all tests passed\n");
+    return 0;
+}
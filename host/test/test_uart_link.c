@@ -0,0 +1,238 @@
+/* Host unit tests for the UART channels (main/uart_link.c)
+ *
+ * Two channels run on pty backed UARTs with a simulated peer thread on the
+ * slave side of each, so the peers can answer at their own pace. */
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "check.h"
+#include "router.h"
+#include "uart_link.h"
+
+#if CONFIG_EXAMPLE_TRACE
+/* /trace is not served here */
+esp_err_t router_register_uri(httpd_handle_t server, const httpd_uri_t *uri)
+{
+    return ESP_OK;
+}
+#endif
+
+#define FAST_ADDR       1
+#define SLOW_ADDR       2
+#define SLOW_TIMEOUT_MS 150
+
+typedef struct {
+    const char     *path;
+    int             fd;
+    volatile int    delay_ms;       /* before each reply */
+    frame_parser_t  parser;
+} peer_t;
+
+static peer_t peers[2];
+
+/* Completions in the order they arrived */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+static struct {
+    int                 tag;
+    uart_link_status_t  status;
+    uint8_t             reply[8];
+    size_t              reply_len;
+} done_log[32];
+static int n_done;
+
+static void sleep_ms(int ms)
+{
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+/* Echoes every payload back in a frame with the same sequence number */
+static void peer_on_frame(uint8_t seq, const uint8_t *payload, size_t len, void *arg)
+{
+    peer_t *peer = arg;
+    uint8_t frame[FRAME_MAX_LEN];
+
+    sleep_ms(peer->delay_ms);
+    size_t n = frame_encode(frame, sizeof(frame), seq, payload, len);
+    CHECK(write(peer->fd, frame, n) == (ssize_t)n);
+}
+
+static void *peer_thread(void *arg)
+{
+    peer_t *peer = arg;
+    uint8_t buf[256];
+
+    for (;;) {
+        ssize_t n = read(peer->fd, buf, sizeof(buf));
+        if (n > 0) {
+            frame_parser_feed(&peer->parser, buf, n, peer_on_frame, peer);
+        }
+    }
+    return NULL;
+}
+
+static void peer_start(peer_t *peer, const char *path)
+{
+    struct termios tio;
+    pthread_t thread;
+
+    peer->path = path;
+    peer->fd = open(path, O_RDWR | O_NOCTTY);
+    CHECK(peer->fd >= 0);
+    tcgetattr(peer->fd, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(peer->fd, TCSANOW, &tio);
+    frame_parser_init(&peer->parser);
+    pthread_create(&thread, NULL, peer_thread, peer);
+    pthread_detach(thread);
+}
+
+static void on_done(const uart_link_result_t *result, void *arg)
+{
+    pthread_mutex_lock(&lock);
+    done_log[n_done].tag = (int)(intptr_t)arg;
+    done_log[n_done].status = result->status;
+    done_log[n_done].reply_len = result->reply_len < 8 ? result->reply_len : 8;
+    if (result->reply) {
+        memcpy(done_log[n_done].reply, result->reply, done_log[n_done].reply_len);
+    }
+    n_done++;
+    pthread_cond_broadcast(&cond);
+    pthread_mutex_unlock(&lock);
+}
+
+/* Wait for n completions in total, false after 2 s */
+static bool wait_done(int n)
+{
+    struct timespec until;
+    bool ok = true;
+
+    clock_gettime(CLOCK_REALTIME, &until);
+    until.tv_sec += 2;
+    pthread_mutex_lock(&lock);
+    while (n_done < n && ok) {
+        ok = pthread_cond_timedwait(&cond, &lock, &until) == 0;
+    }
+    pthread_mutex_unlock(&lock);
+    return n_done >= n;
+}
+
+static esp_err_t request(uint8_t addr, uint8_t data, int tag)
+{
+    uint8_t payload[] = { FRAME_OP_PING, 1, data };
+    return uart_link_request(addr, payload, sizeof(payload), 0, on_done, (void *)(intptr_t)tag, NULL);
+}
+
+static void test_add(char *dir)
+{
+    const uart_link_config_t fast = {
+        .port = UART_NUM_1, .tx_pin = -1, .rx_pin = -1, .baud_rate = 115200,
+        .timeout_ms = 2000, .addr = FAST_ADDR,
+    };
+    const uart_link_config_t slow = {
+        .port = UART_NUM_2, .tx_pin = -1, .rx_pin = -1, .baud_rate = 9600,
+        .timeout_ms = SLOW_TIMEOUT_MS, .addr = SLOW_ADDR,
+    };
+    uart_link_config_t taken = fast;
+    static char path1[256], path2[256];
+
+    CHECK(uart_link_add(&fast) == ESP_OK);
+    CHECK(uart_link_add(&slow) == ESP_OK);
+    /* Neither a port nor an address can be used twice */
+    CHECK(uart_link_add(&taken) == ESP_ERR_INVALID_STATE);
+    taken.port = UART_NUM_0;
+    CHECK(uart_link_add(&taken) == ESP_ERR_INVALID_STATE);
+
+    CHECK(uart_link_channel(0)->addr == FAST_ADDR);
+    CHECK(uart_link_channel(1)->baud_rate == 9600);
+    CHECK(uart_link_channel(2) == NULL);
+
+    snprintf(path1, sizeof(path1), "%s/uart1", dir);
+    snprintf(path2, sizeof(path2), "%s/uart2", dir);
+    peer_start(&peers[0], path1);
+    peer_start(&peers[1], path2);
+}
+
+static void test_routing(void)
+{
+    int base = n_done;
+
+    CHECK(request(3, 0, 0) == ESP_ERR_NOT_FOUND);
+    CHECK(request(FAST_ADDR, 0x11, 1) == ESP_OK);
+    CHECK(request(SLOW_ADDR, 0x22, 2) == ESP_OK);
+    CHECK(wait_done(base + 2));
+    for (int i = base; i < n_done; i++) {
+        CHECK(done_log[i].status == UART_LINK_OK);
+        CHECK(done_log[i].reply_len == 3);
+        CHECK(done_log[i].reply[2] == (done_log[i].tag == 1 ? 0x11 : 0x22));
+    }
+}
+
+/* A peer that answers late holds up neither the other channel nor its own
+ * queue beyond its timeout */
+static void test_slow_peer(void)
+{
+    uart_link_stats_t st0, st;
+    int base = n_done;
+
+    uart_link_get_stats(1, &st0);
+    peers[1].delay_ms = SLOW_TIMEOUT_MS * 2;
+    for (int i = 0; i < UART_LINK_MAX_PENDING; i++) {
+        CHECK(request(SLOW_ADDR, i, 100 + i) == ESP_OK);
+    }
+    /* The slow channel is full, the fast one is not */
+    CHECK(request(SLOW_ADDR, 0, 0) == ESP_ERR_NO_MEM);
+    CHECK(request(FAST_ADDR, 0x33, 1) == ESP_OK);
+    CHECK(wait_done(base + 1));
+    CHECK(done_log[base].tag == 1 && done_log[base].status == UART_LINK_OK);
+
+    CHECK(wait_done(base + 1 + UART_LINK_MAX_PENDING));
+    for (int i = base + 1; i < n_done; i++) {
+        CHECK(done_log[i].tag >= 100 && done_log[i].status == UART_LINK_TIMEOUT);
+    }
+    uart_link_get_stats(1, &st);
+    CHECK(st.timeouts == st0.timeouts + UART_LINK_MAX_PENDING);
+    CHECK(st.awaiting == 0 && st.queued == 0);
+
+    /* Late replies are dropped as unmatched once the peer catches up */
+    peers[1].delay_ms = 0;
+    for (int i = 0; i < 300; i++) {
+        uart_link_get_stats(1, &st);
+        if (st.unmatched == st0.unmatched + UART_LINK_MAX_PENDING) {
+            break;
+        }
+        sleep_ms(10);
+    }
+    CHECK(st.unmatched == st0.unmatched + UART_LINK_MAX_PENDING);
+    CHECK(uart_link_get_stats(2, &st) == false);
+}
+
+int main(void)
+{
+    char dir[] = "/tmp/test_uart_link.XXXXXX";
+
+    CHECK(mkdtemp(dir) != NULL);
+    setenv("HOST_UART_DIR", dir, 1);
+    unsetenv("HOST_UART");
+    test_add(dir);
+    test_routing();
+    test_slow_peer();
+
+    unlink(peers[0].path);
+    unlink(peers[1].path);
+    rmdir(dir);
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("uart_link: all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+#
+# Simulated UART peer for the host build: answers the framed protocol of
+# main/frame.h on a host UART pty.
+#
+#   HOST_UART_DIR=/tmp ./build-host/simple_host &
+#   host/tools/uart_peer.py /tmp/uart1 [--delay 0.05] [--garbage]
+#
+# LED commands are answered with the new state, PING with its data, other
+# ops with an empty result. --garbage prefixes every reply with noise to
+# exercise the resynchronisation of the parser.
+
+import argparse
+import os
+import time
+import tty
+
+SOF = b"\xaa\x55"
+OP_LED = 0x01
+OP_PING = 0x02
+OP_REPLY = 0x80
+
+
+def crc16(data, crc=0xFFFF):
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def encode(seq, payload):
+    body = bytes([len(payload), seq]) + payload
+    crc = crc16(body)
+    return SOF + body + bytes([crc & 0xff, crc >> 8])
+
+
+def commands(payload):
+    pos = 0
+    while pos + 2 <= len(payload):
+        op, n = payload[pos], payload[pos + 1]
+        yield op, payload[pos + 2:pos + 2 + n]
+        pos += 2 + n
+
+
+def answer(payload, led):
+    out = b""
+    for op, data in commands(payload):
+        if op == OP_LED and data:
+            led[0] = 1 if data[0] else 0
+            res = bytes([led[0]])
+        elif op == OP_PING:
+            res = data
+        else:
+            res = b""
+        out += bytes([op | OP_REPLY, len(res)]) + res
+    return out
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__)
+    ap.add_argument("tty")
+    ap.add_argument("--delay", type=float, default=0.0, help="seconds before each reply")
+    ap.add_argument("--garbage", action="store_true", help="send noise before replies")
+    args = ap.parse_args()
+
+    fd = os.open(args.tty, os.O_RDWR | os.O_NOCTTY)
+    tty.setraw(fd)
+    led = [0]
+    buf = b""
+    while True:
+        buf += os.read(fd, 512)
+        while True:
+            i = buf.find(SOF)
+            if i < 0:
+                buf = buf[-1:]
+                break
+            buf = buf[i:]
+            if len(buf) < 6 or len(buf) < buf[2] + 6:
+                break
+            n = buf[2]
+            frame, rest = buf[:n + 6], buf[n + 6:]
+            if crc16(frame[2:n + 4]) != frame[n + 4] | frame[n + 5] << 8:
+                buf = buf[1:]
+                continue
+            buf = rest
+            reply = encode(frame[3], answer(frame[4:n + 4], led))
+            if args.delay:
+                time.sleep(args.delay)
+            os.write(fd, (b"\x00\xaa\x13" if args.garbage else b"") + reply)
+
+
+if __name__ == "__main__":
+    main()
@@ -16,18 +16,30 @@
 
 from __future__ import division, print_function, unicode_literals
 
+import argparse
+import json
 import os
 import random
 import re
 import socket
 import string
+import subprocess
+import sys
 import threading
 import time
+import zlib
 from builtins import range
 
-import ttfw_idf
-from idf_http_server_test import client
-from tiny_test_fw import Utility
+try:
+    import ttfw_idf
+    from idf_http_server_test import client
+    from tiny_test_fw import Utility
+except ImportError:
+    # The benchmark mode runs without the IDF test framework
+    class ttfw_idf(object):
+        @staticmethod
+        def idf_example_test(**kwargs):
+            return lambda func: func
 
 
 class http_client_thread(threading.Thread):
@@ -107,8 +119,8 @@ def test_examples_protocol_http_server_simple(env, extra_data):
     Utility.console_log('Test /ctrl PUT handler and realtime handler de/registration')
     if not client.test_put_handler(got_ip, got_port):
         raise RuntimeError
-    dut1.expect('Unregistering /hello and /echo URIs', timeout=30)
-    dut1.expect('Registering /hello and /echo URIs', timeout=30)
+    dut1.expect('Route profile basic', timeout=30)
+    dut1.expect('Route profile full', timeout=30)
 
     # Generate random data of 10KB
     random_data = ''.join(string.printable[random.randint(0,len(string.printable)) - 1] for _ in range(10 * 1024))
@@ -167,6 +179,387 @@ def test_examples_protocol_http_server_lru_purge_enable(env, extra_data):
         t.join()
 
 
+# Benchmark mode
+#
+# N keep-alive clients hammer the server with a mix of requests and report
+# throughput, latency percentiles, errors, timeouts and the connections the
+# server closed under them (LRU purges). Results go to a JSON file which can
+# be compared against a previous run to catch regressions:
+#
+# > python http_server_simple_test.py bench --ip 192.168.4.1 --out new.json
+# > python http_server_simple_test.py bench --server build-host/simple_host \
+#       --compare old.json
+#
+# The result records the server's task layout (CONFIG_EXAMPLE_SCHED_PROFILE,
+# from /metrics), so runs of builds with different layouts can be compared;
+# /send waits for the UART peer, its p99 - p50 is the round trip jitter.
+
+# (method, uri, echo payload size); weights follow a dashboard + automation mix
+BENCH_MIX = [
+    (('GET', '/', 0), 4),
+    (('GET', '/led_on', 0), 2),
+    (('GET', '/led_off', 0), 2),
+    (('GET', '/send', 0), 2),
+    (('POST', '/echo', 16), 2),
+    (('POST', '/echo', 1024), 1),
+    (('POST', '/echo', 8 * 1024), 1),
+]
+
+
+class bench_client_thread(threading.Thread):
+    def __init__(self, ip, port, deadline, timeout, seed):
+        threading.Thread.__init__(self)
+        self.ip = ip
+        self.port = port
+        self.deadline = deadline
+        self.timeout = timeout
+        self.rand = random.Random(seed)
+        self.samples = {}       # route -> [latency seconds]
+        self.errors = 0
+        self.timeouts = 0
+        self.purges = 0
+        self.connects = 0
+        self.sock = None
+        self.rbuf = b''
+        self.body = b''         # of the last response
+
+    def connect(self):
+        self.sock = socket.create_connection((self.ip, self.port), self.timeout)
+        self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self.rbuf = b''
+        self.connects += 1
+
+    def close(self):
+        if self.sock:
+            self.sock.close()
+        self.sock = None
+
+    def recv_until(self, marker):
+        while marker not in self.rbuf:
+            data = self.sock.recv(65536)
+            if not data:
+                raise ConnectionResetError('closed by server')
+            self.rbuf += data
+        head, self.rbuf = self.rbuf.split(marker, 1)
+        return head
+
+    def recv_exact(self, n):
+        while len(self.rbuf) < n:
+            data = self.sock.recv(65536)
+            if not data:
+                raise ConnectionResetError('closed by server')
+            self.rbuf += data
+        data, self.rbuf = self.rbuf[:n], self.rbuf[n:]
+        return data
+
+    def request(self, method, uri, body):
+        req = '{} {} HTTP/1.1\r\nHost: {}\r\n'.format(method, uri, self.ip)
+        if body:
+            req += 'Content-Length: {}\r\n'.format(len(body))
+        self.sock.sendall(req.encode() + b'\r\n' + body)
+
+        head = self.recv_until(b'\r\n\r\n').decode('latin-1').split('\r\n')
+        status = int(head[0].split(' ')[1])
+        hdrs = dict((h.split(':', 1)[0].lower(), h.split(':', 1)[1].strip()) for h in head[1:] if ':' in h)
+        self.body = b''
+        if 'content-length' in hdrs:
+            self.body = self.recv_exact(int(hdrs['content-length']))
+        elif hdrs.get('transfer-encoding') == 'chunked':
+            while True:
+                size = int(self.recv_until(b'\r\n'), 16)
+                self.body += self.recv_exact(size + 2)[:size]
+                if size == 0:
+                    break
+        return status
+
+    def run(self):
+        routes = [r for r, w in BENCH_MIX for _ in range(w)]
+        while time.time() < self.deadline:
+            method, uri, size = self.rand.choice(routes)
+            name = '{} {}{}'.format(method, uri, ' {}B'.format(size) if size else '')
+            body = ''.join(self.rand.choice(string.ascii_letters) for _ in range(size)).encode()
+            fresh = False
+            try:
+                if self.sock is None:
+                    self.connect()
+                    fresh = True
+                t0 = time.perf_counter()
+                status = self.request(method, uri, body)
+                self.samples.setdefault(name, []).append(time.perf_counter() - t0)
+                if status != 200:
+                    self.errors += 1
+            except socket.timeout:
+                self.timeouts += 1
+                self.close()
+            except (ConnectionError, OSError, ValueError, IndexError):
+                # A kept-alive socket closed under us was purged by the server
+                if fresh:
+                    self.errors += 1
+                else:
+                    self.purges += 1
+                self.close()
+        self.close()
+
+
+def percentile(sorted_values, pct):
+    if not sorted_values:
+        return 0.0
+    k = min(len(sorted_values) - 1, int(round(pct / 100.0 * (len(sorted_values) - 1))))
+    return sorted_values[k]
+
+
+def latency_summary(values):
+    values = sorted(values)
+    return {
+        'count': len(values),
+        'p50_ms': round(percentile(values, 50) * 1000, 3),
+        'p95_ms': round(percentile(values, 95) * 1000, 3),
+        'p99_ms': round(percentile(values, 99) * 1000, 3),
+        'max_ms': round((values[-1] if values else 0) * 1000, 3),
+    }
+
+
+SEND_ROUTE = 'GET /send'
+
+
+def server_layout(ip, port, timeout):
+    """The task layout the server reports in /metrics, None if it doesn't"""
+    conn = bench_client_thread(ip, port, 0, timeout, 0)
+    try:
+        conn.connect()
+        conn.request('GET', '/metrics', b'')
+    except (ConnectionError, OSError, ValueError, IndexError):
+        return None
+    finally:
+        conn.close()
+    m = re.search(r'sched_profile_info\{profile="([^"]+)"\}', conn.body.decode('latin-1'))
+    return m.group(1) if m else None
+
+
+def run_benchmark(ip, port, clients, duration, timeout):
+    layout = server_layout(ip, port, timeout)
+    deadline = time.time() + duration
+    threads = [bench_client_thread(ip, port, deadline, timeout, seed) for seed in range(clients)]
+    t0 = time.time()
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    elapsed = time.time() - t0
+
+    routes = {}
+    everything = []
+    for t in threads:
+        for name, values in t.samples.items():
+            routes.setdefault(name, []).extend(values)
+            everything.extend(values)
+    attempts = len(everything) + sum(t.timeouts + t.purges for t in threads)
+    errors = sum(t.errors for t in threads)
+    timeouts = sum(t.timeouts for t in threads)
+    return {
+        'target': '{}:{}'.format(ip, port),
+        'layout': layout,
+        'clients': clients,
+        'duration_s': round(elapsed, 3),
+        'requests': len(everything),
+        'rps': round(len(everything) / elapsed, 1),
+        'error_rate': round(errors / float(max(attempts, 1)), 5),
+        'timeout_rate': round(timeouts / float(max(attempts, 1)), 5),
+        'errors': errors,
+        'timeouts': timeouts,
+        'purges': sum(t.purges for t in threads),
+        'connects': sum(t.connects for t in threads),
+        'latency': latency_summary(everything),
+        'routes': dict((name, latency_summary(v)) for name, v in sorted(routes.items())),
+    }
+
+
+def compare_results(old, new, tolerance):
+    """Prints the change against a previous run, returns False on regression"""
+    ok = True
+
+    def check(name, before, after, higher_is_better):
+        nonlocal ok
+        if not before:
+            return
+        change = (after - before) / float(before)
+        worse = change < -tolerance if higher_is_better else change > tolerance
+        ok = ok and not worse
+        print('  {:<12} {:>10} -> {:<10} {:+.1%}{}'.format(name, before, after, change,
+                                                            '  REGRESSION' if worse else ''))
+
+    print('Compared to previous run (layout {} -> {}):'.format(old.get('layout'), new.get('layout')))
+    check('rps', old['rps'], new['rps'], True)
+    for key in ('p50_ms', 'p95_ms', 'p99_ms'):
+        check(key, old['latency'][key], new['latency'][key], False)
+    before = old['routes'].get(SEND_ROUTE)
+    after = new['routes'].get(SEND_ROUTE)
+    if before and after:
+        check('send p50_ms', before['p50_ms'], after['p50_ms'], False)
+        check('send jitter', round(before['p99_ms'] - before['p50_ms'], 3),
+              round(after['p99_ms'] - after['p50_ms'], 3), False)
+    return ok
+
+
+def start_host_server(binary, port):
+    env = dict(os.environ, HOST_HTTPD_PORT=str(port), HOST_UART='null')
+    proc = subprocess.Popen([binary], env=env, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    for line in iter(proc.stdout.readline, b''):
+        if b'Registering URI handlers' in line:
+            break
+    # Keep draining the log so the server never blocks on a full pipe
+    threading.Thread(target=lambda: proc.stdout.read(), daemon=True).start()
+    time.sleep(0.2)
+    return proc
+
+
+def bench_main(argv):
+    parser = argparse.ArgumentParser(prog='http_server_simple_test.py bench')
+    parser.add_argument('--ip', default='127.0.0.1')
+    parser.add_argument('--port', type=int, default=80)
+    parser.add_argument('--server', help='start this host build (simple_host) on --port')
+    parser.add_argument('--clients', type=int, default=4)
+    parser.add_argument('--duration', type=float, default=10)
+    parser.add_argument('--timeout', type=float, default=5)
+    parser.add_argument('--out', default='bench_output.json')
+    parser.add_argument('--compare', help='previous result file')
+    parser.add_argument('--tolerance', type=float, default=0.10)
+    args = parser.parse_args(argv)
+
+    proc = None
+    if args.server:
+        if args.port == 80:
+            args.port = 8080
+        proc = start_host_server(args.server, args.port)
+    try:
+        result = run_benchmark(args.ip, args.port, args.clients, args.duration, args.timeout)
+    finally:
+        if proc:
+            proc.terminate()
+            proc.wait()
+
+    with open(args.out, 'w') as f:
+        json.dump(result, f, indent=2, sort_keys=True)
+
+    print('{requests} requests in {duration_s}s from {clients} clients: {rps} req/s, layout {layout}'.format(**result))
+    print('errors {errors}, timeouts {timeouts}, purges {purges}, connects {connects}'.format(**result))
+    print('{:<20} {:>7} {:>9} {:>9} {:>9}'.format('route', 'count', 'p50 ms', 'p95 ms', 'p99 ms'))
+    for name, lat in sorted(result['routes'].items()) + [('all', result['latency'])]:
+        print('{:<20} {count:>7} {p50_ms:>9} {p95_ms:>9} {p99_ms:>9}'.format(name, **lat))
+    print('Results written to ' + args.out)
+
+    if args.compare:
+        with open(args.compare) as f:
+            if not compare_results(json.load(f), result, args.tolerance):
+                return 1
+    return 0
+
+
+# Upload throughput: POST bodies of growing size to /echo with each sink.
+# The body is sent from a second thread, the echo sink answers while the
+# upload is still running.
+#
+# > python http_server_simple_test.py upload --ip 192.168.4.1
+# > python http_server_simple_test.py upload --server build-host/simple_host
+UPLOAD_SIZES = '1K,16K,64K,256K,1M,4M'
+UPLOAD_SINKS = 'discard,checksum,echo'
+
+
+def parse_size(text):
+    units = {'K': 1024, 'M': 1024 * 1024}
+    if text[-1].upper() in units:
+        return int(text[:-1]) * units[text[-1].upper()]
+    return int(text)
+
+
+def upload_once(ip, port, sink, body, timeout):
+    conn = bench_client_thread(ip, port, 0, timeout, 0)
+    conn.connect()
+    head = 'POST /echo?sink={} HTTP/1.1\r\nHost: {}\r\nContent-Length: {}\r\n\r\n'.format(
+        sink, ip, len(body))
+    sender = threading.Thread(target=conn.sock.sendall, args=(head.encode() + body,))
+    t0 = time.perf_counter()
+    sender.start()
+    try:
+        lines = conn.recv_until(b'\r\n\r\n').decode('latin-1').split('\r\n')
+        status = int(lines[0].split(' ')[1])
+        hdrs = dict((h.split(':', 1)[0].lower(), h.split(':', 1)[1].strip()) for h in lines[1:] if ':' in h)
+        data = b''
+        if 'content-length' in hdrs:
+            data = conn.recv_exact(int(hdrs['content-length']))
+        elif hdrs.get('transfer-encoding') == 'chunked':
+            parts = []
+            while True:
+                size = int(conn.recv_until(b'\r\n'), 16)
+                parts.append(conn.recv_exact(size + 2)[:size])
+                if size == 0:
+                    break
+            data = b''.join(parts)
+        elapsed = time.perf_counter() - t0
+    finally:
+        sender.join()
+        conn.close()
+
+    if status != 200:
+        raise ValueError('{} {}: status {}'.format(sink, len(body), status))
+    if sink == 'echo':
+        ok = data == body
+    else:
+        answer = json.loads(data)
+        ok = answer['bytes'] == len(body)
+        if sink == 'checksum':
+            ok = ok and int(answer['crc32'], 16) == zlib.crc32(body) & 0xffffffff
+    if not ok:
+        raise ValueError('{} {}: wrong answer'.format(sink, len(body)))
+    return elapsed
+
+
+def upload_main(argv):
+    parser = argparse.ArgumentParser(prog='http_server_simple_test.py upload')
+    parser.add_argument('--ip', default='127.0.0.1')
+    parser.add_argument('--port', type=int, default=80)
+    parser.add_argument('--server', help='start this host build (simple_host) on --port')
+    parser.add_argument('--sizes', default=UPLOAD_SIZES)
+    parser.add_argument('--sinks', default=UPLOAD_SINKS)
+    parser.add_argument('--repeat', type=int, default=3)
+    parser.add_argument('--timeout', type=float, default=60)
+    parser.add_argument('--out', default='upload_output.json')
+    args = parser.parse_args(argv)
+
+    proc = None
+    if args.server:
+        if args.port == 80:
+            args.port = 8080
+        proc = start_host_server(args.server, args.port)
+    sinks = args.sinks.split(',')
+    result = {}
+    try:
+        print('{:>9}'.format('bytes') + ''.join(' {:>10}'.format(s + ' MB/s') for s in sinks))
+        for text in args.sizes.split(','):
+            size = parse_size(text)
+            body = os.urandom(size)
+            row = {}
+            for sink in sinks:
+                best = min(upload_once(args.ip, args.port, sink, body, args.timeout)
+                           for _ in range(args.repeat))
+                row[sink] = round(size / best / 1e6, 3)
+            result[size] = row
+            print('{:>9}'.format(size) + ''.join(' {:>10}'.format(row[s]) for s in sinks))
+    finally:
+        if proc:
+            proc.terminate()
+            proc.wait()
+
+    with open(args.out, 'w') as f:
+        json.dump(result, f, indent=2, sort_keys=True)
+    print('Results written to ' + args.out)
+    return 0
+
+
 if __name__ == '__main__':
+    if len(sys.argv) > 1 and sys.argv[1] == 'bench':
+        sys.exit(bench_main(sys.argv[2:]))
+    if len(sys.argv) > 1 and sys.argv[1] == 'upload':
+        sys.exit(upload_main(sys.argv[2:]))
     test_examples_protocol_http_server_simple()
     test_examples_protocol_http_server_lru_purge_enable()
@@ -0,0 +1,179 @@
+/* Request-scoped arena
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <esp_system.h>
+
+#include "arena.h"
+
+static const char *TAG = "arena";
+
+#define ARENA_ALIGN(n)      (((n) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+
+typedef struct arena_block {
+    struct arena_block *next;
+    size_t              size;
+    size_t              used;
+    uint8_t             data[];
+} arena_block_t;
+
+struct arena {
+    arena_block_t  *overflow;   /* newest first */
+    size_t          size;
+    size_t          used;
+    size_t          total;      /* bytes handed out since the last reset */
+    uint8_t         data[];
+};
+
+/* Only the httpd task touches the arenas, other tasks just read these */
+static arena_stats_t stats;
+
+arena_t *arena_create(size_t size)
+{
+    size = ARENA_ALIGN(size);
+    arena_t *arena = malloc(sizeof(arena_t) + size);
+
+    if (arena == NULL) {
+        return NULL;
+    }
+    arena->overflow = NULL;
+    arena->size = size;
+    arena->used = 0;
+    arena->total = 0;
+    stats.sessions++;
+    return arena;
+}
+
+void arena_destroy(arena_t *arena)
+{
+    if (arena == NULL) {
+        return;
+    }
+    arena_reset(arena);
+    free(arena);
+    stats.sessions--;
+}
+
+void *arena_alloc(arena_t *arena, size_t size)
+{
+    arena_block_t *block = arena->overflow;
+    void *ptr;
+
+    size = ARENA_ALIGN(size ? size : 1);
+    if (arena->used + size <= arena->size) {
+        ptr = arena->data + arena->used;
+        arena->used += size;
+    } else {
+        if (block == NULL || block->used + size > block->size) {
+            size_t block_size = size > arena->size ? size : arena->size;
+            block = malloc(sizeof(arena_block_t) + block_size);
+            if (block == NULL) {
+                return NULL;
+            }
+            block->next = arena->overflow;
+            block->size = block_size;
+            block->used = 0;
+            arena->overflow = block;
+            stats.overflows++;
+        }
+        ptr = block->data + block->used;
+        block->used += size;
+    }
+    arena->total += size;
+    stats.allocs++;
+    return ptr;
+}
+
+void arena_reset(arena_t *arena)
+{
+    arena_block_t *block = arena->overflow;
+
+    while (block) {
+        arena_block_t *next = block->next;
+        free(block);
+        block = next;
+    }
+    if (arena->total > stats.peak) {
+        stats.peak = arena->total;
+    }
+    arena->overflow = NULL;
+    arena->used = 0;
+    arena->total = 0;
+}
+
+static void arena_free_ctx(void *ctx)
+{
+    arena_destroy(ctx);
+}
+
+arena_t *arena_begin(httpd_req_t *req)
+{
+    arena_t *arena = req->sess_ctx;
+
+    if (arena == NULL) {
+        arena = arena_create(CONFIG_EXAMPLE_ARENA_BLOCK_SIZE);
+        if (arena == NULL) {
+            return NULL;
+        }
+        /* httpd takes the context over when the handler returns */
+        req->sess_ctx = arena;
+        req->free_ctx = arena_free_ctx;
+    } else if (arena->total) {
+        /* A previous handler returned without arena_end() */
+        arena_reset(arena);
+    }
+    return arena;
+}
+
+void arena_end(arena_t *arena)
+{
+    ESP_LOGD(TAG, "request used %u bytes", (unsigned)arena->total);
+    arena_reset(arena);
+    stats.requests++;
+}
+
+char *arena_hdr(arena_t *arena, httpd_req_t *req, const char *field)
+{
+    size_t len = httpd_req_get_hdr_value_len(req, field) + 1;
+    char *buf;
+
+    if (len == 1 || (buf = arena_alloc(arena, len)) == NULL) {
+        return NULL;
+    }
+    if (httpd_req_get_hdr_value_str(req, field, buf, len) != ESP_OK) {
+        return NULL;
+    }
+    return buf;
+}
+
+char *arena_query(arena_t *arena, httpd_req_t *req)
+{
+    size_t len = httpd_req_get_url_query_len(req) + 1;
+    char *buf;
+
+    if (len == 1 || (buf = arena_alloc(arena, len)) == NULL) {
+        return NULL;
+    }
+    if (httpd_req_get_url_query_str(req, buf, len) != ESP_OK) {
+        return NULL;
+    }
+    return buf;
+}
+
+void arena_get_stats(arena_stats_t *out)
+{
+    *out = stats;
+    out->heap_free = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    out->heap_min_free = esp_get_minimum_free_heap_size();
+    out->heap_largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    out->fragmentation = out->heap_free ? 100 - (uint64_t)out->heap_largest * 100 / out->heap_free : 0;
+}
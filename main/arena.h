@@ -0,0 +1,53 @@
+/* Request-scoped arena
+
+   Every httpd session gets an arena, kept as its session context. A handler
+   takes it with arena_begin(), allocates buffers that live for the request
+   (header values, the query string) from it and drops all of them at once
+   with arena_end(); nothing is freed individually. The first
+   CONFIG_EXAMPLE_ARENA_BLOCK_SIZE bytes are part of the arena and stay with
+   the session; a request needing more gets overflow blocks, which
+   arena_end() frees. A session thus costs one allocation when its first
+   request arrives instead of a malloc/free pair per header.
+
+   Buffers must not be used after arena_end() or after the request was
+   detached with http_async_begin().
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_http_server.h>
+
+typedef struct arena arena_t;
+
+typedef struct {
+    uint32_t sessions;      /* arenas alive */
+    uint32_t requests;      /* requests served from an arena */
+    uint32_t allocs;        /* buffers handed out */
+    uint32_t overflows;     /* overflow blocks taken from the heap */
+    uint32_t peak;          /* most bytes a single request used */
+    uint32_t heap_free;
+    uint32_t heap_min_free;
+    uint32_t heap_largest;  /* largest free block */
+    uint32_t fragmentation; /* percent of the free heap outside the largest block */
+} arena_stats_t;
+
+arena_t *arena_create(size_t size);
+void arena_destroy(arena_t *arena);
+
+/* Returns NULL only when an overflow block cannot be allocated */
+void *arena_alloc(arena_t *arena, size_t size);
+
+/* Drops everything allocated so far */
+void arena_reset(arena_t *arena);
+
+/* The session's arena, created on the session's first call. Returns NULL
+ * when out of memory. */
+arena_t *arena_begin(httpd_req_t *req);
+void arena_end(arena_t *arena);
+
+/* Header value or query string copied into the arena, NULL if absent */
+char *arena_hdr(arena_t *arena, httpd_req_t *req, const char *field);
+char *arena_query(arena_t *arena, httpd_req_t *req);
+
+void arena_get_stats(arena_stats_t *stats);
@@ -0,0 +1,110 @@
+/* Static web assets
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <esp_log.h>
+
+#include "assets.h"
+#include "router.h"
+
+static const char *TAG = "assets";
+
+/* Large enough for a list of a few quoted hashes */
+#define IF_NONE_MATCH_LEN   64
+#define ACCEPT_ENCODING_LEN 64
+
+#define HTTPD_406           "406 Not Acceptable"
+
+/* Whether the client takes the gzip body. No Accept-Encoding means any
+ * encoding (RFC 9110); a list that is cut short is searched as far as it
+ * goes. */
+static bool accepts_gzip(httpd_req_t *req)
+{
+    char list[ACCEPT_ENCODING_LEN];
+    char *save;
+    esp_err_t err = httpd_req_get_hdr_value_str(req, "Accept-Encoding", list, sizeof(list));
+
+    if (err == ESP_ERR_NOT_FOUND) {
+        return true;
+    }
+    if (err != ESP_OK && err != ESP_ERR_HTTPD_RESULT_TRUNC) {
+        return false;
+    }
+    for (char *item = strtok_r(list, ",", &save); item; item = strtok_r(NULL, ",", &save)) {
+        char *q = strchr(item, ';');
+        size_t len;
+
+        item += strspn(item, " ");
+        len = q ? (size_t)(q - item) : strlen(item);
+        while (len && item[len - 1] == ' ') {
+            len--;
+        }
+        if ((len == 4 && strncmp(item, "gzip", 4) == 0) || (len == 1 && *item == '*')) {
+            /* gzip;q=0 refuses it */
+            return q == NULL || strtod(q + strspn(q, "; q="), NULL) > 0;
+        }
+    }
+    return false;
+}
+
+const asset_t *asset_find(const char *uri)
+{
+    for (size_t i = 0; i < assets_count; i++) {
+        if (strcmp(assets[i].uri, uri) == 0) {
+            return &assets[i];
+        }
+    }
+    return NULL;
+}
+
+esp_err_t asset_get_handler(httpd_req_t *req)
+{
+    const asset_t *asset = (const asset_t *)req->user_ctx;
+    char tag[IF_NONE_MATCH_LEN];
+
+    httpd_resp_set_hdr(req, "ETag", asset->etag);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
+
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", tag, sizeof(tag)) == ESP_OK
+            && (strstr(tag, asset->etag) != NULL || strcmp(tag, "*") == 0)) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, NULL, 0);
+    }
+
+    /* Only the gzip form is kept in flash */
+    if (!accepts_gzip(req)) {
+        httpd_resp_set_status(req, HTTPD_406);
+        return httpd_resp_sendstr(req, "gzip only");
+    }
+    httpd_resp_set_type(req, asset->type);
+    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    return httpd_resp_send(req, (const char *)asset->data, asset->len);
+}
+
+esp_err_t assets_register(httpd_handle_t server)
+{
+    esp_err_t err = ESP_OK;
+
+    for (size_t i = 0; i < assets_count; i++) {
+        const httpd_uri_t uri = {
+            .uri      = assets[i].uri,
+            .method   = HTTP_GET,
+            .handler  = asset_get_handler,
+            .user_ctx = (void *)&assets[i]
+        };
+        ESP_LOGI(TAG, "%s: %u bytes (%u gzip)", assets[i].uri,
+                 (unsigned)assets[i].raw_len, (unsigned)assets[i].len);
+        if (router_register_uri(server, &uri) != ESP_OK) {
+            err = ESP_FAIL;
+        }
+    }
+    return err;
+}
@@ -0,0 +1,30 @@
+/* Static web assets
+
+   Files under main/assets are gzip compressed at build time (gen_assets.py)
+   and kept in flash together with a content hash used as ETag.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_http_server.h>
+
+typedef struct {
+    const char    *uri;
+    const char    *type;
+    const uint8_t *data;        /* gzip compressed content */
+    uint32_t       len;
+    uint32_t       raw_len;     /* size before compression */
+    const char    *etag;        /* quoted content hash */
+} asset_t;
+
+extern const asset_t assets[];
+extern const size_t assets_count;
+
+const asset_t *asset_find(const char *uri);
+
+/* Serves the asset_t passed in user_ctx */
+esp_err_t asset_get_handler(httpd_req_t *req);
+
+/* Register asset_get_handler for every asset in the table */
+esp_err_t assets_register(httpd_handle_t server);
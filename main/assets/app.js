@@ -0,0 +1,97 @@
+let ws = null;
+let version = 0;
+function led_show(state) {
+    let led = document.getElementById("led");
+    if(state == 1) {
+        led.className = "on";
+        led.innerText = "ON";
+    } else if(state == 0) {
+        led.className = "off";
+        led.innerText = "OFF";
+    } else {
+        led.className = "unk";
+        led.innerText = "?";
+    };
+};
+function ws_connect() {
+    if (!("WebSocket" in window)) {
+        return;
+    };
+    const sock = new WebSocket("ws://" + location.host + "/ws");
+    /* Versions restart when the device reboots */
+    sock.onopen = (e) => { ws = sock; version = 0; sock.send("state"); };
+    sock.onmessage = (e) => {
+        const msg = JSON.parse(e.data);
+        /* Broadcasts may overtake each other, the state version orders them */
+        if ("led" in msg && msg.v > version) {
+            version = msg.v;
+            led_show(msg.led);
+        };
+        if ("send" in msg) {
+            alert("Answer : " + msg.send);
+        };
+    };
+    /* Fall back to XHR while reconnecting */
+    sock.onclose = (e) => { ws = null; setTimeout(ws_connect, 2000); };
+};
+function ws_command(cmd) {
+    if (ws && ws.readyState === WebSocket.OPEN) {
+        ws.send(cmd);
+        return true;
+    };
+    return false;
+};
+function led_answer(e) {
+    if (this.readyState === 4) {
+        if (this.status === 200) {
+            led_show(this.responseText);
+            return;
+        } else {
+            alert("Status : " + this.statusText);
+            return;
+        }
+    };
+    alert("Not ready");
+};
+function led_on() {
+    if (ws_command("on")) {
+        return;
+    };
+    const req = new XMLHttpRequest();
+    req.open("GET", "/led_on", true);
+    req.onload = led_answer;
+    req.onerror = (e) => { alert("Error : " + req.statusText); };
+    req.send();
+};
+function led_off() {
+    if (ws_command("off")) {
+        return;
+    };
+    const req = new XMLHttpRequest();
+    req.open("GET", "/led_off", true);
+    req.onload = led_answer;
+    req.onerror = (e) => { alert("Error : " + req.statusText); };
+    req.send();
+};
+function send() {
+    if (ws_command("send")) {
+        return;
+    };
+    const req = new XMLHttpRequest();
+    req.open("GET", "/send");
+    req.onload = (e) => {
+        if (req.readyState === 4) {
+            if (req.status === 200) {
+                alert("Answer : " + req.responseText);
+                return;
+            } else {
+                alert("Status : " + req.statusText);
+                return;
+            };
+        };
+        alert("Not ready");
+    };
+    req.onerror = (e) => { alert("Error : " + req.statusText); };
+    req.send();
+}
+ws_connect();
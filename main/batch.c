@@ -0,0 +1,231 @@
+/* Batched device operations
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <esp_log.h>
+
+#include "batch.h"
+#include "device.h"
+#include "http_async.h"
+#include "router.h"
+#include "state.h"
+
+static const char *TAG = "batch";
+
+#define HTTPD_413           "413 Payload Too Large"
+#define BATCH_SEPARATORS    " \t\r\n,;"
+/* {"r":[],"v":4294967295} plus one quoted answer or a version per op */
+#define BATCH_RESP_MAX      (32 + BATCH_MAX_OPS * 12)
+
+typedef enum {
+    BATCH_LED,
+    BATCH_SEND,
+    BATCH_PEER,
+    BATCH_STATE,
+} batch_op_type_t;
+
+typedef struct {
+    uint8_t type;
+    uint8_t level;          /* BATCH_LED, BATCH_PEER */
+    uint8_t peer;           /* index of the peer command */
+} batch_op_t;
+
+typedef struct {
+    http_async_t   *async;
+    size_t          n;
+    batch_op_t      ops[BATCH_MAX_OPS];
+} batch_t;
+
+static bool batch_parse_op(const char *tok, batch_op_t *op)
+{
+    if (strcmp(tok, "on") == 0 || strcmp(tok, "off") == 0) {
+        op->type = BATCH_LED;
+        op->level = tok[1] == 'n';
+    } else if (strcmp(tok, "send") == 0) {
+        op->type = BATCH_SEND;
+    } else if (strcmp(tok, "peer=0") == 0 || strcmp(tok, "peer=1") == 0) {
+        op->type = BATCH_PEER;
+        op->level = tok[5] == '1';
+    } else if (strcmp(tok, "state") == 0) {
+        op->type = BATCH_STATE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/* Runs the operations in order and sends the answer. answers holds one
+ * answer per peer command. */
+static void batch_run(batch_t *b, httpd_req_t *req, const char *answers)
+{
+    char *resp = malloc(BATCH_RESP_MAX);
+    size_t len;
+
+    if (resp == NULL) {
+        if (req) {
+            httpd_resp_send_500(req);
+        } else {
+            http_async_send(b->async, HTTPD_500, HTTPD_TYPE_TEXT, NULL, 0);
+        }
+        free(b);
+        return;
+    }
+
+    len = sprintf(resp, "{\"r\":[");
+    for (size_t i = 0; i < b->n; i++) {
+        const batch_op_t *op = &b->ops[i];
+        const char *sep = i ? "," : "";
+
+        switch (op->type) {
+        case BATCH_LED:
+            device_led_set(op->level);
+            len += sprintf(resp + len, "%s\"%d\"", sep, op->level);
+            break;
+        case BATCH_SEND:
+        case BATCH_PEER:
+            device_peer_apply(DEVICE_PEER_PRIMARY, answers[op->peer]);
+            len += sprintf(resp + len, "%s\"%c\"", sep, answers[op->peer]);
+            break;
+        case BATCH_STATE:
+            len += sprintf(resp + len, "%s%u", sep, (unsigned)state_version());
+            break;
+        }
+    }
+    len += sprintf(resp + len, "],\"v\":%u}", (unsigned)state_version());
+
+    if (req) {
+        httpd_resp_set_type(req, HTTPD_TYPE_JSON);
+        httpd_resp_send(req, resp, len);
+    } else {
+        http_async_send(b->async, HTTPD_200, HTTPD_TYPE_JSON, resp, len);
+    }
+    free(resp);
+    free(b);
+}
+
+/* Runs in the UART link task once the peer answered or the timeout expired */
+static void batch_done(const char *answers, size_t n, void *arg)
+{
+    batch_t *b = arg;
+
+    ESP_LOGD(TAG, "%u ops, %u peer commands answered", (unsigned)b->n, (unsigned)n);
+    batch_run(b, NULL, answers);
+}
+
+static esp_err_t batch_read(httpd_req_t *req, char *buf, size_t size)
+{
+    size_t received = 0;
+    int ret;
+
+    while (received < req->content_len) {
+        ret = httpd_req_recv(req, buf + received, size - 1 - received);
+        if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
+            /* Retry receiving if timeout occurred */
+            continue;
+        }
+        if (ret <= 0) {
+            return ESP_FAIL;
+        }
+        received += ret;
+    }
+    buf[received] = '\0';
+    return ESP_OK;
+}
+
+static esp_err_t batch_post_handler(httpd_req_t *req)
+{
+    char body[BATCH_MAX_BODY + 1];
+    char err[48];
+    char answers[DEVICE_PEER_MAX_CMDS];
+    device_peer_tx_t tx;
+    size_t peers = 0;
+    batch_t *b;
+    char *save;
+
+    if (req->content_len > BATCH_MAX_BODY) {
+        httpd_resp_set_status(req, HTTPD_413);
+        return httpd_resp_sendstr(req, "batch too large");
+    }
+    if (batch_read(req, body, sizeof(body)) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    b = malloc(sizeof(batch_t));
+    if (b == NULL) {
+        return httpd_resp_send_500(req);
+    }
+
+    /* Everything is checked before the first operation runs */
+    b->n = 0;
+    for (char *tok = strtok_r(body, BATCH_SEPARATORS, &save); tok;
+            tok = strtok_r(NULL, BATCH_SEPARATORS, &save)) {
+        batch_op_t *op = &b->ops[b->n];
+
+        if (b->n == BATCH_MAX_OPS) {
+            free(b);
+            httpd_resp_set_status(req, HTTPD_413);
+            return httpd_resp_sendstr(req, "too many operations");
+        }
+        if (!batch_parse_op(tok, op)) {
+            snprintf(err, sizeof(err), "op %u: unknown \"%.16s\"", (unsigned)b->n, tok);
+            free(b);
+            return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, err);
+        }
+        if (op->type == BATCH_SEND || op->type == BATCH_PEER) {
+            if (peers == DEVICE_PEER_MAX_CMDS) {
+                snprintf(err, sizeof(err), "op %u: more than %d peer commands",
+                         (unsigned)b->n, DEVICE_PEER_MAX_CMDS);
+                free(b);
+                return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, err);
+            }
+            op->peer = peers++;
+        }
+        b->n++;
+    }
+
+    if (peers == 0) {
+        batch_run(b, req, NULL);
+        return ESP_OK;
+    }
+
+    /* The commanded peer states follow the batch order */
+    device_peer_begin(&tx, DEVICE_PEER_PRIMARY);
+    for (size_t i = 0; i < b->n; i++) {
+        if (b->ops[i].type == BATCH_SEND) {
+            device_peer_toggle(&tx);
+        } else if (b->ops[i].type == BATCH_PEER) {
+            device_peer_set(&tx, b->ops[i].level);
+        }
+    }
+
+    b->async = http_async_begin(req);
+    if (b->async == NULL) {
+        free(b);
+        return httpd_resp_send_500(req);
+    }
+    if (device_peer_commit(&tx, batch_done, b) != ESP_OK) {
+        /* Too many requests in flight, answer like a failed exchange */
+        memset(answers, DEVICE_ANSWER_BUSY, peers);
+        batch_run(b, NULL, answers);
+    }
+    return ESP_OK;
+}
+
+static const httpd_uri_t uri_batch = {
+    .uri       = "/batch",
+    .method    = HTTP_POST,
+    .handler   = batch_post_handler,
+    .user_ctx  = NULL
+};
+
+esp_err_t batch_register(httpd_handle_t server)
+{
+    return router_register_uri(server, &uri_batch);
+}
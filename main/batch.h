@@ -0,0 +1,24 @@
+/* Batched device operations
+
+   POST /batch takes a list of operations separated by commas, semicolons or
+   whitespace and runs them in order:
+
+     on, off        set the LED, like /led_on and /led_off
+     send           toggle the primary peer, like /send
+     peer=0|1       command an explicit primary peer state
+     state          the state version at that point
+
+   All peer commands of a batch go out in one frame and one UART transmit.
+   If there are any, the request is detached and the operations run in the
+   UART link task once the reply arrived, so their order is kept. The answer
+   is {"r":[...],"v":<version>} with one result per operation: the LED level
+   or the /send answer as a string, the version for state.
+*/
+#pragma once
+
+#include <esp_http_server.h>
+
+#define BATCH_MAX_OPS       64
+#define BATCH_MAX_BODY      512
+
+esp_err_t batch_register(httpd_handle_t server);
@@ -0,0 +1,161 @@
+/* Staged startup
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include "boot.h"
+#include "router.h"
+
+static const char *TAG = "boot";
+
+#define BOOT_STACK_SIZE     4096
+#define BOOT_PRIORITY       5
+
+static const boot_step_t *steps;
+static boot_stage_t stages[BOOT_MAX_STEPS];
+static size_t n_stages;
+static QueueHandle_t finished;
+static atomic_llong first_response_us = -1;
+
+static void step_run(uint8_t i)
+{
+    stages[i].start_us = esp_timer_get_time();
+    steps[i].run();
+    stages[i].end_us = esp_timer_get_time();
+}
+
+static void step_task(void *arg)
+{
+    uint8_t i = (uintptr_t)arg;
+
+    step_run(i);
+    xQueueSend(finished, &i, portMAX_DELAY);
+    vTaskDelete(NULL);
+}
+
+esp_err_t boot_run(const boot_step_t *list, size_t n)
+{
+    uint32_t all = (1u << n) - 1;
+    uint32_t started = 0;
+    int running = 0;
+
+    if (n == 0 || n > BOOT_MAX_STEPS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (finished == NULL && (finished = xQueueCreate(BOOT_MAX_STEPS, sizeof(uint8_t))) == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    steps = list;
+    n_stages = n;
+    for (size_t i = 0; i < n; i++) {
+        stages[i] = (boot_stage_t) { .name = list[i].name };
+    }
+
+    for (uint32_t done = 0; done != all; ) {
+        uint8_t i;
+
+        for (i = 0; i < n; i++) {
+            char name[16];
+            if ((started & (1u << i)) || (list[i].after & ~done)) {
+                continue;
+            }
+            started |= 1u << i;
+            snprintf(name, sizeof(name), "boot_%s", list[i].name);
+            if (xTaskCreate(step_task, name, BOOT_STACK_SIZE, (void *)(uintptr_t)i,
+                            BOOT_PRIORITY, NULL) == pdPASS) {
+                running++;
+            } else {
+                /* No memory for a task this early, run it here instead */
+                step_run(i);
+                xQueueSend(finished, &i, portMAX_DELAY);
+                running++;
+            }
+        }
+        if (running == 0) {
+            ESP_LOGE(TAG, "steps 0x%x wait for each other", (unsigned)(all & ~done));
+            return ESP_ERR_INVALID_ARG;
+        }
+        xQueueReceive(finished, &i, portMAX_DELAY);
+        running--;
+        done |= 1u << i;
+        ESP_LOGI(TAG, "%s took %lld ms, done at %lld ms", list[i].name,
+                 (long long)(stages[i].end_us - stages[i].start_us) / 1000,
+                 (long long)stages[i].end_us / 1000);
+    }
+    ESP_LOGI(TAG, "started in %lld ms", (long long)esp_timer_get_time() / 1000);
+    return ESP_OK;
+}
+
+void boot_served(void)
+{
+    long long none = -1;
+
+    if (atomic_load_explicit(&first_response_us, memory_order_relaxed) != -1) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    if (atomic_compare_exchange_strong(&first_response_us, &none, now)) {
+        ESP_LOGI(TAG, "first response %lld ms after start", (long long)now / 1000);
+    }
+}
+
+int64_t boot_first_response_us(void)
+{
+    return atomic_load(&first_response_us);
+}
+
+size_t boot_get_stages(boot_stage_t *out, size_t max)
+{
+    for (size_t i = 0; i < n_stages && i < max; i++) {
+        out[i] = stages[i];
+    }
+    return n_stages;
+}
+
+static esp_err_t boot_get_handler(httpd_req_t *req)
+{
+    char buf[96];
+    int64_t first = boot_first_response_us();
+    int len;
+
+    httpd_resp_set_type(req, HTTPD_TYPE_JSON);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    if (first < 0) {
+        len = snprintf(buf, sizeof(buf), "{\"first_response_us\":null,\"stages\":[");
+    } else {
+        len = snprintf(buf, sizeof(buf), "{\"first_response_us\":%lld,\"stages\":[", (long long)first);
+    }
+    httpd_resp_send_chunk(req, buf, len);
+    for (size_t i = 0; i < n_stages; i++) {
+        len = snprintf(buf, sizeof(buf), "%s{\"name\":\"%s\",\"start_us\":%lld,\"end_us\":%lld}",
+                       i ? "," : "", stages[i].name,
+                       (long long)stages[i].start_us, (long long)stages[i].end_us);
+        httpd_resp_send_chunk(req, buf, len);
+    }
+    httpd_resp_send_chunk(req, "]}", 2);
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+static const httpd_uri_t uri_boot = {
+    .uri       = "/boot",
+    .method    = HTTP_GET,
+    .handler   = boot_get_handler,
+    .user_ctx  = NULL
+};
+
+esp_err_t boot_register(httpd_handle_t server)
+{
+    return router_register_uri(server, &uri_boot);
+}
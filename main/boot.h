@@ -0,0 +1,52 @@
+/* Staged startup
+
+   app_main() describes its startup as a table of steps, each naming the
+   steps it has to wait for. boot_run() starts every step in its own task
+   as soon as those have finished, so independent work such as the UART
+   driver, NVS and the network stack overlaps instead of running in
+   sequence, and returns once all steps are done.
+
+   Each step is timestamped with esp_timer_get_time(), the time since the
+   chip started. The boot ends with the first response the server sends:
+   boot_served() is called from the socket send path and logs the time to
+   it once. GET /boot returns the stage times and that time as JSON.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_http_server.h>
+
+#define BOOT_MAX_STEPS      16
+#define BOOT_AFTER(step)    (1u << (step))
+
+typedef struct {
+    const char *name;
+    void      (*run)(void);
+    uint32_t    after;      /* BOOT_AFTER() of the steps to wait for */
+} boot_step_t;
+
+typedef struct {
+    const char *name;
+    int64_t     start_us;   /* since the chip started, 0 if not run */
+    int64_t     end_us;
+} boot_stage_t;
+
+/* Runs the steps and returns when all of them have finished. Steps are
+ * referred to by their index in the table, which must stay valid.
+ * ESP_ERR_INVALID_ARG if the dependencies form a cycle; the steps that
+ * could run have run then. */
+esp_err_t boot_run(const boot_step_t *steps, size_t n);
+
+/* A response went out. Only the first call does anything. */
+void boot_served(void);
+
+/* Time from the chip start to the first response, -1 before it */
+int64_t boot_first_response_us(void);
+
+/* Copies the stages of the last boot_run(), at most max, and returns how
+ * many there are */
+size_t boot_get_stages(boot_stage_t *stages, size_t max);
+
+/* Registers /boot */
+esp_err_t boot_register(httpd_handle_t server);
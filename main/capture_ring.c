@@ -0,0 +1,75 @@
+/* Byte capture ring
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <string.h>
+
+#include "capture_ring.h"
+
+void capture_ring_init(capture_ring_t *ring, uint8_t *data, size_t size)
+{
+    ring->data = data;
+    ring->size = size;
+    atomic_init(&ring->claim, 0);
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->full, false);
+}
+
+void capture_ring_write(capture_ring_t *ring, const uint8_t *buf, size_t len)
+{
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t mask = ring->size - 1;
+
+    /* Only the last size bytes survive the write */
+    if (len > ring->size) {
+        head += len - ring->size;
+        buf += len - ring->size;
+        len = ring->size;
+    }
+    atomic_store_explicit(&ring->claim, head + len, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    uint32_t at = head & mask;
+    size_t first = ring->size - at < len ? ring->size - at : len;
+    memcpy(ring->data + at, buf, first);
+    memcpy(ring->data, buf + first, len - first);
+    if (head + len >= ring->size) {
+        atomic_store_explicit(&ring->full, true, memory_order_relaxed);
+    }
+    atomic_store_explicit(&ring->head, head + len, memory_order_release);
+}
+
+size_t capture_ring_peek(capture_ring_t *ring, uint32_t *cursor, size_t max,
+                         const uint8_t **data, uint32_t *skipped)
+{
+    uint32_t head = capture_ring_head(ring);
+    uint32_t avail = head - *cursor;
+
+    *skipped = 0;
+    if (avail > ring->size) {
+        *skipped = avail - ring->size;
+        *cursor = head - ring->size;
+        avail = ring->size;
+    }
+    uint32_t at = *cursor & (ring->size - 1);
+    size_t len = ring->size - at;
+    if (len > avail) {
+        len = avail;
+    }
+    if (len > max) {
+        len = max;
+    }
+    *data = ring->data + at;
+    return len;
+}
+
+bool capture_ring_lost(capture_ring_t *ring, uint32_t pos)
+{
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&ring->claim, memory_order_relaxed) - pos > ring->size;
+}
@@ -0,0 +1,55 @@
+/* Byte capture ring
+
+   A power of two sized ring with one writer and any number of readers that
+   read in place. Positions are free running 32 bit byte counts: the writer
+   owns head, each reader keeps its own cursor, and byte n lives at
+   data[n & (size - 1)]. A reader never blocks the writer; one that falls
+   more than the ring size behind has lost the oldest bytes and is moved on
+   to the oldest byte still held.
+
+   The writer announces the end of a write in claim before it copies and
+   publishes it in head after, so a reader can tell whether the bytes it
+   was reading in place were overwritten meanwhile (capture_ring_lost()).
+*/
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    uint8_t            *data;
+    uint32_t            size;
+    _Atomic uint32_t    claim;      /* end of the write in progress */
+    _Atomic uint32_t    head;       /* end of the written bytes */
+    _Atomic bool        full;       /* size bytes or more were written */
+} capture_ring_t;
+
+/* size must be a power of two */
+void capture_ring_init(capture_ring_t *ring, uint8_t *data, size_t size);
+
+/* Appends len bytes, overwriting the oldest. Writer only. */
+void capture_ring_write(capture_ring_t *ring, const uint8_t *buf, size_t len);
+
+static inline uint32_t capture_ring_head(capture_ring_t *ring)
+{
+    return atomic_load_explicit(&ring->head, memory_order_acquire);
+}
+
+/* Oldest position still held */
+static inline uint32_t capture_ring_tail(capture_ring_t *ring)
+{
+    uint32_t head = capture_ring_head(ring);
+    return atomic_load_explicit(&ring->full, memory_order_relaxed) ? head - ring->size : 0;
+}
+
+/* Points *data at the bytes from *cursor on that can be read in place, up
+ * to the end of the buffer or max, and returns their number. A cursor
+ * more than the ring size behind is moved to the oldest byte first and
+ * *skipped set to the bytes it passed over. */
+size_t capture_ring_peek(capture_ring_t *ring, uint32_t *cursor, size_t max,
+                         const uint8_t **data, uint32_t *skipped);
+
+/* True if the writer reached the byte at pos since it was peeked */
+bool capture_ring_lost(capture_ring_t *ring, uint32_t pos);
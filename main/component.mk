@@ -2,3 +2,25 @@
 # "main" pseudo-component makefile.
 #
 # (Uses default behaviour of compiling all source files in directory, adding 'include' to include path.)
+#
+
+# Web assets are generated into the build directory, see gen_assets.py
+COMPONENT_OBJS := main.o page.o assets.o http_async.o uart_link.o frame.o ws.o state.o state_poll.o device.o batch.o boot.o arena.o upload.o log_defer.o metrics.o trace.o router.o connmgr.o resp_cache.o gpio_bank.o pin_group.o persist.o proto.o capture_ring.o uart_capture.o sched_profile.o assets_data.o proto_msgs.o
+COMPONENT_EXTRA_INCLUDES := $(COMPONENT_BUILD_DIR)
+COMPONENT_EXTRA_CLEAN := assets_data.c assets_data.h proto_msgs.c proto_msgs.h
+
+assets_data.c assets_data.h: $(COMPONENT_PATH)/gen_assets.py $(wildcard $(COMPONENT_PATH)/assets/*)
+	$(PYTHON) $(COMPONENT_PATH)/gen_assets.py $(COMPONENT_PATH)/assets $(COMPONENT_BUILD_DIR)
+
+assets_data.o: assets_data.c
+	$(CC) $(CFLAGS) $(CPPFLAGS) $(addprefix -I ,$(COMPONENT_INCLUDES)) $(addprefix -I ,$(COMPONENT_EXTRA_INCLUDES)) -c $< -o $@
+
+main.o page.o assets.o: assets_data.h
+
+proto_msgs.c proto_msgs.h: $(COMPONENT_PATH)/gen_proto.py $(COMPONENT_PATH)/proto.schema
+	$(PYTHON) $(COMPONENT_PATH)/gen_proto.py $(COMPONENT_PATH)/proto.schema $(COMPONENT_BUILD_DIR)
+
+proto_msgs.o: proto_msgs.c
+	$(CC) $(CFLAGS) $(CPPFLAGS) $(addprefix -I ,$(COMPONENT_INCLUDES)) $(addprefix -I ,$(COMPONENT_EXTRA_INCLUDES)) -c $< -o $@
+
+main.o proto.o: proto_msgs.h
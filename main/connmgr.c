@@ -0,0 +1,328 @@
+/* Connection manager
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <string.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include "connmgr.h"
+#include "http_async.h"
+
+static const char *TAG = "connmgr";
+
+#define CONNMGR_SWEEP_US        1000000
+
+typedef struct {
+    int             fd;             /* -1 if unused */
+    uint32_t        client;         /* IPv4 address, or a hash of the IPv6 one */
+    int64_t         opened;
+    int64_t         last_active;
+    bool            in_request;
+    bool            bulk;           /* last request was bulk */
+    bool            long_lived;     /* WebSocket or stream */
+    bool            closing;        /* close triggered, not done yet */
+} conn_t;
+
+static conn_t conns[CONNMGR_MAX_SESSIONS] = {
+    [0 ... CONNMGR_MAX_SESSIONS - 1] = { .fd = -1 },
+};
+static const char *bulk_uris[CONNMGR_MAX_BULK];
+static httpd_handle_t conn_server;
+static int max_sessions;
+static esp_timer_handle_t sweep_timer;
+static uint32_t decisions[CONNMGR_REASONS];
+
+static const char *const reason_names[CONNMGR_REASONS] = {
+    [CONNMGR_QUOTA]         = "quota",
+    [CONNMGR_QUOTA_REFUSED] = "quota_refused",
+    [CONNMGR_PRESSURE]      = "pressure",
+    [CONNMGR_NO_VICTIM]     = "no_victim",
+    [CONNMGR_IDLE]          = "idle",
+    [CONNMGR_BULK_CLOSE]    = "bulk_close",
+};
+
+static conn_t *conn_get(int fd)
+{
+    for (int i = 0; i < CONNMGR_MAX_SESSIONS; i++) {
+        if (conns[i].fd == fd) {
+            return &conns[i];
+        }
+    }
+    return NULL;
+}
+
+/* Sessions not on their way out */
+static int conn_count(uint32_t *client)
+{
+    int n = 0;
+
+    for (int i = 0; i < CONNMGR_MAX_SESSIONS; i++) {
+        if (conns[i].fd != -1 && !conns[i].closing && (client == NULL || conns[i].client == *client)) {
+            n++;
+        }
+    }
+    return n;
+}
+
+static bool conn_busy(const conn_t *c)
+{
+    return c->in_request || http_async_pending(c->fd);
+}
+
+static void conn_close(conn_t *c, connmgr_reason_t reason)
+{
+    decisions[reason]++;
+    c->closing = true;
+    ESP_LOGD(TAG, "closing %d: %s", c->fd, reason_names[reason]);
+    httpd_sess_trigger_close(conn_server, c->fd);
+}
+
+/* Idle timeout for the sessions open now: the maximum up to half the
+ * slots, then down linearly to the minimum when only the spare one is left */
+static int keepalive_s(void)
+{
+    int used = conn_count(NULL);
+    int half = max_sessions / 2;
+    int full = max_sessions - 1;
+
+    if (used <= half) {
+        return CONFIG_EXAMPLE_CONN_KEEPALIVE_MAX_S;
+    }
+    if (used >= full) {
+        return CONFIG_EXAMPLE_CONN_KEEPALIVE_MIN_S;
+    }
+    return CONFIG_EXAMPLE_CONN_KEEPALIVE_MAX_S -
+           (CONFIG_EXAMPLE_CONN_KEEPALIVE_MAX_S - CONFIG_EXAMPLE_CONN_KEEPALIVE_MIN_S) *
+           (used - half) / (full - half);
+}
+
+static uint32_t peer_client(int fd)
+{
+    struct sockaddr_storage addr;
+    socklen_t len = sizeof(addr);
+
+    if (getpeername(fd, (struct sockaddr *)&addr, &len) != 0) {
+        return 0;
+    }
+    if (addr.ss_family == AF_INET) {
+        return ((struct sockaddr_in *)&addr)->sin_addr.s_addr;
+    }
+    /* IPv4 clients of an IPv6 socket come mapped, ::ffff:a.b.c.d */
+    static const uint8_t v4_mapped[12] = { [10] = 0xff, [11] = 0xff };
+    const uint8_t *a = ((struct sockaddr_in6 *)&addr)->sin6_addr.s6_addr;
+    uint32_t h;
+
+    if (memcmp(a, v4_mapped, sizeof(v4_mapped)) == 0) {
+        memcpy(&h, a + 12, 4);
+        return h;
+    }
+    h = 2166136261u;
+    for (int i = 0; i < 16; i++) {
+        h = (h ^ a[i]) * 16777619u;
+    }
+    return h;
+}
+
+/* The idle session least worth keeping, other than keep */
+static conn_t *pick_victim(const conn_t *keep)
+{
+    conn_t *victim = NULL;
+    int victim_load = 0;
+
+    for (int i = 0; i < CONNMGR_MAX_SESSIONS; i++) {
+        conn_t *c = &conns[i];
+        if (c->fd == -1 || c == keep || c->closing || conn_busy(c)) {
+            continue;
+        }
+        int load = conn_count(&c->client);
+        if (victim == NULL || load > victim_load ||
+            (load == victim_load && c->bulk > victim->bulk) ||
+            (load == victim_load && c->bulk == victim->bulk && c->long_lived < victim->long_lived) ||
+            (load == victim_load && c->bulk == victim->bulk && c->long_lived == victim->long_lived &&
+             c->last_active < victim->last_active)) {
+            victim = c;
+            victim_load = load;
+        }
+    }
+    return victim;
+}
+
+esp_err_t connmgr_session_opened(httpd_handle_t hd, int sockfd)
+{
+    conn_t *c = conn_get(-1);
+
+    if (c == NULL) {
+        return ESP_OK;
+    }
+    *c = (conn_t) {
+        .fd = sockfd,
+        .client = peer_client(sockfd),
+        .opened = esp_timer_get_time(),
+    };
+    c->last_active = c->opened;
+
+    if (conn_count(&c->client) > CONFIG_EXAMPLE_CONN_CLIENT_QUOTA) {
+        conn_t *oldest = NULL;
+        for (int i = 0; i < CONNMGR_MAX_SESSIONS; i++) {
+            conn_t *o = &conns[i];
+            if (o->fd != -1 && o != c && o->client == c->client && !o->closing && !conn_busy(o) &&
+                (oldest == NULL || o->last_active < oldest->last_active)) {
+                oldest = o;
+            }
+        }
+        if (oldest == NULL) {
+            decisions[CONNMGR_QUOTA_REFUSED]++;
+            c->closing = true;
+            return ESP_FAIL;
+        }
+        conn_close(oldest, CONNMGR_QUOTA);
+    }
+
+    /* Keep a slot free, so the httpd never has to purge on its own */
+    if (conn_count(NULL) >= max_sessions) {
+        conn_t *victim = pick_victim(c);
+        if (victim) {
+            conn_close(victim, CONNMGR_PRESSURE);
+        } else {
+            decisions[CONNMGR_NO_VICTIM]++;
+        }
+    }
+    return ESP_OK;
+}
+
+void connmgr_session_closed(int sockfd)
+{
+    conn_t *c = conn_get(sockfd);
+
+    if (c) {
+        c->fd = -1;
+    }
+}
+
+void connmgr_request_begin(httpd_req_t *req)
+{
+    conn_t *c = conn_get(httpd_req_to_sockfd(req));
+    const char *q = strchr(req->uri, '?');
+    size_t len = q ? (size_t)(q - req->uri) : strlen(req->uri);
+
+    if (c == NULL) {
+        return;
+    }
+    c->in_request = true;
+    c->last_active = esp_timer_get_time();
+    c->bulk = false;
+    for (int i = 0; i < CONNMGR_MAX_BULK && bulk_uris[i]; i++) {
+        if (strlen(bulk_uris[i]) == len && strncmp(bulk_uris[i], req->uri, len) == 0) {
+            c->bulk = true;
+            break;
+        }
+    }
+    if (c->bulk && max_sessions - conn_count(NULL) <= 1) {
+        httpd_resp_set_hdr(req, "Connection", "close");
+        c->closing = true;
+    }
+}
+
+void connmgr_request_end(httpd_req_t *req)
+{
+    conn_t *c = conn_get(httpd_req_to_sockfd(req));
+
+    if (c == NULL) {
+        return;
+    }
+    c->in_request = false;
+    c->last_active = esp_timer_get_time();
+    if (c->bulk && c->closing) {
+        c->closing = false;
+        conn_close(c, CONNMGR_BULK_CLOSE);
+    }
+}
+
+void connmgr_websocket(int sockfd)
+{
+    conn_t *c = conn_get(sockfd);
+
+    if (c) {
+        c->long_lived = true;
+    }
+}
+
+void connmgr_stream(int sockfd)
+{
+    connmgr_websocket(sockfd);
+}
+
+static void connmgr_sweep(void *arg)
+{
+    int64_t limit = esp_timer_get_time() - (int64_t)keepalive_s() * 1000000;
+
+    for (int i = 0; i < CONNMGR_MAX_SESSIONS; i++) {
+        conn_t *c = &conns[i];
+        if (c->fd != -1 && !c->closing && !c->long_lived && !conn_busy(c) && c->last_active < limit) {
+            conn_close(c, CONNMGR_IDLE);
+        }
+    }
+}
+
+/* The sessions belong to the httpd task, the timer only queues the sweep */
+static void connmgr_sweep_timer(void *arg)
+{
+    httpd_queue_work(conn_server, connmgr_sweep, NULL);
+}
+
+esp_err_t connmgr_init(httpd_handle_t server, const httpd_config_t *config)
+{
+    const esp_timer_create_args_t args = {
+        .callback = connmgr_sweep_timer,
+        .name = "connmgr",
+    };
+    esp_err_t ret;
+
+    conn_server = server;
+    max_sessions = config->max_open_sockets;
+    ret = esp_timer_create(&args, &sweep_timer);
+    if (ret == ESP_OK) {
+        ret = esp_timer_start_periodic(sweep_timer, CONNMGR_SWEEP_US);
+    }
+    return ret;
+}
+
+esp_err_t connmgr_set_bulk(const char *uri)
+{
+    for (int i = 0; i < CONNMGR_MAX_BULK; i++) {
+        if (bulk_uris[i] == NULL) {
+            bulk_uris[i] = uri;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+const char *connmgr_reason_name(connmgr_reason_t reason)
+{
+    return reason < CONNMGR_REASONS ? reason_names[reason] : "?";
+}
+
+void connmgr_get_stats(connmgr_stats_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    memcpy(out->decisions, decisions, sizeof(decisions));
+    out->sessions = conn_count(NULL);
+    for (int i = 0; i < CONNMGR_MAX_SESSIONS; i++) {
+        const conn_t *c = &conns[i];
+        bool first = c->fd != -1 && !c->closing;
+        for (int k = 0; first && k < i; k++) {
+            first = !(conns[k].fd != -1 && !conns[k].closing && conns[k].client == c->client);
+        }
+        out->clients += first;
+    }
+    out->keepalive_s = keepalive_s();
+}
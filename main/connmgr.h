@@ -0,0 +1,73 @@
+/* Connection manager
+
+   Divides the few sockets (CONFIG_LWIP_MAX_SOCKETS, which the rest of the
+   system uses too) between the stations of the AP. Sessions are grouped by the
+   client's IP address, which the AP's DHCP server hands out one per
+   station. The decisions below take the place of the httpd's LRU purge,
+   which only remains as a fallback:
+
+   - a client opening more than CONFIG_EXAMPLE_CONN_CLIENT_QUOTA sessions
+     loses its own oldest idle one, or the new one if all are busy;
+   - when the last free slot is taken an idle session is closed so the next
+     client gets in: one of the client with most sessions first, sessions
+     last used for bulk requests before control ones, WebSockets and
+     streams last, then the longest idle;
+   - idle sessions are closed after a keep-alive timeout which shrinks from
+     CONFIG_EXAMPLE_CONN_KEEPALIVE_MAX_S to CONFIG_EXAMPLE_CONN_KEEPALIVE_MIN_S
+     as the slots fill up;
+   - bulk requests (connmgr_set_bulk()) while at most one slot is free
+     get their connection closed after the response.
+
+   Sessions with a request in progress, detached or not, are never closed;
+   WebSocket and stream sessions are not closed for being idle. Everything
+   runs in the httpd task.
+*/
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <esp_http_server.h>
+
+#define CONNMGR_MAX_SESSIONS    16
+#define CONNMGR_MAX_BULK        4
+
+typedef enum {
+    CONNMGR_QUOTA,          /* client over its quota, its oldest idle session closed */
+    CONNMGR_QUOTA_REFUSED,  /* client over its quota and all busy, new session closed */
+    CONNMGR_PRESSURE,       /* last slot taken, an idle session closed */
+    CONNMGR_NO_VICTIM,      /* last slot taken, nothing idle to close */
+    CONNMGR_IDLE,           /* idle past the keep-alive timeout */
+    CONNMGR_BULK_CLOSE,     /* bulk request while slots are short, closed after it */
+    CONNMGR_REASONS
+} connmgr_reason_t;
+
+typedef struct {
+    uint32_t    decisions[CONNMGR_REASONS];
+    uint16_t    sessions;
+    uint16_t    clients;
+    uint16_t    keepalive_s;    /* idle timeout at the current pressure */
+} connmgr_stats_t;
+
+/* Starts the idle sweep. Needs the server's config for the session limit. */
+esp_err_t connmgr_init(httpd_handle_t server, const httpd_config_t *config);
+
+/* Marks uri as bulk traffic. Bulk handlers must answer before returning. */
+esp_err_t connmgr_set_bulk(const char *uri);
+
+/* From the server open_fn and close_fn. A new session refused for the
+ * client's quota makes connmgr_session_opened() fail. */
+esp_err_t connmgr_session_opened(httpd_handle_t hd, int sockfd);
+void connmgr_session_closed(int sockfd);
+
+/* Around every handler call */
+void connmgr_request_begin(httpd_req_t *req);
+void connmgr_request_end(httpd_req_t *req);
+
+/* The session became a WebSocket */
+void connmgr_websocket(int sockfd);
+
+/* The session carries an endless response (a stream) */
+void connmgr_stream(int sockfd);
+
+const char *connmgr_reason_name(connmgr_reason_t reason);
+void connmgr_get_stats(connmgr_stats_t *stats);
@@ -0,0 +1,172 @@
+/* Device operations
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <esp_log.h>
+
+#include "device.h"
+#include "state.h"
+
+static const char *TAG = "device";
+
+typedef struct {
+    device_peer_done_t  done;
+    void               *arg;
+    size_t              n;
+    uint8_t             target[DEVICE_PEER_MAX_CMDS];
+} peer_ctx_t;
+
+/* Levels last commanded to or reported by the secondary peers, a bit per
+ * address */
+static atomic_uint peer_levels;
+
+uint32_t device_led_set(int level)
+{
+    return state_set_led(level);
+}
+
+static void peer_set(device_state_t *state, void *arg)
+{
+    state->peer_led = *(uint8_t *)arg;
+}
+
+/* The peer reported its LED state, the local LED follows it */
+static void peer_reported(device_state_t *state, void *arg)
+{
+    state->led = *(uint8_t *)arg;
+    state->peer_led = state->led;
+}
+
+void device_peer_begin(device_peer_tx_t *tx, uint8_t addr)
+{
+    tx->addr = addr;
+    tx->n = 0;
+    frame_payload_init(&tx->payload, tx->buf, sizeof(tx->buf));
+}
+
+/* The level the transaction commands last, else the one last commanded */
+static uint8_t peer_level(const device_peer_tx_t *tx)
+{
+    device_state_t state;
+
+    if (tx->n) {
+        return tx->target[tx->n - 1];
+    }
+    if (tx->addr == DEVICE_PEER_PRIMARY) {
+        state_get(&state);
+        return state.peer_led;
+    }
+    return (atomic_load(&peer_levels) >> tx->addr) & 1;
+}
+
+static void peer_store(uint8_t addr, uint8_t level)
+{
+    if (addr == DEVICE_PEER_PRIMARY) {
+        state_update(peer_set, &level, NULL);
+    } else if (level) {
+        atomic_fetch_or(&peer_levels, 1u << addr);
+    } else {
+        atomic_fetch_and(&peer_levels, ~(1u << addr));
+    }
+}
+
+static esp_err_t peer_add(device_peer_tx_t *tx, uint8_t level)
+{
+    if (tx->n == DEVICE_PEER_MAX_CMDS) {
+        return ESP_ERR_NO_MEM;
+    }
+    esp_err_t ret = frame_payload_add(&tx->payload, FRAME_OP_LED, &level, 1);
+    if (ret == ESP_OK) {
+        tx->target[tx->n++] = level;
+    }
+    return ret;
+}
+
+esp_err_t device_peer_toggle(device_peer_tx_t *tx)
+{
+    return peer_add(tx, !peer_level(tx));
+}
+
+esp_err_t device_peer_set(device_peer_tx_t *tx, int level)
+{
+    return peer_add(tx, level ? 1 : 0);
+}
+
+static void peer_done(const uart_link_result_t *result, void *arg)
+{
+    peer_ctx_t *ctx = arg;
+    char answers[DEVICE_PEER_MAX_CMDS];
+    frame_cmd_t cmd;
+    size_t pos = 0;
+    size_t i = 0;
+
+    for (size_t k = 0; k < ctx->n; k++) {
+        answers[k] = ctx->target[k] ? DEVICE_ANSWER_SILENT_ON : DEVICE_ANSWER_SILENT_OFF;
+    }
+    if (result->status == UART_LINK_OK) {
+        /* One reply per command, in order */
+        while (i < ctx->n && frame_payload_next(result->reply, result->reply_len, &pos, &cmd)) {
+            if (cmd.op != (FRAME_OP_LED | FRAME_OP_REPLY) || cmd.len < 1) {
+                continue;
+            }
+            answers[i++] = cmd.data[0] ? DEVICE_ANSWER_ON : DEVICE_ANSWER_OFF;
+        }
+        /* The peer replied, but not to every command */
+        for (size_t k = i; k < ctx->n; k++) {
+            answers[k] = DEVICE_ANSWER_BAD;
+        }
+    }
+    ESP_LOGD(TAG, "request %u: %u commands, %u answered", result->id, (unsigned)ctx->n, (unsigned)i);
+    ctx->done(answers, ctx->n, ctx->arg);
+    free(ctx);
+}
+
+esp_err_t device_peer_commit(device_peer_tx_t *tx, device_peer_done_t done, void *arg)
+{
+    peer_ctx_t *ctx;
+
+    if (tx->n == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    ctx = malloc(sizeof(*ctx));
+    if (ctx == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    ctx->done = done;
+    ctx->arg = arg;
+    ctx->n = tx->n;
+    memcpy(ctx->target, tx->target, tx->n);
+
+    /* The reply timeout is the one of the peer's channel */
+    esp_err_t ret = uart_link_request(tx->addr, tx->payload.buf, tx->payload.len, 0, peer_done, ctx, NULL);
+    if (ret != ESP_OK) {
+        free(ctx);
+        return ret;
+    }
+    /* Nothing is recorded for commands that were never sent */
+    peer_store(tx->addr, tx->target[tx->n - 1]);
+    return ESP_OK;
+}
+
+void device_peer_apply(uint8_t addr, char answer)
+{
+    uint8_t level;
+
+    if (answer != DEVICE_ANSWER_ON && answer != DEVICE_ANSWER_OFF) {
+        return;
+    }
+    level = answer == DEVICE_ANSWER_ON;
+    if (addr == DEVICE_PEER_PRIMARY) {
+        state_update(peer_reported, &level, NULL);
+    } else {
+        peer_store(addr, level);
+    }
+}
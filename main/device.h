@@ -0,0 +1,60 @@
+/* Device operations
+
+   The actions behind the HTTP, WebSocket and batch front ends: setting the
+   LED and commanding the UART peers. Peer commands are collected in a
+   device_peer_tx_t for one device address and committed together, so up to
+   DEVICE_PEER_MAX_CMDS of them travel in one frame and one UART transmit;
+   the reply carries one answer per command. The primary peer's LED is part
+   of the state store and the local LED follows what it reports, the levels
+   commanded to the other peers are only kept here.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "frame.h"
+#include "uart_link.h"
+
+#define DEVICE_PEER_MAX_CMDS    (UART_LINK_MAX_PAYLOAD / (FRAME_CMD_OVERHEAD + 1))
+#define DEVICE_PEER_PRIMARY     1
+#define DEVICE_PEER_MAX_ADDR    31
+
+/* Answers to a peer command, as returned by /send */
+#define DEVICE_ANSWER_OFF       '0'     /* peer reported off */
+#define DEVICE_ANSWER_ON        '1'     /* peer reported on */
+#define DEVICE_ANSWER_BAD       '6'     /* the reply has no answer to the command */
+#define DEVICE_ANSWER_SILENT_OFF '7'    /* no reply, off was commanded */
+#define DEVICE_ANSWER_SILENT_ON '8'     /* no reply, on was commanded */
+#define DEVICE_ANSWER_BUSY      '9'     /* not sent, too many requests in flight */
+
+typedef struct {
+    uint8_t         addr;
+    size_t          n;
+    uint8_t         target[DEVICE_PEER_MAX_CMDS];
+    uint8_t         buf[UART_LINK_MAX_PAYLOAD];
+    frame_payload_t payload;
+} device_peer_tx_t;
+
+/* Called from the UART link task with one answer per command */
+typedef void (*device_peer_done_t)(const char *answers, size_t n, void *arg);
+
+uint32_t device_led_set(int level);
+
+void device_peer_begin(device_peer_tx_t *tx, uint8_t addr);
+
+/* The /send command: flips the level commanded last, by this transaction
+ * or else by the last one committed */
+esp_err_t device_peer_toggle(device_peer_tx_t *tx);
+
+/* Command an explicit state */
+esp_err_t device_peer_set(device_peer_tx_t *tx, int level);
+
+/* Send the collected commands; only then does the last level commanded
+ * become the peer's. On error nothing changes and done is not called,
+ * ESP_ERR_NOT_FOUND if no channel serves the address. */
+esp_err_t device_peer_commit(device_peer_tx_t *tx, device_peer_done_t done, void *arg);
+
+/* Apply an answer of the peer at addr: the LED follows what the primary
+ * peer reported, answers without a report change nothing */
+void device_peer_apply(uint8_t addr, char answer);
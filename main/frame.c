@@ -0,0 +1,199 @@
+/* UART frame codec
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <string.h>
+
+#include "frame.h"
+
+/* CRC-CCITT, nibble table: small enough for flash, fast enough for 3 Mbaud */
+static const uint16_t crc_nibble[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+    0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef,
+};
+
+uint16_t frame_crc16(uint16_t crc, const uint8_t *data, size_t len)
+{
+    while (len--) {
+        crc = (crc << 4) ^ crc_nibble[(crc >> 12) ^ (*data >> 4)];
+        crc = (crc << 4) ^ crc_nibble[(crc >> 12) ^ (*data & 0x0f)];
+        data++;
+    }
+    return crc;
+}
+
+size_t frame_encode(uint8_t *out, size_t out_size, uint8_t seq, const uint8_t *payload, size_t len)
+{
+    if (len > FRAME_MAX_PAYLOAD || out_size < len + FRAME_OVERHEAD) {
+        return 0;
+    }
+    out[0] = FRAME_SOF0;
+    out[1] = FRAME_SOF1;
+    out[2] = (uint8_t)len;
+    out[3] = seq;
+    memcpy(out + FRAME_HEADER_LEN, payload, len);
+    uint16_t crc = frame_crc16(0xFFFF, out + 2, len + 2);
+    out[FRAME_HEADER_LEN + len] = crc & 0xff;
+    out[FRAME_HEADER_LEN + len + 1] = crc >> 8;
+    return len + FRAME_OVERHEAD;
+}
+
+void frame_payload_init(frame_payload_t *p, uint8_t *buf, size_t size)
+{
+    p->buf = buf;
+    p->size = size > FRAME_MAX_PAYLOAD ? FRAME_MAX_PAYLOAD : size;
+    p->len = 0;
+}
+
+esp_err_t frame_payload_add(frame_payload_t *p, uint8_t op, const void *data, uint8_t len)
+{
+    if (p->len + FRAME_CMD_OVERHEAD + len > p->size) {
+        return ESP_ERR_NO_MEM;
+    }
+    p->buf[p->len++] = op;
+    p->buf[p->len++] = len;
+    if (len) {
+        memcpy(p->buf + p->len, data, len);
+        p->len += len;
+    }
+    return ESP_OK;
+}
+
+bool frame_payload_next(const uint8_t *payload, size_t len, size_t *pos, frame_cmd_t *cmd)
+{
+    if (*pos + FRAME_CMD_OVERHEAD > len) {
+        return false;
+    }
+    cmd->op = payload[*pos];
+    cmd->len = payload[*pos + 1];
+    if (*pos + FRAME_CMD_OVERHEAD + cmd->len > len) {
+        return false;
+    }
+    cmd->data = payload + *pos + FRAME_CMD_OVERHEAD;
+    *pos += FRAME_CMD_OVERHEAD + cmd->len;
+    return true;
+}
+
+void frame_parser_init(frame_parser_t *p)
+{
+    memset(p, 0, sizeof(*p));
+}
+
+void frame_parser_reset(frame_parser_t *p)
+{
+    p->state = FRAME_STATE_SOF0;
+    p->len = 0;
+    p->replay_pos = 0;
+    p->replay_len = 0;
+}
+
+/* The frame in raw[] is invalid: scan it again from the next start byte
+ * after its first one, so a frame hidden in the rejected bytes is not lost.
+ * Unscanned replay bytes still follow it, the total never exceeds one frame. */
+static void parser_resync(frame_parser_t *p)
+{
+    size_t i = 1;
+    while (i < p->len && p->raw[i] != FRAME_SOF0) {
+        i++;
+    }
+    p->dropped += i;
+
+    size_t keep = p->len - i;
+    size_t rest = p->replay_len - p->replay_pos;
+    memmove(p->replay + keep, p->replay + p->replay_pos, rest);
+    memcpy(p->replay, p->raw + i, keep);
+    p->replay_pos = 0;
+    p->replay_len = keep + rest;
+    p->state = FRAME_STATE_SOF0;
+    p->len = 0;
+}
+
+static void parser_byte(frame_parser_t *p, uint8_t b, frame_cb_t cb, void *arg)
+{
+    switch (p->state) {
+    case FRAME_STATE_SOF0:
+        if (b == FRAME_SOF0) {
+            p->raw[0] = b;
+            p->len = 1;
+            p->state = FRAME_STATE_SOF1;
+        } else {
+            p->dropped++;
+        }
+        return;
+    case FRAME_STATE_SOF1:
+        p->raw[p->len++] = b;
+        if (b == FRAME_SOF1) {
+            p->state = FRAME_STATE_LEN;
+        } else {
+            parser_resync(p);
+        }
+        return;
+    case FRAME_STATE_LEN:
+        p->raw[p->len++] = b;
+        p->state = FRAME_STATE_SEQ;
+        return;
+    case FRAME_STATE_SEQ:
+        p->raw[p->len++] = b;
+        p->state = p->raw[2] ? FRAME_STATE_PAYLOAD : FRAME_STATE_CRC_LO;
+        return;
+    case FRAME_STATE_PAYLOAD:
+        p->raw[p->len++] = b;
+        if (p->len == FRAME_HEADER_LEN + (size_t)p->raw[2]) {
+            p->state = FRAME_STATE_CRC_LO;
+        }
+        return;
+    case FRAME_STATE_CRC_LO:
+        p->raw[p->len++] = b;
+        p->state = FRAME_STATE_CRC_HI;
+        return;
+    case FRAME_STATE_CRC_HI: {
+        p->raw[p->len++] = b;
+        size_t payload_len = p->raw[2];
+        uint16_t crc = frame_crc16(0xFFFF, p->raw + 2, payload_len + 2);
+        uint16_t got = p->raw[p->len - 2] | (p->raw[p->len - 1] << 8);
+        if (crc != got) {
+            p->crc_errors++;
+            parser_resync(p);
+            return;
+        }
+        p->frames++;
+        p->state = FRAME_STATE_SOF0;
+        p->len = 0;
+        cb(p->raw[3], p->raw + FRAME_HEADER_LEN, payload_len, arg);
+        return;
+    }
+    }
+}
+
+void frame_parser_feed(frame_parser_t *p, const uint8_t *data, size_t len, frame_cb_t cb, void *arg)
+{
+    size_t i = 0;
+
+    for (;;) {
+        if (p->replay_pos < p->replay_len) {
+            parser_byte(p, p->replay[p->replay_pos++], cb, arg);
+            continue;
+        }
+        if (i == len) {
+            break;
+        }
+        if (p->state == FRAME_STATE_PAYLOAD) {
+            /* Fast path: copy as much payload as is available */
+            size_t want = FRAME_HEADER_LEN + p->raw[2] - p->len;
+            size_t n = len - i < want ? len - i : want;
+            memcpy(p->raw + p->len, data + i, n);
+            p->len += n;
+            i += n;
+            if (n == want) {
+                p->state = FRAME_STATE_CRC_LO;
+            }
+            continue;
+        }
+        parser_byte(p, data[i++], cb, arg);
+    }
+}
@@ -0,0 +1,98 @@
+/* UART frame codec
+
+   Wire format, all fields one byte unless noted:
+
+       0xAA 0x55 LEN SEQ PAYLOAD[LEN] CRC16_LO CRC16_HI
+
+   CRC16 is CRC-CCITT (poly 0x1021, init 0xFFFF) over LEN, SEQ and the
+   payload. The payload is a list of commands, each OP LEN DATA[LEN], so one
+   frame can carry a burst of commands. A reply carries the SEQ of the
+   request it answers and one result per command, with FRAME_OP_REPLY set
+   in the op.
+
+   frame_parser_t is an incremental decoder: it accepts input in pieces of
+   any size and resynchronises on the next start sequence after garbage or
+   a CRC error, including start bytes inside a rejected frame.
+*/
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#define FRAME_SOF0              0xAA
+#define FRAME_SOF1              0x55
+#define FRAME_HEADER_LEN        4       /* SOF0 SOF1 LEN SEQ */
+#define FRAME_CRC_LEN           2
+#define FRAME_OVERHEAD          (FRAME_HEADER_LEN + FRAME_CRC_LEN)
+#define FRAME_MAX_PAYLOAD       255
+#define FRAME_MAX_LEN           (FRAME_MAX_PAYLOAD + FRAME_OVERHEAD)
+#define FRAME_CMD_OVERHEAD      2       /* OP LEN */
+
+/* Command ops */
+#define FRAME_OP_NOP            0x00
+#define FRAME_OP_LED            0x01    /* DATA: 0 off, 1 on; reply: state */
+#define FRAME_OP_PING           0x02    /* reply: echoes DATA */
+#define FRAME_OP_REPLY          0x80
+
+typedef struct {
+    uint8_t         op;
+    uint8_t         len;
+    const uint8_t  *data;
+} frame_cmd_t;
+
+/* Assembles a multi-command payload in a caller provided buffer */
+typedef struct {
+    uint8_t *buf;
+    size_t   size;
+    size_t   len;
+} frame_payload_t;
+
+typedef void (*frame_cb_t)(uint8_t seq, const uint8_t *payload, size_t len, void *arg);
+
+typedef enum {
+    FRAME_STATE_SOF0,
+    FRAME_STATE_SOF1,
+    FRAME_STATE_LEN,
+    FRAME_STATE_SEQ,
+    FRAME_STATE_PAYLOAD,
+    FRAME_STATE_CRC_LO,
+    FRAME_STATE_CRC_HI,
+} frame_state_t;
+
+typedef struct {
+    frame_state_t   state;
+    uint16_t        crc;
+    size_t          len;            /* bytes of the current frame in raw[] */
+    uint8_t         raw[FRAME_MAX_LEN];
+    /* bytes of a rejected frame that still have to be scanned */
+    size_t          replay_pos;
+    size_t          replay_len;
+    uint8_t         replay[FRAME_MAX_LEN];
+    /* statistics */
+    uint32_t        frames;
+    uint32_t        crc_errors;
+    uint32_t        dropped;        /* bytes skipped while hunting for a frame */
+} frame_parser_t;
+
+uint16_t frame_crc16(uint16_t crc, const uint8_t *data, size_t len);
+
+/* Encode a frame into out, returns its length or 0 if it does not fit */
+size_t frame_encode(uint8_t *out, size_t out_size, uint8_t seq, const uint8_t *payload, size_t len);
+
+void frame_payload_init(frame_payload_t *p, uint8_t *buf, size_t size);
+esp_err_t frame_payload_add(frame_payload_t *p, uint8_t op, const void *data, uint8_t len);
+
+/* Iterate the commands of a payload, *pos starts at 0. Returns false at the
+ * end or on a truncated command. */
+bool frame_payload_next(const uint8_t *payload, size_t len, size_t *pos, frame_cmd_t *cmd);
+
+void frame_parser_init(frame_parser_t *p);
+
+/* Drop a partially received frame, e.g. after an rx overflow. Keeps the
+ * statistics. */
+void frame_parser_reset(frame_parser_t *p);
+
+/* Feed received bytes, cb is called for every complete valid frame */
+void frame_parser_feed(frame_parser_t *p, const uint8_t *data, size_t len, frame_cb_t cb, void *arg);
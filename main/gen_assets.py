@@ -0,0 +1,194 @@
+#!/usr/bin/python3
+#
+# Build-time web asset stage.
+#
+#   gen_assets.py <asset dir> <output dir>
+#
+# Every file in the asset directory is minified. Files containing {{slot}}
+# markers are page templates: they are split into constant segments and a
+# slot table, streamed by page_send() or rendered into a response cache
+# entry by page_render() (main/page.h). All other files are gzip compressed and
+# tagged with a content hash; they are served by asset_get_handler().
+# The result is written to assets_data.c / assets_data.h, all data const so
+# it stays in flash.
+
+import gzip
+import hashlib
+import os
+import re
+import sys
+
+SLOT = re.compile(r"\{\{([a-z_][a-z0-9_]*)\}\}")
+
+MIME = {
+    ".html": "text/html; charset=UTF-8",
+    ".htm": "text/html; charset=UTF-8",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".json": "application/json",
+    ".svg": "image/svg+xml",
+    ".png": "image/png",
+    ".ico": "image/x-icon",
+    ".txt": "text/plain",
+}
+
+
+def minify(name, data):
+    ext = os.path.splitext(name)[1]
+    if ext not in (".html", ".htm", ".css", ".js", ".svg"):
+        return data
+    lines = [l.strip() for l in data.decode("utf-8").split("\n")]
+    lines = [l for l in lines if l]
+    # scripts keep their line breaks so statements without ';' survive
+    sep = "\n" if ext == ".js" else ""
+    return sep.join(lines).encode("utf-8")
+
+
+def ident(name):
+    return re.sub(r"[^a-z0-9]", "_", name.lower())
+
+
+def c_string(data, indent="    "):
+    out = []
+    line = ""
+    for ch in data:
+        if ch == 0x22:
+            esc = '\\"'
+        elif ch == 0x5c:
+            esc = "\\\\"
+        elif ch == 0x3f:
+            # keep "??" sequences away from trigraph processing
+            esc = "\\?"
+        elif 0x20 <= ch < 0x7f:
+            esc = chr(ch)
+        else:
+            esc = "\\%03o" % ch
+        line += esc
+        if len(line) >= 72:
+            out.append(indent + '"' + line + '"')
+            line = ""
+    if line or not out:
+        out.append(indent + '"' + line + '"')
+    return "\n".join(out)
+
+
+def c_bytes(data, indent="    "):
+    out = []
+    for i in range(0, len(data), 12):
+        out.append(indent + ", ".join("0x%02x" % b for b in data[i:i + 12]) + ",")
+    return "\n".join(out)
+
+
+def gen_page(name, text, hdr, src):
+    base = ident(os.path.splitext(name)[0])
+    names = []
+    parts = []
+    pos = 0
+    for m in SLOT.finditer(text):
+        slot = m.group(1)
+        if slot not in names:
+            names.append(slot)
+        parts.append((text[pos:m.start()], "%s_SLOT_%s" % (base.upper(), slot.upper())))
+        pos = m.end()
+    parts.append((text[pos:], "PAGE_NO_SLOT"))
+
+    hdr.append("/* %s */" % name)
+    hdr.append("enum {")
+    for n in names:
+        hdr.append("    %s_SLOT_%s," % (base.upper(), n.upper()))
+    hdr.append("    %s_SLOT_COUNT" % base.upper())
+    hdr.append("};")
+    hdr.append("")
+    hdr.append("extern const page_t %s_page;" % base)
+    hdr.append("")
+
+    src.append("/* %s */" % name)
+    for i, (seg, _) in enumerate(parts):
+        src.append("static const char %s_seg_%d[] =" % (base, i))
+        src.append(c_string(seg.encode("utf-8")) + ";")
+    src.append("")
+    src.append("static const page_part_t %s_parts[] = {" % base)
+    for i, (_, slot) in enumerate(parts):
+        src.append("    { %s_seg_%d, sizeof(%s_seg_%d) - 1, %s }," % (base, i, base, i, slot))
+    src.append("};")
+    src.append("")
+    src.append("static const char *const %s_slot_names[] = {" % base)
+    for n in names:
+        src.append('    "%s",' % n)
+    src.append("};")
+    src.append("")
+    src.append("const page_t %s_page = {" % base)
+    src.append("    .parts      = %s_parts," % base)
+    src.append("    .n_parts    = %d," % len(parts))
+    src.append("    .slot_names = %s_slot_names," % base)
+    src.append("    .n_slots    = %s_SLOT_COUNT," % base.upper())
+    src.append("    .size       = %d" % sum(len(p[0].encode("utf-8")) for p in parts))
+    src.append("};")
+    src.append("")
+    return "%s: %d bytes, %d segments, slots: %s" % (
+        name, len(text.encode("utf-8")), len(parts), ", ".join(names))
+
+
+def gen_asset(name, data, table, src):
+    base = ident(name)
+    gz = gzip.compress(data, 9, mtime=0)
+    etag = hashlib.sha256(data).hexdigest()[:16]
+    mime = MIME.get(os.path.splitext(name)[1], "application/octet-stream")
+
+    src.append("/* %s: %d -> %d bytes */" % (name, len(data), len(gz)))
+    src.append("static const uint8_t asset_%s_gz[] = {" % base)
+    src.append(c_bytes(gz))
+    src.append("};")
+    src.append("")
+    table.append('    { "/%s", "%s", asset_%s_gz, sizeof(asset_%s_gz), %d, "\\"%s\\"" },'
+                 % (name, mime, base, base, len(data), etag))
+    return "%s: %d -> %d bytes gzip, etag %s" % (name, len(data), len(gz), etag)
+
+
+def main():
+    asset_dir, out_dir = sys.argv[1], sys.argv[2]
+    hdr = [
+        "/* Generated by gen_assets.py - do not edit */",
+        "#pragma once",
+        "",
+        '#include "page.h"',
+        '#include "assets.h"',
+        "",
+    ]
+    src = [
+        "/* Generated by gen_assets.py - do not edit */",
+        '#include "assets_data.h"',
+        "",
+    ]
+    table = []
+    report = []
+
+    for name in sorted(os.listdir(asset_dir)):
+        path = os.path.join(asset_dir, name)
+        if not os.path.isfile(path) or name.startswith("."):
+            continue
+        with open(path, "rb") as f:
+            data = minify(name, f.read())
+        if SLOT.search(data.decode("utf-8", "ignore")):
+            report.append(gen_page(name, data.decode("utf-8"), hdr, src))
+        else:
+            report.append(gen_asset(name, data, table, src))
+
+    src.append("const asset_t assets[] = {")
+    src.extend(table)
+    src.append("};")
+    src.append("")
+    src.append("const size_t assets_count = %d;" % len(table))
+
+    def write(name, lines):
+        with open(os.path.join(out_dir, name), "w") as f:
+            f.write("\n".join(lines) + "\n")
+
+    os.makedirs(out_dir, exist_ok=True)
+    write("assets_data.h", hdr)
+    write("assets_data.c", src)
+    print("\n".join(report))
+
+
+if __name__ == "__main__":
+    main()
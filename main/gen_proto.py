@@ -0,0 +1,250 @@
+#!/usr/bin/python3
+#
+# Build-time binary protocol stage.
+#
+#   gen_proto.py <schema> <output dir>
+#
+# Reads the message definitions of proto.schema and writes proto_msgs.c /
+# proto_msgs.h: an id and a struct per message, a tagged union of all of
+# them, the encoder and decoder and the named values of enums. Every message has a fixed layout, so
+# decoding is one length check and a load per field.
+
+import os
+import re
+import sys
+
+TYPES = {
+    "u8": ("uint8_t", 1),
+    "u16": ("uint16_t", 2),
+    "u32": ("uint32_t", 4),
+}
+
+NAME = re.compile(r"^[a-z][a-z0-9_]*$")
+
+
+def parse(path):
+    msgs = []
+    enums = []
+    ids = set()
+    names = set()
+    with open(path) as f:
+        for n, line in enumerate(f, 1):
+            line = line.split("#", 1)[0].split()
+            if not line:
+                continue
+
+            def fail(what):
+                sys.exit("%s:%d: %s" % (path, n, what))
+
+            if line[0] == "enum":
+                if len(line) < 3 or not NAME.match(line[1]) or line[1] in names:
+                    fail("expected enum <name> <value>:<number> ...")
+                values = []
+                for spec in line[2:]:
+                    value, _, number = spec.partition(":")
+                    if not NAME.match(value) or not number.isdigit() or int(number) > 0xff:
+                        fail("bad value %s" % spec)
+                    values.append((value, int(number)))
+                names.add(line[1])
+                enums.append((line[1], values))
+                continue
+            if len(line) < 2 or not NAME.match(line[0]):
+                fail("expected <name> <id> [<field>:<type> ...]")
+            name, msg_id = line[0], int(line[1], 0)
+            if not 0 <= msg_id <= 0xff or msg_id in ids:
+                fail("id %s out of range or taken" % line[1])
+            if name in names:
+                fail("%s defined twice" % name)
+            fields = []
+            for spec in line[2:]:
+                field, _, typ = spec.partition(":")
+                if not NAME.match(field) or typ not in TYPES:
+                    fail("bad field %s" % spec)
+                fields.append((field, typ))
+            ids.add(msg_id)
+            names.add(name)
+            msgs.append((name, msg_id, fields))
+    return msgs, enums
+
+
+def size(fields):
+    return 1 + sum(TYPES[t][1] for _, t in fields)
+
+
+def load(typ, at):
+    if typ == "u8":
+        return "buf[%d]" % at
+    return "rd%d(buf + %d)" % (TYPES[typ][1] * 8, at)
+
+
+def store(typ, at, value):
+    if typ == "u8":
+        return "buf[%d] = %s;" % (at, value)
+    return "wr%d(buf + %d, %s);" % (TYPES[typ][1] * 8, at, value)
+
+
+def main():
+    schema, out_dir = sys.argv[1], sys.argv[2]
+    msgs, enums = parse(schema)
+    largest = max(size(f) for _, _, f in msgs)
+
+    hdr = [
+        "/* Generated by gen_proto.py from proto.schema - do not edit */",
+        "#pragma once",
+        "",
+        "#include <stddef.h>",
+        "#include <stdint.h>",
+        "",
+    ]
+    for name, msg_id, fields in msgs:
+        hdr.append("#define PROTO_%-16s 0x%02x    /* size %d */" % (name.upper(), msg_id, size(fields)))
+    hdr.append("")
+    hdr.append("#define PROTO_MAX_MSG           %d" % largest)
+    hdr.append("")
+    for name, values in enums:
+        for value, number in values:
+            hdr.append("#define PROTO_%-16s %d" % (("%s_%s" % (name, value)).upper(), number))
+        hdr.append("")
+    for name, _, fields in msgs:
+        if not fields:
+            continue
+        hdr.append("typedef struct {")
+        for field, typ in fields:
+            hdr.append("    %-9s %s;" % (TYPES[typ][0], field))
+        hdr.append("} proto_%s_t;" % name)
+        hdr.append("")
+    hdr.append("typedef struct {")
+    hdr.append("    uint8_t id;")
+    hdr.append("    union {")
+    for name, _, fields in msgs:
+        if fields:
+            hdr.append("        proto_%s_t %s;" % (name, name))
+    hdr.append("    };")
+    hdr.append("} proto_msg_t;")
+    hdr.append("")
+    hdr.append("/* Size of the message with this id, the id included; 0 if unknown */")
+    hdr.append("size_t proto_msg_size(uint8_t id);")
+    hdr.append("")
+    hdr.append("/* Name of the message with this id, NULL if unknown */")
+    hdr.append("const char *proto_msg_name(uint8_t id);")
+    hdr.append("")
+    hdr.append("/* Decodes the message at buf. Returns its size, 0 if len is too short")
+    hdr.append(" * for it, -1 for an unknown id. */")
+    hdr.append("int proto_decode(const uint8_t *buf, size_t len, proto_msg_t *msg);")
+    hdr.append("")
+    hdr.append("/* Encodes msg into buf. Returns its size, 0 if it does not fit or the id")
+    hdr.append(" * is unknown. */")
+    hdr.append("size_t proto_encode(const proto_msg_t *msg, uint8_t *buf, size_t size);")
+
+    src = [
+        "/* Generated by gen_proto.py from proto.schema - do not edit */",
+        '#include "proto_msgs.h"',
+        "",
+        "static inline uint16_t rd16(const uint8_t *p)",
+        "{",
+        "    return p[0] | p[1] << 8;",
+        "}",
+        "",
+        "static inline uint32_t rd32(const uint8_t *p)",
+        "{",
+        "    return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;",
+        "}",
+        "",
+        "static inline void wr16(uint8_t *p, uint16_t v)",
+        "{",
+        "    p[0] = v;",
+        "    p[1] = v >> 8;",
+        "}",
+        "",
+        "static inline void wr32(uint8_t *p, uint32_t v)",
+        "{",
+        "    p[0] = v;",
+        "    p[1] = v >> 8;",
+        "    p[2] = v >> 16;",
+        "    p[3] = v >> 24;",
+        "}",
+        "",
+        "size_t proto_msg_size(uint8_t id)",
+        "{",
+        "    switch (id) {",
+    ]
+    for name, _, fields in msgs:
+        src.append("    case PROTO_%s: return %d;" % (name.upper(), size(fields)))
+    src += [
+        "    default: return 0;",
+        "    }",
+        "}",
+        "",
+        "const char *proto_msg_name(uint8_t id)",
+        "{",
+        "    switch (id) {",
+    ]
+    for name, _, _ in msgs:
+        src.append('    case PROTO_%s: return "%s";' % (name.upper(), name))
+    src += [
+        "    default: return NULL;",
+        "    }",
+        "}",
+        "",
+        "int proto_decode(const uint8_t *buf, size_t len, proto_msg_t *msg)",
+        "{",
+        "    if (len == 0) {",
+        "        return 0;",
+        "    }",
+        "    msg->id = buf[0];",
+        "    switch (buf[0]) {",
+    ]
+    for name, _, fields in msgs:
+        src.append("    case PROTO_%s:" % name.upper())
+        if fields:
+            src.append("        if (len < %d) {" % size(fields))
+            src.append("            return 0;")
+            src.append("        }")
+        at = 1
+        for field, typ in fields:
+            src.append("        msg->%s.%s = %s;" % (name, field, load(typ, at)))
+            at += TYPES[typ][1]
+        src.append("        return %d;" % size(fields))
+    src += [
+        "    default:",
+        "        return -1;",
+        "    }",
+        "}",
+        "",
+        "size_t proto_encode(const proto_msg_t *msg, uint8_t *buf, size_t size)",
+        "{",
+        "    size_t len = proto_msg_size(msg->id);",
+        "",
+        "    if (len == 0 || len > size) {",
+        "        return 0;",
+        "    }",
+        "    buf[0] = msg->id;",
+        "    switch (msg->id) {",
+    ]
+    for name, _, fields in msgs:
+        if not fields:
+            continue
+        src.append("    case PROTO_%s:" % name.upper())
+        at = 1
+        for field, typ in fields:
+            src.append("        " + store(typ, at, "msg->%s.%s" % (name, field)))
+            at += TYPES[typ][1]
+        src.append("        break;")
+    src += [
+        "    }",
+        "    return len;",
+        "}",
+    ]
+
+    def write(name, lines):
+        with open(os.path.join(out_dir, name), "w") as f:
+            f.write("\n".join(lines) + "\n")
+
+    os.makedirs(out_dir, exist_ok=True)
+    write("proto_msgs.h", hdr)
+    write("proto_msgs.c", src)
+    print("%s: %d messages, largest %d bytes" % (os.path.basename(schema), len(msgs), largest))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,62 @@
+/* GPIO output banks on the ESP32
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include "driver/gpio.h"
+#include "soc/gpio_struct.h"
+
+#include "gpio_bank.h"
+
+/* GPIO0-31 are driven by GPIO.out, GPIO32-39 by GPIO.out1 */
+#define BANK0_MASK      0xffffffffULL
+
+/* Through the set and clear registers, which only touch the pins written
+ * as 1: no read-modify-write, so pins driven elsewhere with
+ * gpio_set_level() (the LED) can't lose a change and no lock is needed.
+ * The pins set switch one store before the pins cleared. */
+static void hw_write(uint64_t mask, uint64_t levels)
+{
+    uint32_t lo = (uint32_t)(mask & BANK0_MASK);
+    uint32_t hi = (uint32_t)(mask >> 32);
+
+    if (lo) {
+        GPIO.out_w1ts = (uint32_t)levels & lo;
+        GPIO.out_w1tc = ~(uint32_t)levels & lo;
+    }
+    if (hi) {
+        GPIO.out1_w1ts.data = (uint32_t)(levels >> 32) & hi;
+        GPIO.out1_w1tc.data = ~(uint32_t)(levels >> 32) & hi;
+    }
+}
+
+static esp_err_t hw_configure(uint64_t mask)
+{
+    const gpio_config_t config = {
+        .pin_bit_mask = mask,
+        .mode         = GPIO_MODE_INPUT_OUTPUT,
+        .pull_up_en   = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type    = GPIO_INTR_DISABLE,
+    };
+
+    /* Low before the output driver is enabled */
+    hw_write(mask, 0);
+    return gpio_config(&config);
+}
+
+static uint64_t hw_read(void)
+{
+    return GPIO.out | (uint64_t)GPIO.out1.data << 32;
+}
+
+const gpio_bank_t gpio_bank_hw = {
+    .name      = "gpio",
+    .configure = hw_configure,
+    .write     = hw_write,
+    .read      = hw_read,
+};
@@ -0,0 +1,27 @@
+/* GPIO output banks
+
+   Whole-register access to the GPIO outputs, pins as bits of a 64-bit mask
+   (bit n is GPIO n). A write changes every pin of the mask with one store
+   to the set and one to the clear register per bank, so the pins switch
+   within a bus cycle of each other and pins outside the mask are never
+   touched; a read returns the levels driven on all outputs at once.
+
+   gpio_bank_hw is the chip's GPIO matrix on the target (gpio_bank.c) and
+   the in-memory GPIO on the host (host/port/gpio_mem.c).
+*/
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef struct {
+    const char *name;
+    /* Make the pins of mask outputs, driven low */
+    esp_err_t (*configure)(uint64_t mask);
+    /* Drive the pins of mask to the matching bits of levels, others keep
+     * their level */
+    void (*write)(uint64_t mask, uint64_t levels);
+    uint64_t (*read)(void);
+} gpio_bank_t;
+
+extern const gpio_bank_t gpio_bank_hw;
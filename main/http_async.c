@@ -0,0 +1,122 @@
+/* Deferred HTTP responses
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <esp_log.h>
+
+#include "http_async.h"
+
+static const char *TAG = "http-async";
+
+/* Session generations, bumped whenever a socket is closed. Only touched from
+ * the httpd task (handlers, close_fn and queued work). */
+#define SESSION_GEN_SLOTS   64
+
+static uint32_t session_gen[SESSION_GEN_SLOTS];
+/* Detached requests not answered yet, per session */
+static uint8_t session_pending[SESSION_GEN_SLOTS];
+
+struct http_async {
+    httpd_handle_t  hd;
+    int             fd;
+    uint32_t        gen;
+    bool            abort;
+    size_t          len;        /* response bytes following the struct */
+    char            data[];
+};
+
+static uint32_t *gen_slot(int fd)
+{
+    return &session_gen[(unsigned)fd % SESSION_GEN_SLOTS];
+}
+
+http_async_t *http_async_begin(httpd_req_t *req)
+{
+    http_async_t *async = calloc(1, sizeof(*async));
+    if (async == NULL) {
+        return NULL;
+    }
+    async->hd = req->handle;
+    async->fd = httpd_req_to_sockfd(req);
+    async->gen = *gen_slot(async->fd);
+    session_pending[(unsigned)async->fd % SESSION_GEN_SLOTS]++;
+    return async;
+}
+
+void http_async_session_closed(int sockfd)
+{
+    (*gen_slot(sockfd))++;
+    session_pending[(unsigned)sockfd % SESSION_GEN_SLOTS] = 0;
+}
+
+bool http_async_pending(int sockfd)
+{
+    return session_pending[(unsigned)sockfd % SESSION_GEN_SLOTS] != 0;
+}
+
+static void http_async_work(void *arg)
+{
+    http_async_t *async = arg;
+
+    if (async->gen != *gen_slot(async->fd)) {
+        ESP_LOGD(TAG, "session %d closed before the response was ready", async->fd);
+        free(async);
+        return;
+    }
+    session_pending[(unsigned)async->fd % SESSION_GEN_SLOTS]--;
+    if (async->abort) {
+        httpd_sess_trigger_close(async->hd, async->fd);
+    } else if (httpd_socket_send(async->hd, async->fd, async->data, async->len, 0) != (int)async->len) {
+        ESP_LOGW(TAG, "sending deferred response on %d failed", async->fd);
+        httpd_sess_trigger_close(async->hd, async->fd);
+    }
+    free(async);
+}
+
+esp_err_t http_async_send(http_async_t *async, const char *status, const char *type,
+                          const char *buf, ssize_t buf_len)
+{
+    char head[96];
+
+    if (buf_len == HTTPD_RESP_USE_STRLEN) {
+        buf_len = buf ? strlen(buf) : 0;
+    }
+    int head_len = snprintf(head, sizeof(head),
+                            "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %d\r\n\r\n",
+                            status, type, (int)buf_len);
+
+    /* The response is assembled behind the handle, so a single allocation
+     * travels to the httpd task */
+    http_async_t *full = realloc(async, sizeof(*async) + head_len + buf_len);
+    if (full == NULL) {
+        http_async_abort(async);
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(full->data, head, head_len);
+    if (buf_len) {
+        memcpy(full->data + head_len, buf, buf_len);
+    }
+    full->len = head_len + buf_len;
+
+    if (httpd_queue_work(full->hd, http_async_work, full) != ESP_OK) {
+        free(full);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+void http_async_abort(http_async_t *async)
+{
+    async->abort = true;
+    if (httpd_queue_work(async->hd, http_async_work, async) != ESP_OK) {
+        free(async);
+    }
+}
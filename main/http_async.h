@@ -0,0 +1,34 @@
+/* Deferred HTTP responses
+
+   A handler detaches its request with http_async_begin() and returns
+   without responding, which frees the httpd task for other clients. The
+   response is sent later from any task with http_async_send(); it is
+   written from the httpd task through httpd_queue_work(). If the session was
+   closed meanwhile the response is dropped, even if the socket number has
+   been reused by a new client.
+*/
+#pragma once
+
+#include <stdbool.h>
+#include <sys/types.h>
+#include <esp_http_server.h>
+
+typedef struct http_async http_async_t;
+
+/* Detach the request. The handler must not send anything itself and should
+ * return ESP_OK. Returns NULL when out of memory. */
+http_async_t *http_async_begin(httpd_req_t *req);
+
+/* Send a complete response and release the handle. buf_len may be
+ * HTTPD_RESP_USE_STRLEN. */
+esp_err_t http_async_send(http_async_t *async, const char *status, const char *type,
+                          const char *buf, ssize_t buf_len);
+
+/* Release the handle without responding, the session is closed */
+void http_async_abort(http_async_t *async);
+
+/* Must be called from the server close_fn for every closed session */
+void http_async_session_closed(int sockfd);
+
+/* Whether the session has a detached request waiting for its response */
+bool http_async_pending(int sockfd);
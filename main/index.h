@@ -1,154 +0,0 @@
-unsigned char index_htm[] = {
-  0x3c, 0x21, 0x44, 0x4f, 0x43, 0x54, 0x59, 0x50, 0x45, 0x20, 0x68, 0x74,
-  0x6d, 0x6c, 0x3e, 0x3c, 0x68, 0x74, 0x6d, 0x6c, 0x3e, 0x3c, 0x68, 0x65,
-  0x61, 0x64, 0x3e, 0x3c, 0x74, 0x69, 0x74, 0x6c, 0x65, 0x3e, 0x45, 0x53,
-  0x50, 0x33, 0x32, 0x20, 0x53, 0x65, 0x72, 0x76, 0x65, 0x72, 0x3c, 0x2f,
-  0x74, 0x69, 0x74, 0x6c, 0x65, 0x3e, 0x3c, 0x73, 0x74, 0x79, 0x6c, 0x65,
-  0x3e, 0x62, 0x6f, 0x64, 0x79, 0x20, 0x7b, 0x66, 0x6f, 0x6e, 0x74, 0x2d,
-  0x73, 0x69, 0x7a, 0x65, 0x3a, 0x20, 0x33, 0x72, 0x65, 0x6d, 0x3b, 0x74,
-  0x65, 0x78, 0x74, 0x2d, 0x61, 0x6c, 0x69, 0x67, 0x6e, 0x3a, 0x20, 0x63,
-  0x65, 0x6e, 0x74, 0x65, 0x72, 0x3b, 0x77, 0x69, 0x64, 0x74, 0x68, 0x3a,
-  0x20, 0x31, 0x30, 0x30, 0x25, 0x3b, 0x7d, 0x2e, 0x75, 0x6e, 0x6b, 0x20,
-  0x7b, 0x63, 0x6f, 0x6c, 0x6f, 0x72, 0x3a, 0x20, 0x67, 0x72, 0x61, 0x79,
-  0x3b, 0x66, 0x6f, 0x6e, 0x74, 0x2d, 0x77, 0x65, 0x69, 0x67, 0x68, 0x74,
-  0x3a, 0x20, 0x6e, 0x6f, 0x72, 0x6d, 0x61, 0x6c, 0x3b, 0x7d, 0x2e, 0x6f,
-  0x6e, 0x20, 0x7b, 0x63, 0x6f, 0x6c, 0x6f, 0x72, 0x3a, 0x20, 0x62, 0x6c,
-  0x75, 0x65, 0x3b, 0x66, 0x6f, 0x6e, 0x74, 0x2d, 0x77, 0x65, 0x69, 0x67,
-  0x68, 0x74, 0x3a, 0x20, 0x62, 0x6f, 0x6c, 0x64, 0x3b, 0x7d, 0x2e, 0x6f,
-  0x66, 0x66, 0x20, 0x7b, 0x63, 0x6f, 0x6c, 0x6f, 0x72, 0x3a, 0x20, 0x6c,
-  0x69, 0x67, 0x68, 0x74, 0x63, 0x6f, 0x72, 0x61, 0x6c, 0x3b, 0x66, 0x6f,
-  0x6e, 0x74, 0x2d, 0x77, 0x65, 0x69, 0x67, 0x68, 0x74, 0x3a, 0x20, 0x62,
-  0x6f, 0x6c, 0x64, 0x3b, 0x7d, 0x2e, 0x68, 0x64, 0x72, 0x20, 0x7b, 0x66,
-  0x6f, 0x6e, 0x74, 0x2d, 0x77, 0x65, 0x69, 0x67, 0x68, 0x74, 0x3a, 0x20,
-  0x62, 0x6f, 0x6c, 0x64, 0x3b, 0x74, 0x65, 0x78, 0x74, 0x2d, 0x61, 0x6c,
-  0x69, 0x67, 0x6e, 0x3a, 0x20, 0x63, 0x65, 0x6e, 0x74, 0x65, 0x72, 0x3b,
-  0x7d, 0x2e, 0x62, 0x74, 0x6e, 0x20, 0x7b, 0x77, 0x69, 0x64, 0x74, 0x68,
-  0x3a, 0x20, 0x33, 0x30, 0x25, 0x3b, 0x66, 0x6f, 0x6e, 0x74, 0x2d, 0x73,
-  0x69, 0x7a, 0x65, 0x3a, 0x20, 0x34, 0x72, 0x65, 0x6d, 0x3b, 0x7d, 0x2e,
-  0x62, 0x74, 0x6e, 0x77, 0x20, 0x7b, 0x77, 0x69, 0x64, 0x74, 0x68, 0x3a,
-  0x20, 0x36, 0x30, 0x25, 0x3b, 0x66, 0x6f, 0x6e, 0x74, 0x2d, 0x73, 0x69,
-  0x7a, 0x65, 0x3a, 0x20, 0x34, 0x72, 0x65, 0x6d, 0x3b, 0x7d, 0x3c, 0x2f,
-  0x73, 0x74, 0x79, 0x6c, 0x65, 0x3e, 0x3c, 0x2f, 0x68, 0x65, 0x61, 0x64,
-  0x3e, 0x3c, 0x62, 0x6f, 0x64, 0x79, 0x3e, 0x3c, 0x64, 0x69, 0x76, 0x20,
-  0x63, 0x6c, 0x61, 0x73, 0x73, 0x3d, 0x22, 0x68, 0x64, 0x72, 0x22, 0x3e,
-  0x45, 0x53, 0x50, 0x33, 0x32, 0x20, 0x53, 0x65, 0x72, 0x76, 0x65, 0x72,
-  0x3c, 0x2f, 0x64, 0x69, 0x76, 0x3e, 0x3c, 0x64, 0x69, 0x76, 0x3e, 0x4c,
-  0x45, 0x44, 0x20, 0x69, 0x73, 0x20, 0x3c, 0x73, 0x70, 0x61, 0x6e, 0x20,
-  0x69, 0x64, 0x3d, 0x27, 0x6c, 0x65, 0x64, 0x27, 0x20, 0x63, 0x6c, 0x61,
-  0x73, 0x73, 0x3d, 0x22, 0x43, 0x43, 0x43, 0x22, 0x3e, 0x54, 0x54, 0x54,
-  0x3c, 0x2f, 0x73, 0x70, 0x61, 0x6e, 0x3e, 0x3c, 0x2f, 0x64, 0x69, 0x76,
-  0x3e, 0x3c, 0x64, 0x69, 0x76, 0x3e, 0x3c, 0x62, 0x75, 0x74, 0x74, 0x6f,
-  0x6e, 0x20, 0x63, 0x6c, 0x61, 0x73, 0x73, 0x3d, 0x22, 0x62, 0x74, 0x6e,
-  0x22, 0x20, 0x6f, 0x6e, 0x63, 0x6c, 0x69, 0x63, 0x6b, 0x3d, 0x22, 0x6c,
-  0x65, 0x64, 0x5f, 0x6f, 0x6e, 0x28, 0x29, 0x22, 0x3e, 0x4f, 0x4e, 0x3c,
-  0x2f, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x3e, 0x3c, 0x62, 0x75, 0x74,
-  0x74, 0x6f, 0x6e, 0x20, 0x63, 0x6c, 0x61, 0x73, 0x73, 0x3d, 0x22, 0x62,
-  0x74, 0x6e, 0x22, 0x20, 0x6f, 0x6e, 0x63, 0x6c, 0x69, 0x63, 0x6b, 0x3d,
-  0x22, 0x6c, 0x65, 0x64, 0x5f, 0x6f, 0x66, 0x66, 0x28, 0x29, 0x22, 0x3e,
-  0x4f, 0x46, 0x46, 0x3c, 0x2f, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x3e,
-  0x3c, 0x2f, 0x64, 0x69, 0x76, 0x3e, 0x3c, 0x64, 0x69, 0x76, 0x3e, 0x3c,
-  0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x20, 0x63, 0x6c, 0x61, 0x73, 0x73,
-  0x3d, 0x22, 0x62, 0x74, 0x6e, 0x77, 0x22, 0x20, 0x6f, 0x6e, 0x63, 0x6c,
-  0x69, 0x63, 0x6b, 0x3d, 0x22, 0x73, 0x65, 0x6e, 0x64, 0x28, 0x29, 0x22,
-  0x3e, 0x53, 0x45, 0x4e, 0x44, 0x3c, 0x2f, 0x62, 0x75, 0x74, 0x74, 0x6f,
-  0x6e, 0x3e, 0x3c, 0x2f, 0x64, 0x69, 0x76, 0x3e, 0x3c, 0x2f, 0x62, 0x6f,
-  0x64, 0x79, 0x3e, 0x3c, 0x73, 0x63, 0x72, 0x69, 0x70, 0x74, 0x20, 0x74,
-  0x79, 0x70, 0x65, 0x3d, 0x22, 0x61, 0x70, 0x70, 0x6c, 0x69, 0x63, 0x61,
-  0x74, 0x69, 0x6f, 0x6e, 0x2f, 0x6a, 0x61, 0x76, 0x61, 0x73, 0x63, 0x72,
-  0x69, 0x70, 0x74, 0x22, 0x3e, 0x66, 0x75, 0x6e, 0x63, 0x74, 0x69, 0x6f,
-  0x6e, 0x20, 0x6c, 0x65, 0x64, 0x5f, 0x61, 0x6e, 0x73, 0x77, 0x65, 0x72,
-  0x28, 0x65, 0x29, 0x20, 0x7b, 0x69, 0x66, 0x20, 0x28, 0x74, 0x68, 0x69,
-  0x73, 0x2e, 0x72, 0x65, 0x61, 0x64, 0x79, 0x53, 0x74, 0x61, 0x74, 0x65,
-  0x20, 0x3d, 0x3d, 0x3d, 0x20, 0x34, 0x29, 0x20, 0x7b, 0x69, 0x66, 0x20,
-  0x28, 0x74, 0x68, 0x69, 0x73, 0x2e, 0x73, 0x74, 0x61, 0x74, 0x75, 0x73,
-  0x20, 0x3d, 0x3d, 0x3d, 0x20, 0x32, 0x30, 0x30, 0x29, 0x20, 0x7b, 0x6c,
-  0x65, 0x74, 0x20, 0x6c, 0x65, 0x64, 0x20, 0x3d, 0x20, 0x64, 0x6f, 0x63,
-  0x75, 0x6d, 0x65, 0x6e, 0x74, 0x2e, 0x67, 0x65, 0x74, 0x45, 0x6c, 0x65,
-  0x6d, 0x65, 0x6e, 0x74, 0x42, 0x79, 0x49, 0x64, 0x28, 0x22, 0x6c, 0x65,
-  0x64, 0x22, 0x29, 0x3b, 0x69, 0x66, 0x28, 0x74, 0x68, 0x69, 0x73, 0x2e,
-  0x72, 0x65, 0x73, 0x70, 0x6f, 0x6e, 0x73, 0x65, 0x54, 0x65, 0x78, 0x74,
-  0x20, 0x3d, 0x3d, 0x20, 0x31, 0x29, 0x20, 0x7b, 0x6c, 0x65, 0x64, 0x2e,
-  0x63, 0x6c, 0x61, 0x73, 0x73, 0x4e, 0x61, 0x6d, 0x65, 0x20, 0x3d, 0x20,
-  0x22, 0x6f, 0x6e, 0x22, 0x3b, 0x6c, 0x65, 0x64, 0x2e, 0x69, 0x6e, 0x6e,
-  0x65, 0x72, 0x54, 0x65, 0x78, 0x74, 0x20, 0x3d, 0x20, 0x22, 0x4f, 0x4e,
-  0x22, 0x3b, 0x7d, 0x20, 0x65, 0x6c, 0x73, 0x65, 0x20, 0x69, 0x66, 0x28,
-  0x74, 0x68, 0x69, 0x73, 0x2e, 0x72, 0x65, 0x73, 0x70, 0x6f, 0x6e, 0x73,
-  0x65, 0x54, 0x65, 0x78, 0x74, 0x20, 0x3d, 0x3d, 0x20, 0x30, 0x29, 0x20,
-  0x7b, 0x6c, 0x65, 0x64, 0x2e, 0x63, 0x6c, 0x61, 0x73, 0x73, 0x4e, 0x61,
-  0x6d, 0x65, 0x20, 0x3d, 0x20, 0x22, 0x6f, 0x66, 0x66, 0x22, 0x3b, 0x6c,
-  0x65, 0x64, 0x2e, 0x69, 0x6e, 0x6e, 0x65, 0x72, 0x54, 0x65, 0x78, 0x74,
-  0x20, 0x3d, 0x20, 0x22, 0x4f, 0x46, 0x46, 0x22, 0x3b, 0x7d, 0x20, 0x65,
-  0x6c, 0x73, 0x65, 0x20, 0x7b, 0x6c, 0x65, 0x64, 0x2e, 0x63, 0x6c, 0x61,
-  0x73, 0x73, 0x4e, 0x61, 0x6d, 0x65, 0x20, 0x3d, 0x20, 0x22, 0x75, 0x6e,
-  0x6b, 0x22, 0x3b, 0x6c, 0x65, 0x64, 0x2e, 0x69, 0x6e, 0x6e, 0x65, 0x72,
-  0x54, 0x65, 0x78, 0x74, 0x20, 0x3d, 0x20, 0x22, 0x3f, 0x22, 0x3b, 0x7d,
-  0x3b, 0x72, 0x65, 0x74, 0x75, 0x72, 0x6e, 0x3b, 0x7d, 0x20, 0x65, 0x6c,
-  0x73, 0x65, 0x20, 0x7b, 0x61, 0x6c, 0x65, 0x72, 0x74, 0x28, 0x22, 0x53,
-  0x74, 0x61, 0x74, 0x75, 0x73, 0x20, 0x3a, 0x20, 0x22, 0x20, 0x2b, 0x20,
-  0x74, 0x68, 0x69, 0x73, 0x2e, 0x73, 0x74, 0x61, 0x74, 0x75, 0x73, 0x54,
-  0x65, 0x78, 0x74, 0x29, 0x3b, 0x72, 0x65, 0x74, 0x75, 0x72, 0x6e, 0x3b,
-  0x7d, 0x7d, 0x3b, 0x61, 0x6c, 0x65, 0x72, 0x74, 0x28, 0x22, 0x4e, 0x6f,
-  0x74, 0x20, 0x72, 0x65, 0x61, 0x64, 0x79, 0x22, 0x29, 0x3b, 0x7d, 0x3b,
-  0x66, 0x75, 0x6e, 0x63, 0x74, 0x69, 0x6f, 0x6e, 0x20, 0x6c, 0x65, 0x64,
-  0x5f, 0x6f, 0x6e, 0x28, 0x29, 0x20, 0x7b, 0x63, 0x6f, 0x6e, 0x73, 0x74,
-  0x20, 0x72, 0x65, 0x71, 0x20, 0x3d, 0x20, 0x6e, 0x65, 0x77, 0x20, 0x58,
-  0x4d, 0x4c, 0x48, 0x74, 0x74, 0x70, 0x52, 0x65, 0x71, 0x75, 0x65, 0x73,
-  0x74, 0x28, 0x29, 0x3b, 0x72, 0x65, 0x71, 0x2e, 0x6f, 0x70, 0x65, 0x6e,
-  0x28, 0x22, 0x47, 0x45, 0x54, 0x22, 0x2c, 0x20, 0x22, 0x2f, 0x6c, 0x65,
-  0x64, 0x5f, 0x6f, 0x6e, 0x22, 0x2c, 0x20, 0x74, 0x72, 0x75, 0x65, 0x29,
-  0x3b, 0x72, 0x65, 0x71, 0x2e, 0x6f, 0x6e, 0x6c, 0x6f, 0x61, 0x64, 0x20,
-  0x3d, 0x20, 0x6c, 0x65, 0x64, 0x5f, 0x61, 0x6e, 0x73, 0x77, 0x65, 0x72,
-  0x3b, 0x72, 0x65, 0x71, 0x2e, 0x6f, 0x6e, 0x65, 0x72, 0x72, 0x6f, 0x72,
-  0x20, 0x3d, 0x20, 0x28, 0x65, 0x29, 0x20, 0x3d, 0x3e, 0x20, 0x7b, 0x20,
-  0x61, 0x6c, 0x65, 0x72, 0x74, 0x28, 0x22, 0x45, 0x72, 0x72, 0x6f, 0x72,
-  0x20, 0x3a, 0x20, 0x22, 0x20, 0x2b, 0x20, 0x72, 0x65, 0x71, 0x2e, 0x73,
-  0x74, 0x61, 0x74, 0x75, 0x73, 0x54, 0x65, 0x78, 0x74, 0x29, 0x3b, 0x20,
-  0x7d, 0x3b, 0x72, 0x65, 0x71, 0x2e, 0x73, 0x65, 0x6e, 0x64, 0x28, 0x29,
-  0x3b, 0x7d, 0x3b, 0x66, 0x75, 0x6e, 0x63, 0x74, 0x69, 0x6f, 0x6e, 0x20,
-  0x6c, 0x65, 0x64, 0x5f, 0x6f, 0x66, 0x66, 0x28, 0x29, 0x20, 0x7b, 0x63,
-  0x6f, 0x6e, 0x73, 0x74, 0x20, 0x72, 0x65, 0x71, 0x20, 0x3d, 0x20, 0x6e,
-  0x65, 0x77, 0x20, 0x58, 0x4d, 0x4c, 0x48, 0x74, 0x74, 0x70, 0x52, 0x65,
-  0x71, 0x75, 0x65, 0x73, 0x74, 0x28, 0x29, 0x3b, 0x72, 0x65, 0x71, 0x2e,
-  0x6f, 0x70, 0x65, 0x6e, 0x28, 0x22, 0x47, 0x45, 0x54, 0x22, 0x2c, 0x20,
-  0x22, 0x2f, 0x6c, 0x65, 0x64, 0x5f, 0x6f, 0x66, 0x66, 0x22, 0x2c, 0x20,
-  0x74, 0x72, 0x75, 0x65, 0x29, 0x3b, 0x72, 0x65, 0x71, 0x2e, 0x6f, 0x6e,
-  0x6c, 0x6f, 0x61, 0x64, 0x20, 0x3d, 0x20, 0x6c, 0x65, 0x64, 0x5f, 0x61,
-  0x6e, 0x73, 0x77, 0x65, 0x72, 0x3b, 0x72, 0x65, 0x71, 0x2e, 0x6f, 0x6e,
-  0x65, 0x72, 0x72, 0x6f, 0x72, 0x20, 0x3d, 0x20, 0x28, 0x65, 0x29, 0x20,
-  0x3d, 0x3e, 0x20, 0x7b, 0x20, 0x61, 0x6c, 0x65, 0x72, 0x74, 0x28, 0x22,
-  0x45, 0x72, 0x72, 0x6f, 0x72, 0x20, 0x3a, 0x20, 0x22, 0x20, 0x2b, 0x20,
-  0x72, 0x65, 0x71, 0x2e, 0x73, 0x74, 0x61, 0x74, 0x75, 0x73, 0x54, 0x65,
-  0x78, 0x74, 0x29, 0x3b, 0x20, 0x7d, 0x3b, 0x72, 0x65, 0x71, 0x2e, 0x73,
-  0x65, 0x6e, 0x64, 0x28, 0x29, 0x3b, 0x7d, 0x3b, 0x66, 0x75, 0x6e, 0x63,
-  0x74, 0x69, 0x6f, 0x6e, 0x20, 0x73, 0x65, 0x6e, 0x64, 0x28, 0x29, 0x20,
-  0x7b, 0x63, 0x6f, 0x6e, 0x73, 0x74, 0x20, 0x72, 0x65, 0x71, 0x20, 0x3d,
-  0x20, 0x6e, 0x65, 0x77, 0x20, 0x58, 0x4d, 0x4c, 0x48, 0x74, 0x74, 0x70,
-  0x52, 0x65, 0x71, 0x75, 0x65, 0x73, 0x74, 0x28, 0x29, 0x3b, 0x72, 0x65,
-  0x71, 0x2e, 0x6f, 0x70, 0x65, 0x6e, 0x28, 0x22, 0x47, 0x45, 0x54, 0x22,
-  0x2c, 0x20, 0x22, 0x2f, 0x73, 0x65, 0x6e, 0x64, 0x22, 0x29, 0x3b, 0x72,
-  0x65, 0x71, 0x2e, 0x6f, 0x6e, 0x6c, 0x6f, 0x61, 0x64, 0x20, 0x3d, 0x20,
-  0x28, 0x65, 0x29, 0x20, 0x3d, 0x3e, 0x20, 0x7b, 0x69, 0x66, 0x20, 0x28,
-  0x72, 0x65, 0x71, 0x2e, 0x72, 0x65, 0x61, 0x64, 0x79, 0x53, 0x74, 0x61,
-  0x74, 0x65, 0x20, 0x3d, 0x3d, 0x3d, 0x20, 0x34, 0x29, 0x20, 0x7b, 0x69,
-  0x66, 0x20, 0x28, 0x72, 0x65, 0x71, 0x2e, 0x73, 0x74, 0x61, 0x74, 0x75,
-  0x73, 0x20, 0x3d, 0x3d, 0x3d, 0x20, 0x32, 0x30, 0x30, 0x29, 0x20, 0x7b,
-  0x61, 0x6c, 0x65, 0x72, 0x74, 0x28, 0x22, 0x41, 0x6e, 0x73, 0x77, 0x65,
-  0x72, 0x20, 0x3a, 0x20, 0x22, 0x20, 0x2b, 0x20, 0x74, 0x68, 0x69, 0x73,
-  0x2e, 0x72, 0x65, 0x73, 0x70, 0x6f, 0x6e, 0x73, 0x65, 0x54, 0x65, 0x78,
-  0x74, 0x29, 0x3b, 0x72, 0x65, 0x74, 0x75, 0x72, 0x6e, 0x3b, 0x7d, 0x20,
-  0x65, 0x6c, 0x73, 0x65, 0x20, 0x7b, 0x61, 0x6c, 0x65, 0x72, 0x74, 0x28,
-  0x22, 0x53, 0x74, 0x61, 0x74, 0x75, 0x73, 0x20, 0x3a, 0x20, 0x22, 0x20,
-  0x2b, 0x20, 0x74, 0x68, 0x69, 0x73, 0x2e, 0x73, 0x74, 0x61, 0x74, 0x75,
-  0x73, 0x54, 0x65, 0x78, 0x74, 0x29, 0x3b, 0x72, 0x65, 0x74, 0x75, 0x72,
-  0x6e, 0x3b, 0x7d, 0x3b, 0x7d, 0x3b, 0x61, 0x6c, 0x65, 0x72, 0x74, 0x28,
-  0x22, 0x4e, 0x6f, 0x74, 0x20, 0x72, 0x65, 0x61, 0x64, 0x79, 0x22, 0x29,
-  0x3b, 0x7d, 0x3b, 0x72, 0x65, 0x71, 0x2e, 0x6f, 0x6e, 0x65, 0x72, 0x72,
-  0x6f, 0x72, 0x20, 0x3d, 0x20, 0x28, 0x65, 0x29, 0x20, 0x3d, 0x3e, 0x20,
-  0x7b, 0x20, 0x61, 0x6c, 0x65, 0x72, 0x74, 0x28, 0x22, 0x45, 0x72, 0x72,
-  0x6f, 0x72, 0x20, 0x3a, 0x20, 0x22, 0x20, 0x2b, 0x20, 0x72, 0x65, 0x71,
-  0x2e, 0x73, 0x74, 0x61, 0x74, 0x75, 0x73, 0x54, 0x65, 0x78, 0x74, 0x29,
-  0x3b, 0x20, 0x7d, 0x3b, 0x72, 0x65, 0x71, 0x2e, 0x73, 0x65, 0x6e, 0x64,
-  0x28, 0x29, 0x3b, 0x7d, 0x3c, 0x2f, 0x73, 0x63, 0x72, 0x69, 0x70, 0x74,
-  0x3e, 0x3c, 0x2f, 0x68, 0x74, 0x6d, 0x6c, 0x3e
-};
-unsigned int index_htm_len = 1808;
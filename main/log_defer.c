@@ -0,0 +1,311 @@
+/* Deferred logging
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include "log_defer.h"
+#include "sched_profile.h"
+
+#if CONFIG_EXAMPLE_LOG_DEFER
+
+#define LOG_DEFER_SLOTS         CONFIG_EXAMPLE_LOG_DEFER_SLOTS
+#define LOG_DEFER_DRAIN_MS      10
+#define LOG_DEFER_TAG_MAX       16
+
+_Static_assert((LOG_DEFER_SLOTS & (LOG_DEFER_SLOTS - 1)) == 0,
+               "CONFIG_EXAMPLE_LOG_DEFER_SLOTS must be a power of two");
+
+typedef struct {
+    /* pos + 1 once the line for pos is written, pos + LOG_DEFER_SLOTS once
+     * it was drained and the slot is free for the next round */
+    atomic_uint seq;
+    uint32_t    order;
+    uint16_t    len;
+    char        line[LOG_DEFER_LINE_MAX];
+} log_slot_t;
+
+typedef struct {
+    atomic_uint head;       /* next position to claim */
+    uint32_t    tail;       /* next position to drain */
+    log_slot_t  slots[LOG_DEFER_SLOTS];
+} log_ring_t;
+
+typedef struct {
+    char        tag[LOG_DEFER_TAG_MAX];
+    const char *last;       /* pointer last matched, tags are mostly static */
+    int64_t     interval_us;
+    int64_t     tolerance_us;
+    int64_t     tat;        /* theoretical arrival time of the next line */
+} log_rate_t;
+
+static log_ring_t rings[portNUM_PROCESSORS];
+static atomic_uint order;
+static vprintf_like_t console;
+static SemaphoreHandle_t drain_lock;
+
+static log_rate_t rates[LOG_DEFER_MAX_RATES];
+static atomic_int n_rates;
+static portMUX_TYPE rate_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static atomic_uint stat_written;
+static atomic_uint stat_dropped;
+static atomic_uint stat_rate_limited;
+static atomic_uint stat_truncated;
+static atomic_uint stat_high_water;
+
+/* ESP_LOGx formats start with "<level> (%u) %s: ", optionally behind a
+ * color sequence; the timestamp may also be a "%s" */
+static const char *log_tag(const char *format, va_list args)
+{
+    const char *p = format;
+    const char *tag = NULL;
+    va_list copy;
+
+    while (*p && *p != '(' && p - format < 12) {
+        p++;
+    }
+    if (*p != '(' || p[1] != '%' || strncmp(p + 3, ") %s: ", 6) != 0) {
+        return NULL;
+    }
+    va_copy(copy, args);
+    if (p[2] == 'u') {
+        (void)va_arg(copy, unsigned);
+        tag = va_arg(copy, const char *);
+    } else if (p[2] == 's') {
+        (void)va_arg(copy, const char *);
+        tag = va_arg(copy, const char *);
+    }
+    va_end(copy);
+    return tag;
+}
+
+/* Generic cell rate algorithm: one line per interval, tolerance lines early */
+static bool log_rate_allow(const char *tag)
+{
+    int n = atomic_load_explicit(&n_rates, memory_order_acquire);
+    bool allow = true;
+
+    for (int i = 0; i < n; i++) {
+        log_rate_t *r = &rates[i];
+        if (r->last != tag && strcmp(r->tag, tag) != 0) {
+            continue;
+        }
+        int64_t now = esp_timer_get_time();
+        portENTER_CRITICAL(&rate_lock);
+        r->last = tag;
+        if (r->interval_us) {
+            if (now < r->tat - r->tolerance_us) {
+                allow = false;
+            } else {
+                r->tat = (r->tat > now ? r->tat : now) + r->interval_us;
+            }
+        }
+        portEXIT_CRITICAL(&rate_lock);
+        break;
+    }
+    return allow;
+}
+
+static int log_defer_vprintf(const char *format, va_list args)
+{
+    const char *tag = log_tag(format, args);
+    log_ring_t *ring = &rings[xPortGetCoreID()];
+    log_slot_t *slot;
+    unsigned pos;
+
+    if (tag && !log_rate_allow(tag)) {
+        atomic_fetch_add_explicit(&stat_rate_limited, 1, memory_order_relaxed);
+        return 0;
+    }
+
+    pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    for (;;) {
+        slot = &ring->slots[pos % LOG_DEFER_SLOTS];
+        int diff = (int)(atomic_load_explicit(&slot->seq, memory_order_acquire) - pos);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ring->head, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            /* Not drained yet from the previous round: full */
+            atomic_fetch_add_explicit(&stat_dropped, 1, memory_order_relaxed);
+            return 0;
+        } else {
+            pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        }
+    }
+
+    int len = vsnprintf(slot->line, sizeof(slot->line), format, args);
+    if (len < 0) {
+        len = 0;
+    } else if (len >= (int)sizeof(slot->line)) {
+        len = sizeof(slot->line) - 1;
+        slot->line[len - 1] = '\n';
+        atomic_fetch_add_explicit(&stat_truncated, 1, memory_order_relaxed);
+    }
+    slot->len = len;
+    slot->order = atomic_fetch_add_explicit(&order, 1, memory_order_relaxed);
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+
+    unsigned used = pos + 1 - ring->tail;
+    unsigned high = atomic_load_explicit(&stat_high_water, memory_order_relaxed);
+    if (used > high && used <= LOG_DEFER_SLOTS) {
+        atomic_compare_exchange_strong_explicit(&stat_high_water, &high, used,
+                                                memory_order_relaxed, memory_order_relaxed);
+    }
+    atomic_fetch_add_explicit(&stat_written, 1, memory_order_relaxed);
+    return len;
+}
+
+static int log_console(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int ret = console(format, args);
+    va_end(args);
+    return ret;
+}
+
+/* Writes the oldest ready line of all rings. Returns false when none is. */
+static bool log_drain_one(void)
+{
+    log_ring_t *oldest = NULL;
+    log_slot_t *slot = NULL;
+
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        log_ring_t *ring = &rings[c];
+        log_slot_t *s = &ring->slots[ring->tail % LOG_DEFER_SLOTS];
+        if (atomic_load_explicit(&s->seq, memory_order_acquire) != ring->tail + 1) {
+            continue;
+        }
+        if (slot == NULL || (int32_t)(s->order - slot->order) < 0) {
+            oldest = ring;
+            slot = s;
+        }
+    }
+    if (slot == NULL) {
+        return false;
+    }
+    log_console("%.*s", (int)slot->len, slot->line);
+    atomic_store_explicit(&slot->seq, oldest->tail + LOG_DEFER_SLOTS, memory_order_release);
+    oldest->tail++;
+    return true;
+}
+
+void log_defer_flush(void)
+{
+    if (drain_lock == NULL) {
+        return;
+    }
+    xSemaphoreTake(drain_lock, portMAX_DELAY);
+    while (log_drain_one()) {
+    }
+    xSemaphoreGive(drain_lock);
+}
+
+static void log_drain_task(void *arg)
+{
+    for (;;) {
+        log_defer_flush();
+        vTaskDelay(pdMS_TO_TICKS(LOG_DEFER_DRAIN_MS));
+    }
+}
+
+esp_err_t log_defer_init(void)
+{
+    if (drain_lock) {
+        return ESP_OK;
+    }
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        for (unsigned i = 0; i < LOG_DEFER_SLOTS; i++) {
+            atomic_init(&rings[c].slots[i].seq, i);
+        }
+    }
+    drain_lock = xSemaphoreCreateMutex();
+    if (drain_lock == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (sched_task_create(SCHED_BACKGROUND, log_drain_task, "log_drain", NULL, NULL) != pdPASS) {
+        vSemaphoreDelete(drain_lock);
+        drain_lock = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    console = esp_log_set_vprintf(log_defer_vprintf);
+    return ESP_OK;
+}
+
+esp_err_t log_defer_set_rate(const char *tag, uint16_t per_second, uint16_t burst)
+{
+    int n = atomic_load(&n_rates);
+    int i;
+
+    if (strlen(tag) >= LOG_DEFER_TAG_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (i = 0; i < n; i++) {
+        if (strcmp(rates[i].tag, tag) == 0) {
+            break;
+        }
+    }
+    if (i == LOG_DEFER_MAX_RATES) {
+        return ESP_ERR_NO_MEM;
+    }
+    portENTER_CRITICAL(&rate_lock);
+    strcpy(rates[i].tag, tag);
+    rates[i].interval_us = per_second ? 1000000 / per_second : 0;
+    rates[i].tolerance_us = rates[i].interval_us * burst;
+    rates[i].tat = 0;
+    portEXIT_CRITICAL(&rate_lock);
+    if (i == n) {
+        atomic_store_explicit(&n_rates, n + 1, memory_order_release);
+    }
+    return ESP_OK;
+}
+
+void log_defer_get_stats(log_defer_stats_t *stats)
+{
+    stats->written = atomic_load(&stat_written);
+    stats->dropped = atomic_load(&stat_dropped);
+    stats->rate_limited = atomic_load(&stat_rate_limited);
+    stats->truncated = atomic_load(&stat_truncated);
+    stats->high_water = atomic_load(&stat_high_water);
+}
+
+#else /* !CONFIG_EXAMPLE_LOG_DEFER */
+
+esp_err_t log_defer_init(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t log_defer_set_rate(const char *tag, uint16_t per_second, uint16_t burst)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void log_defer_flush(void)
+{
+}
+
+void log_defer_get_stats(log_defer_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+
+#endif
@@ -0,0 +1,42 @@
+/* Deferred logging
+
+   log_defer_init() installs a vprintf hook with esp_log_set_vprintf(), so
+   ESP_LOGx calls stay as they are. The hook formats each line into a slot of
+   its core's ring buffer and returns; a low priority task drains the rings
+   to the console in the order the lines were written. Slots are claimed
+   without a lock (a bounded queue with per-slot sequence numbers), so a
+   writer preempted midway holds up the drain but no other writer.
+
+   A full ring drops the line and counts it. Lines are cut at
+   LOG_DEFER_LINE_MAX. log_defer_set_rate() limits a tag to a steady rate
+   with a burst on top; lines over the limit are dropped before formatting.
+   Lines still in the rings are lost on a panic.
+*/
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#define LOG_DEFER_LINE_MAX      120
+#define LOG_DEFER_MAX_RATES     8
+
+typedef struct {
+    uint32_t written;       /* lines queued */
+    uint32_t dropped;       /* lines lost to a full ring */
+    uint32_t rate_limited;  /* lines over their tag's rate */
+    uint32_t truncated;     /* lines cut at LOG_DEFER_LINE_MAX */
+    uint32_t high_water;    /* most slots of one ring in use */
+} log_defer_stats_t;
+
+/* Starts the drain task and installs the hook. Without
+ * CONFIG_EXAMPLE_LOG_DEFER this does nothing. */
+esp_err_t log_defer_init(void);
+
+/* At most per_second lines of tag, after a burst of burst lines. A rate of
+ * 0 removes the limit. */
+esp_err_t log_defer_set_rate(const char *tag, uint16_t per_second, uint16_t burst);
+
+/* Writes everything queued so far from the calling task */
+void log_defer_flush(void);
+
+void log_defer_get_stats(log_defer_stats_t *stats);
@@ -9,6 +9,8 @@
 
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
@@ -30,7 +32,28 @@
 #include "lwip/err.h"
 #include "lwip/sys.h"
 
-#include "index.h"
+#include "arena.h"
+#include "assets_data.h"
+#include "batch.h"
+#include "boot.h"
+#include "connmgr.h"
+#include "device.h"
+#include "http_async.h"
+#include "log_defer.h"
+#include "metrics.h"
+#include "persist.h"
+#include "pin_group.h"
+#include "proto.h"
+#include "resp_cache.h"
+#include "router.h"
+#include "sched_profile.h"
+#include "state.h"
+#include "state_poll.h"
+#include "trace.h"
+#include "uart_capture.h"
+#include "uart_link.h"
+#include "upload.h"
+#include "ws.h"
 
 /* A simple example that demonstrates how to create GET and POST
  * handlers for the web server.
@@ -50,7 +73,6 @@
 
 static const char *TAG = "wifi-srv";
 
-uint8_t ledIsOn = 0;
 
 uint8_t uart_tx[UART_BUFFER_SIZE];
 uint8_t uart_rx[UART_BUFFER_SIZE];
@@ -60,6 +82,10 @@ typedef struct {
     const char* msg;
 } my_struct_t;
 
+/* Items kept in NVS, see init_persist() */
+static int persist_state = -1;
+static int persist_route = -1;
+
 void init_uart(void);
 
 
@@ -70,10 +96,12 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
         wifi_event_ap_staconnected_t* event = (wifi_event_ap_staconnected_t*) event_data;
         ESP_LOGI(TAG, "station "MACSTR" join, AID=%d",
                  MAC2STR(event->mac), event->aid);
+        metrics_wifi_station(true);
     } else if (event_id == WIFI_EVENT_AP_STADISCONNECTED) {
         wifi_event_ap_stadisconnected_t* event = (wifi_event_ap_stadisconnected_t*) event_data;
         ESP_LOGI(TAG, "station "MACSTR" leave, AID=%d",
                  MAC2STR(event->mac), event->aid);
+        metrics_wifi_station(false);
     }
 }
 
@@ -81,69 +109,57 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
 /* An HTTP GET handler */
 static esp_err_t hello_get_handler(httpd_req_t *req)
 {
+    static const char *const hdrs[] = {
+        "Custom-Header-1", "Custom-Value-1",
+        "Custom-Header-2", "Custom-Value-2",
+        NULL
+    };
+    esp_err_t ret;
+
+    /* A repeated request is answered from the cache without the logging */
+    if ((ret = resp_cache_send(req)) != ESP_ERR_NOT_FOUND) {
+        return ret;
+    }
+
+    /* Header and query buffers come from the session's arena */
+    arena_t *arena = arena_begin(req);
     char*  buf;
-    size_t buf_len;
-
-    /* Get header value string length and allocate memory for length + 1,
-     * extra byte for null termination */
-    buf_len = httpd_req_get_hdr_value_len(req, "Host") + 1;
-    if (buf_len > 1) {
-        buf = malloc(buf_len);
-        /* Copy null terminated value string into buffer */
-        if (httpd_req_get_hdr_value_str(req, "Host", buf, buf_len) == ESP_OK) {
-            ESP_LOGI(TAG, "Found header => Host: %s", buf);
-        }
-        free(buf);
+
+    if (arena == NULL) {
+        return httpd_resp_send_500(req);
     }
 
-    buf_len = httpd_req_get_hdr_value_len(req, "Test-Header-2") + 1;
-    if (buf_len > 1) {
-        buf = malloc(buf_len);
-        if (httpd_req_get_hdr_value_str(req, "Test-Header-2", buf, buf_len) == ESP_OK) {
-            ESP_LOGI(TAG, "Found header => Test-Header-2: %s", buf);
-        }
-        free(buf);
+    if ((buf = arena_hdr(arena, req, "Host")) != NULL) {
+        ESP_LOGI(TAG, "Found header => Host: %s", buf);
+    }
+    if ((buf = arena_hdr(arena, req, "Test-Header-2")) != NULL) {
+        ESP_LOGI(TAG, "Found header => Test-Header-2: %s", buf);
+    }
+    if ((buf = arena_hdr(arena, req, "Test-Header-1")) != NULL) {
+        ESP_LOGI(TAG, "Found header => Test-Header-1: %s", buf);
     }
 
-    buf_len = httpd_req_get_hdr_value_len(req, "Test-Header-1") + 1;
-    if (buf_len > 1) {
-        buf = malloc(buf_len);
-        if (httpd_req_get_hdr_value_str(req, "Test-Header-1", buf, buf_len) == ESP_OK) {
-            ESP_LOGI(TAG, "Found header => Test-Header-1: %s", buf);
+    /* Read URL query string */
+    if ((buf = arena_query(arena, req)) != NULL) {
+        ESP_LOGI(TAG, "Found URL query => %s", buf);
+        char param[32];
+        /* Get value of expected key from query string */
+        if (httpd_query_key_value(buf, "query1", param, sizeof(param)) == ESP_OK) {
+            ESP_LOGI(TAG, "Found URL query parameter => query1=%s", param);
         }
-        free(buf);
-    }
-
-    /* Read URL query string length and allocate memory for length + 1,
-     * extra byte for null termination */
-    buf_len = httpd_req_get_url_query_len(req) + 1;
-    if (buf_len > 1) {
-        buf = malloc(buf_len);
-        if (httpd_req_get_url_query_str(req, buf, buf_len) == ESP_OK) {
-            ESP_LOGI(TAG, "Found URL query => %s", buf);
-            char param[32];
-            /* Get value of expected key from query string */
-            if (httpd_query_key_value(buf, "query1", param, sizeof(param)) == ESP_OK) {
-                ESP_LOGI(TAG, "Found URL query parameter => query1=%s", param);
-            }
-            if (httpd_query_key_value(buf, "query3", param, sizeof(param)) == ESP_OK) {
-                ESP_LOGI(TAG, "Found URL query parameter => query3=%s", param);
-            }
-            if (httpd_query_key_value(buf, "query2", param, sizeof(param)) == ESP_OK) {
-                ESP_LOGI(TAG, "Found URL query parameter => query2=%s", param);
-            }
+        if (httpd_query_key_value(buf, "query3", param, sizeof(param)) == ESP_OK) {
+            ESP_LOGI(TAG, "Found URL query parameter => query3=%s", param);
+        }
+        if (httpd_query_key_value(buf, "query2", param, sizeof(param)) == ESP_OK) {
+            ESP_LOGI(TAG, "Found URL query parameter => query2=%s", param);
         }
-        free(buf);
     }
+    arena_end(arena);
 
-    /* Set some custom headers */
-    httpd_resp_set_hdr(req, "Custom-Header-1", "Custom-Value-1");
-    httpd_resp_set_hdr(req, "Custom-Header-2", "Custom-Value-2");
-
-    /* Send response with custom headers and body set as the
+    /* Send response with some custom headers and body set as the
      * string passed in user context*/
     const char* resp_str = (const char*) req->user_ctx;
-    httpd_resp_send(req, resp_str, HTTPD_RESP_USE_STRLEN);
+    resp_cache_answer(req, state_version(), 0, HTTPD_TYPE_TEXT, hdrs, resp_str, strlen(resp_str));
 
     /* After sending the HTTP response the old HTTP request
      * headers are lost. Check if HTTP request headers can be read now. */
@@ -162,13 +178,35 @@ static const httpd_uri_t hello = {
     .user_ctx  = "Hello World!"
 };
 
+/* State listeners: the GPIO follows the store, WebSocket clients are told
+ * about every change */
+static void led_apply(const device_state_t *state, void *arg)
+{
+    gpio_set_level(LED, state->led);
+}
+
+static void state_push(const device_state_t *state, void *arg)
+{
+    char msg[STATE_JSON_MAX];
+    uint8_t bin[PROTO_MAX_MSG];
+
+    state_to_json(state, msg, sizeof(msg));
+    ws_publish(msg, bin, proto_state(state, bin, sizeof(bin)));
+}
+
 static esp_err_t led_get_handler(httpd_req_t *req) {
     const my_struct_t *pmy = (my_struct_t*)req->user_ctx;
-    gpio_set_level(LED, pmy->led_state);
+    esp_err_t ret;
+
+    /* A hit means the state has not changed since this route last set
+     * the LED, so it is still at this level */
+    if ((ret = resp_cache_send(req)) != ESP_ERR_NOT_FOUND) {
+        return ret;
+    }
+    uint32_t version = device_led_set(pmy->led_state);
     char resp_str[50];
-    sprintf(resp_str, "%d", pmy->led_state);
-    httpd_resp_send(req, resp_str, HTTPD_RESP_USE_STRLEN);
-    return ESP_OK;
+    int len = sprintf(resp_str, "%d", pmy->led_state);
+    return resp_cache_answer(req, version, 0, HTTPD_TYPE_TEXT, NULL, resp_str, len);
 }
 
 my_struct_t my_on = {
@@ -195,36 +233,27 @@ static const httpd_uri_t led_off = {
     .user_ctx  = &my_off
 };
 
-/* An HTTP POST handler */
+/* An HTTP POST handler: echoes the body, ?sink=discard or ?sink=checksum
+ * only count it */
 static esp_err_t echo_post_handler(httpd_req_t *req)
 {
-    char buf[100];
-    int ret, remaining = req->content_len;
-
-    while (remaining > 0) {
-        /* Read the data for the request */
-        if ((ret = httpd_req_recv(req, buf,
-                        MIN(remaining, sizeof(buf)))) <= 0) {
-            if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
-                /* Retry receiving if timeout occurred */
-                continue;
-            }
-            return ESP_FAIL;
-        }
-
-        /* Send back the same data */
-        httpd_resp_send_chunk(req, buf, ret);
-        remaining -= ret;
+    const upload_sink_t *sink = &upload_sink_echo;
+    arena_t *arena = arena_begin(req);
+    char *query;
+    char name[12];
 
-        /* Log data received */
-        ESP_LOGI(TAG, "=========== RECEIVED DATA ==========");
-        ESP_LOGI(TAG, "%.*s", ret, buf);
-        ESP_LOGI(TAG, "====================================");
+    if (arena == NULL) {
+        return httpd_resp_send_500(req);
     }
-
-    // End response
-    httpd_resp_send_chunk(req, NULL, 0);
-    return ESP_OK;
+    if ((query = arena_query(arena, req)) != NULL &&
+            httpd_query_key_value(query, "sink", name, sizeof(name)) == ESP_OK) {
+        sink = upload_sink_find(name);
+    }
+    arena_end(arena);
+    if (sink == NULL) {
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "sink must be echo, discard or checksum");
+    }
+    return upload_receive(req, sink);
 }
 
 static const httpd_uri_t echo = {
@@ -236,8 +265,9 @@ static const httpd_uri_t echo = {
 
 /* This handler allows the custom error handling functionality to be
  * tested from client side. For that, when a PUT request 0 is sent to
- * URI /ctrl, the /hello and /echo URIs are unregistered and following
- * custom error handler http_404_error_handler() is registered.
+ * URI /ctrl, the "basic" route profile without the /hello and /echo URIs
+ * and with the following custom error handler http_404_error_handler()
+ * is applied.
  * Afterwards, when /hello or /echo is requested, this custom error
  * handler is invoked which, after sending an error message to client,
  * either closes the underlying socket (when requested URI is /echo)
@@ -261,38 +291,44 @@ esp_err_t http_404_error_handler(httpd_req_t *req, httpd_err_code_t err)
     return ESP_FAIL;
 }
 
-/* An HTTP PUT handler. This demonstrates realtime
- * registration and deregistration of URI handlers
+/* Route profiles for /ctrl, the first one applies on start */
+static const char *const basic_disabled[] = { "/hello", "/echo", NULL };
+
+static const router_profile_t route_profiles[] = {
+    { .name = "full",  .alias = "1" },
+    { .name = "basic", .alias = "0", .disabled = basic_disabled,
+      .not_found = http_404_error_handler },
+};
+
+/* An HTTP PUT handler. This demonstrates realtime reconfiguration of the
+ * URI handlers: the body names a route profile (or is the old 0/1 flag),
+ * which is switched to as a whole.
  */
 static esp_err_t ctrl_put_handler(httpd_req_t *req)
 {
-    char buf;
+    char buf[32];
     int ret;
 
-    if ((ret = httpd_req_recv(req, &buf, 1)) <= 0) {
+    if (req->content_len == 0 || req->content_len >= sizeof(buf)) {
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "expected a profile name");
+    }
+    if ((ret = httpd_req_recv(req, buf, req->content_len)) <= 0) {
         if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
             httpd_resp_send_408(req);
         }
         return ESP_FAIL;
     }
+    buf[ret] = '\0';
+    buf[strcspn(buf, " \t\r\n")] = '\0';
 
-    if (buf == '0') {
-        /* URI handlers can be unregistered using the uri string */
-        ESP_LOGI(TAG, "Unregistering /hello and /echo URIs");
-        httpd_unregister_uri(req->handle, "/hello");
-        httpd_unregister_uri(req->handle, "/echo");
-        /* Register the custom error handler */
-        httpd_register_err_handler(req->handle, HTTPD_404_NOT_FOUND, http_404_error_handler);
-    }
-    else {
-        ESP_LOGI(TAG, "Registering /hello and /echo URIs");
-        httpd_register_uri_handler(req->handle, &hello);
-        httpd_register_uri_handler(req->handle, &echo);
-        /* Unregister custom error handler */
-        httpd_register_err_handler(req->handle, HTTPD_404_NOT_FOUND, NULL);
+    if (router_apply(buf) != ESP_OK) {
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "unknown profile");
     }
+    persist_touch(persist_route);
+    ESP_LOGI(TAG, "Route profile %s", router_profile());
 
-    /* Respond with empty body */
+    /* Respond with empty body, the profile in use goes in a header */
+    httpd_resp_set_hdr(req, "X-Route-Profile", router_profile());
     httpd_resp_send(req, NULL, 0);
     return ESP_OK;
 }
@@ -305,33 +341,42 @@ static const httpd_uri_t ctrl = {
 };
 
 
+/* The footer's uptime and free heap may lag this much behind */
+#define INDEX_CACHE_TTL_MS  5000
+#define INDEX_TYPE          "text/html; charset=UTF-8"
+
 static esp_err_t index_get_handler(httpd_req_t *req) {
-    int i;
-    int sz;
-    int rep = 0;
-    int lvl = gpio_get_level(LED);
-    char buf[1813] = {0};
-    const char *led_lvl = lvl ? "ON " : "OFF";
-    const char *led_cls = lvl ? "on " : "off";
-    for(i = 0; i < index_htm_len; i++) {
-        buf[i] = index_htm[i];
-        if(i > 3 && buf[i-2] == 'C' && buf[i-1] == 'C' && buf[i] == 'C') {
-            buf[i-2] = led_cls[0];
-            buf[i-1] = led_cls[1];
-            buf[i] = led_cls[2];
-        }
-        if(i > 3 && buf[i-2] == 'T' && buf[i-1] == 'T' && buf[i] == 'T') {
-            buf[i-2] = led_lvl[0];
-            buf[i-1] = led_lvl[1];
-            buf[i] = led_lvl[2];
-        }
+    static const char *const hdrs[] = { "Cache-Control", "no-store", NULL };
+    char uptime[12];
+    char heap[12];
+    device_state_t state;
+    const char *values[INDEX_SLOT_COUNT];
+    esp_err_t ret;
+
+    if ((ret = resp_cache_send(req)) != ESP_ERR_NOT_FOUND) {
+        return ret;
     }
-    buf[i] = 0;
-    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
-    httpd_resp_set_hdr(req, "Content-Type", "text/html; charset=UTF-8");
-    // httpd_resp_send(req, "<!DOCTYPE html><html><head><title>ESP32 Server</title></head><body><center>It works</center></body></html>", 106);
-    httpd_resp_send(req, buf, HTTPD_RESP_USE_STRLEN);
-    return ESP_OK;
+    state_get(&state);
+    int lvl = state.led;
+
+    snprintf(uptime, sizeof(uptime), "%u", (unsigned)(xTaskGetTickCount() / configTICK_RATE_HZ));
+    snprintf(heap, sizeof(heap), "%u", (unsigned)esp_get_free_heap_size());
+    values[INDEX_SLOT_LED_CLASS] = lvl ? "on" : "off";
+    values[INDEX_SLOT_LED_TEXT]  = lvl ? "ON" : "OFF";
+    values[INDEX_SLOT_UPTIME]    = uptime;
+    values[INDEX_SLOT_HEAP]      = heap;
+
+    /* Rendered once into the cache entry if the page can be kept there,
+     * streamed otherwise */
+    size_t len = page_length(&index_page, values);
+    char *body = resp_cache_reserve(req, state.version, INDEX_CACHE_TTL_MS, INDEX_TYPE, hdrs, len);
+    if (body) {
+        page_render(&index_page, values, body, len + 1);
+        return resp_cache_commit(req);
+    }
+    httpd_resp_set_type(req, INDEX_TYPE);
+    httpd_resp_set_hdr(req, hdrs[0], hdrs[1]);
+    return page_send(req, &index_page, values);
 }
 
 static const httpd_uri_t uri_index = {
@@ -341,54 +386,111 @@ static const httpd_uri_t uri_index = {
     .user_ctx  = NULL
 };
 
-static esp_err_t send_handler(httpd_req_t *req) {
-    int rxBytes = 0;
-    char server_string[2] = {0x39, 0}; // 9 - error
-    int timeout = 20;
-
-    uart_tx[0] = 0xAA;
-    uart_tx[1] = 0x55;
-    uart_tx[2] = 0x00;
-    uart_tx[3] = 0x55;
-
-    if(ledIsOn) {
-        uart_tx[2] = 0x00;
-        ledIsOn = 0;
-        server_string[0] = 0x37;
+typedef struct {
+    http_async_t *async;
+    ws_client_t ws; /* WebSocket client that asked, if async is NULL */
+    uint8_t addr;
+} send_ctx_t;
+
+/* Runs in the UART link task once the peer answered or the timeout expired */
+static void send_done(const char *answers, size_t n, void *arg)
+{
+    send_ctx_t *ctx = (send_ctx_t *)arg;
+    char server_string[2] = {answers[0], 0};
+
+    device_peer_apply(ctx->addr, answers[0]);
+    ESP_LOGD(TAG, "send => %s", server_string);
+    if (ctx->async) {
+        http_async_send(ctx->async, HTTPD_200, HTTPD_TYPE_TEXT, server_string, HTTPD_RESP_USE_STRLEN);
     } else {
-        uart_tx[2] = 0x01;
-        ledIsOn = 1;
-        server_string[0] = 0x38;
+        char msg[16];
+        snprintf(msg, sizeof(msg), "{\"send\":\"%s\"}", server_string);
+        ws_send_to(ctx->ws, msg);
     }
+    free(ctx);
+}
 
-    uart_write_bytes(UART_NUM_1, uart_tx, 4);
-    uart_flush_input(UART_NUM_1);
+/* Sends the toggle command to the UART peer at addr. The answer goes to
+ * the detached HTTP request or, without one, to the WebSocket client ws. */
+static esp_err_t send_start(http_async_t *async, const ws_client_t *ws, uint8_t addr)
+{
+    device_peer_tx_t tx;
+    send_ctx_t *ctx = malloc(sizeof(send_ctx_t));
+
+    if (ctx == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    ctx->async = async;
+    if (ws) {
+        ctx->ws = *ws;
+    }
+    ctx->addr = addr;
+    device_peer_begin(&tx, addr);
+    device_peer_toggle(&tx);
+
+    esp_err_t ret = device_peer_commit(&tx, send_done, ctx);
+    if (ret != ESP_OK) {
+        free(ctx);
+    }
+    return ret;
+}
+
+/* The reply is awaited by the task of the peer's UART channel, the
+ * response is sent from there. ?dev=N addresses another peer than the
+ * primary one. */
+static esp_err_t send_handler(httpd_req_t *req) {
+    char query[16];
+    char dev[4];
+    long addr = DEVICE_PEER_PRIMARY;
+    http_async_t *async;
+
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "dev", dev, sizeof(dev)) == ESP_OK) {
+        char *end;
+        addr = strtol(dev, &end, 10);
+        if (*end != '\0' || addr < 0 || addr > DEVICE_PEER_MAX_ADDR) {
+            return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "bad device address");
+        }
+    }
 
-    // while (rxBytes < 1 && timeout > 0) {
-    //     rxBytes = uart_read_bytes(UART_NUM_1, uart_rx, 2, 200 / portTICK_RATE_MS);
-    //     timeout--;
-    // }
-    // if(rxBytes > 0) {
-    //     if(uart_rx[0] == 0xAA) {
-    //         if(uart_rx[1] == 0x31) {
-    //             gpio_set_level(LED, 1);
-    //             server_string[0] = 0x31;
-    //         } else {
-    //             gpio_set_level(LED, 0);
-    //             server_string[0] = 0x30;
-    //         }
-    //     }
-    //     // if(uart_rx[0] == 0xAA && uart_rx[1] == 0x55) {
-    //     //     // if(uart_rx[0] == 0xAA) {
-
-    //     //     // }
-    //     //     server_string[0] = (char)uart_rx[2];
-    //     // }
-    // }
-    httpd_resp_send(req, server_string, HTTPD_RESP_USE_STRLEN);
+    async = http_async_begin(req);
+    if (async == NULL) {
+        return httpd_resp_send_500(req);
+    }
+    esp_err_t ret = send_start(async, NULL, addr);
+    if (ret == ESP_ERR_NOT_FOUND) {
+        http_async_send(async, HTTPD_404, HTTPD_TYPE_TEXT, "unknown device", HTTPD_RESP_USE_STRLEN);
+    } else if (ret != ESP_OK) {
+        /* Too many requests in flight, answer like a failed exchange */
+        http_async_send(async, HTTPD_200, HTTPD_TYPE_TEXT, "9", HTTPD_RESP_USE_STRLEN);
+    }
     return ESP_OK;
 }
 
+/* Commands of WebSocket clients: on, off, send and state */
+static void ws_command(httpd_req_t *req, const char *cmd)
+{
+    char msg[STATE_JSON_MAX];
+    device_state_t state;
+
+    if (strcmp(cmd, "on") == 0) {
+        device_led_set(1);
+    } else if (strcmp(cmd, "off") == 0) {
+        device_led_set(0);
+    } else if (strcmp(cmd, "send") == 0) {
+        ws_client_t client = ws_client(req);
+        if (send_start(NULL, &client, DEVICE_PEER_PRIMARY) != ESP_OK) {
+            ws_reply(req, "{\"send\":\"9\"}");
+        }
+    } else if (strcmp(cmd, "state") == 0) {
+        state_get(&state);
+        state_to_json(&state, msg, sizeof(msg));
+        ws_reply(req, msg);
+    } else {
+        ws_reply(req, "{\"error\":\"unknown command\"}");
+    }
+}
+
 static const httpd_uri_t uri_send = {
     .uri       = "/send",
     .method    = HTTP_GET,
@@ -396,10 +498,15 @@ static const httpd_uri_t uri_send = {
     .user_ctx  = NULL
 };
 
-void wifi_init_softap(void)
+/* The TCP/IP stack and the event loop, all the server needs to listen */
+static void init_netif(void)
 {
     ESP_ERROR_CHECK(esp_netif_init());
     ESP_ERROR_CHECK(esp_event_loop_create_default());
+}
+
+void wifi_init_softap(void)
+{
     esp_netif_create_default_wifi_ap();
 
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
@@ -433,24 +540,62 @@ void wifi_init_softap(void)
              EXAMPLE_ESP_WIFI_SSID, EXAMPLE_ESP_WIFI_PASS, EXAMPLE_ESP_WIFI_CHANNEL);
 }
 
+static esp_err_t server_open_fn(httpd_handle_t hd, int sockfd)
+{
+    metrics_session_opened(hd, sockfd);
+    return connmgr_session_opened(hd, sockfd);
+}
+
+static void server_close_fn(httpd_handle_t hd, int sockfd)
+{
+    metrics_session_closed(sockfd);
+    connmgr_session_closed(sockfd);
+    http_async_session_closed(sockfd);
+    state_poll_session_closed(sockfd);
+    ws_session_closed(sockfd);
+    uart_capture_session_closed(sockfd);
+    close(sockfd);
+}
+
 static httpd_handle_t start_webserver(void)
 {
     httpd_handle_t server = NULL;
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    /* Only a fallback, connmgr picks the sessions to close */
     config.lru_purge_enable = true;
+    /* The router takes the routes, the httpd only needs its dispatch
+     * handlers and the WebSocket */
+    config.max_uri_handlers = 8;
+    config.uri_match_fn = httpd_uri_match_wildcard;
+    config.open_fn = server_open_fn;
+    config.close_fn = server_close_fn;
+    sched_httpd_config(&config);
 
     // Start the httpd server
     ESP_LOGI(TAG, "Starting server on port: '%d'", config.server_port);
     if (httpd_start(&server, &config) == ESP_OK) {
         // Set URI handlers
         ESP_LOGI(TAG, "Registering URI handlers");
-        httpd_register_uri_handler(server, &uri_index);
-        httpd_register_uri_handler(server, &hello);
-        httpd_register_uri_handler(server, &echo);
-        httpd_register_uri_handler(server, &ctrl);
-        httpd_register_uri_handler(server, &led_on);
-        httpd_register_uri_handler(server, &led_off);
-        httpd_register_uri_handler(server, &uri_send);
+        connmgr_init(server, &config);
+        connmgr_set_bulk("/echo");
+        router_register_uri(server, &uri_index);
+        router_register_uri(server, &hello);
+        router_register_uri(server, &echo);
+        router_register_uri(server, &ctrl);
+        router_register_uri(server, &led_on);
+        router_register_uri(server, &led_off);
+        router_register_uri(server, &uri_send);
+        ws_register(server, ws_command, proto_ws_message);
+        state_poll_register(server);
+        batch_register(server);
+        proto_register(server);
+        pin_group_register(server);
+        assets_register(server);
+        metrics_register(server, &config);
+        trace_register(server);
+        boot_register(server);
+        uart_capture_register(server);
+        router_start(server);
         #if CONFIG_EXAMPLE_BASIC_AUTH
         httpd_register_basic_auth(server);
         #endif
@@ -489,43 +634,243 @@ static httpd_handle_t start_webserver(void)
 // }
 
 
+/* One channel per UART peer. UART0 carries the console. */
+static const uart_link_config_t uart_channels[] = {
+    {
+        .port       = UART_NUM_1,
+        .tx_pin     = GPIO_NUM_4,
+        .rx_pin     = GPIO_NUM_5,
+        .baud_rate  = CONFIG_EXAMPLE_UART_BAUD_RATE,
+        .timeout_ms = CONFIG_EXAMPLE_UART_REPLY_TIMEOUT_MS,
+        .addr       = DEVICE_PEER_PRIMARY,
+    },
+#ifdef CONFIG_EXAMPLE_UART2_PEER
+    {
+        .port       = UART_NUM_2,
+        .tx_pin     = GPIO_NUM_17,
+        .rx_pin     = GPIO_NUM_16,
+        .baud_rate  = CONFIG_EXAMPLE_UART2_BAUD_RATE,
+        .timeout_ms = CONFIG_EXAMPLE_UART2_REPLY_TIMEOUT_MS,
+        .addr       = CONFIG_EXAMPLE_UART2_ADDR,
+    },
+#endif
+};
+
 void init_uart() {
-    const uart_config_t uart_config = {
-        .baud_rate  = 115200,
-        .data_bits  = UART_DATA_8_BITS,
-        .parity     = UART_PARITY_DISABLE,
-        .stop_bits  = UART_STOP_BITS_1,
-        .flow_ctrl  = UART_HW_FLOWCTRL_DISABLE,
-        .source_clk = UART_SCLK_APB
-    };
-    int rx_buf_size = UART_BUFFER_SIZE * 2;
-    uart_driver_install(UART_NUM_1, rx_buf_size, 0, 20, NULL, 0);
-    uart_param_config(UART_NUM_1, &uart_config);
-    //                         TX = 4       RX = 5
-    uart_set_pin(UART_NUM_1, GPIO_NUM_4, GPIO_NUM_5, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    for (size_t i = 0; i < sizeof(uart_channels) / sizeof(uart_channels[0]); i++) {
+        ESP_ERROR_CHECK(uart_link_add(&uart_channels[i]));
+    }
 }
 
+/* Output groups for /pins, wired in Kconfig (EXAMPLE_PIN_GROUPn_PINS).
+ * There are none by default, so no pin is driven unless configured. */
+static const struct {
+    const char *name;
+    const char *pins;
+} pin_group_specs[] = {
+    { CONFIG_EXAMPLE_PIN_GROUP1_NAME, CONFIG_EXAMPLE_PIN_GROUP1_PINS },
+    { CONFIG_EXAMPLE_PIN_GROUP2_NAME, CONFIG_EXAMPLE_PIN_GROUP2_PINS },
+};
+#define PIN_GROUPS_MAX  (sizeof(pin_group_specs) / sizeof(pin_group_specs[0]))
 
+static gpio_num_t group_pins[PIN_GROUPS_MAX][PIN_GROUP_MAX_PINS + 1];
+static pin_group_config_t pin_groups[PIN_GROUPS_MAX];
+static size_t n_pin_groups;
+static int persist_pins[PIN_GROUPS_MAX];
 
-void app_main(void)
+/* "18,19,21" into GPIO_NUM_NC terminated pins; pin_group_init() checks
+ * them. An empty list is no group. */
+static esp_err_t parse_pin_groups(void)
+{
+    for (size_t i = 0; i < PIN_GROUPS_MAX; i++) {
+        const char *p = pin_group_specs[i].pins;
+        gpio_num_t *pins = group_pins[n_pin_groups];
+        size_t n = 0;
+
+        while (*p != '\0') {
+            char *end;
+            long pin = strtol(p, &end, 10);
+
+            if (end == p || n == PIN_GROUP_MAX_PINS) {
+                ESP_LOGE(TAG, "pin group %s: bad GPIO list \"%s\"",
+                         pin_group_specs[i].name, pin_group_specs[i].pins);
+                return ESP_ERR_INVALID_ARG;
+            }
+            pins[n++] = (gpio_num_t)pin;
+            p = end + strspn(end, ", ");
+        }
+        if (n == 0) {
+            continue;
+        }
+        pins[n] = GPIO_NUM_NC;
+        pin_groups[n_pin_groups].name = pin_group_specs[i].name;
+        pin_groups[n_pin_groups].pins = pins;
+        n_pin_groups++;
+    }
+    return ESP_OK;
+}
+
+/* Persistent items: the LED levels, the route profile and the pin group
+ * levels. Values are stored as they are in memory. */
+static size_t state_save(void *buf, size_t size, void *arg)
+{
+    device_state_t state;
+    uint8_t *levels = buf;
+
+    state_get(&state);
+    levels[0] = state.led;
+    levels[1] = state.peer_led;
+    return 2;
+}
+
+static void state_restored(device_state_t *state, void *arg)
+{
+    const uint8_t *levels = arg;
+
+    state->led = levels[0];
+    state->peer_led = levels[1];
+}
+
+static void state_restore(const void *buf, size_t len, void *arg)
+{
+    if (len == 2) {
+        state_update(state_restored, (void *)buf, NULL);
+    }
+}
+
+static void state_persist(const device_state_t *state, void *arg)
+{
+    persist_touch(persist_state);
+}
+
+static size_t route_save(void *buf, size_t size, void *arg)
+{
+    int len = snprintf(buf, size, "%s", router_profile());
+
+    /* At most size, a longer name is cut (and not restored) */
+    return len < (int)size ? (size_t)len : size - 1;
+}
+
+static void route_restore(const void *buf, size_t len, void *arg)
+{
+    char name[PERSIST_MAX_VALUE + 1];
+
+    memcpy(name, buf, len);
+    name[len] = '\0';
+    router_apply(name);
+}
+
+static size_t pins_save(void *buf, size_t size, void *arg)
+{
+    uint32_t value = pin_group_get((intptr_t)arg);
+
+    memcpy(buf, &value, sizeof(value));
+    return sizeof(value);
+}
+
+static void pins_restore(const void *buf, size_t len, void *arg)
 {
+    int group = (intptr_t)arg;
+    uint32_t value;
+
+    if (len == sizeof(value)) {
+        memcpy(&value, buf, sizeof(value));
+        pin_group_set(group, value, (uint32_t)((1ULL << pin_group_pins(group)) - 1));
+    }
+}
+
+static void pins_persist(int group, void *arg)
+{
+    persist_touch(persist_pins[group]);
+}
+
+/* Restores everything kept in NVS, before the server starts */
+static void init_persist(void)
+{
+    ESP_ERROR_CHECK(persist_init());
+    persist_state = persist_add("state", state_save, state_restore, NULL);
+    persist_route = persist_add("route", route_save, route_restore, NULL);
+    for (size_t i = 0; i < n_pin_groups; i++) {
+        char key[PERSIST_KEY_MAX + 1];
+        snprintf(key, sizeof(key), "pins.%s", pin_groups[i].name);
+        persist_pins[i] = persist_add(key, pins_save, pins_restore, (void *)(intptr_t)i);
+    }
+    ESP_ERROR_CHECK(state_listen(state_persist, NULL));
+    pin_group_listen(pins_persist, NULL);
+}
+
+
+
+/* Startup steps, see boot.h. Wi-Fi (RF calibration) takes longest; the
+ * server listens as soon as the network stack and the state it serves are
+ * ready, so the first client is answered as soon as it can join. */
+enum {
+    BOOT_NVS,
+    BOOT_UART,
+    BOOT_PINS,
+    BOOT_NETIF,
+    BOOT_STATE,
+    BOOT_HTTPD,
+    BOOT_WIFI,
+};
 
-    //Initialize NVS
+static void init_nvs(void)
+{
     esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
       ESP_ERROR_CHECK(nvs_flash_erase());
       ret = nvs_flash_init();
     }
     ESP_ERROR_CHECK(ret);
+}
 
-    init_uart();
-
+static void init_pins(void)
+{
+    ESP_ERROR_CHECK(parse_pin_groups());
+    ESP_ERROR_CHECK(pin_group_init(&gpio_bank_hw, pin_groups, n_pin_groups));
     gpio_set_direction(LED, GPIO_MODE_OUTPUT);
-    gpio_set_level(LED, 0);
+}
 
-    ESP_LOGI(TAG, "ESP_WIFI_MODE_AP");
-    wifi_init_softap();
+/* The device state with everything restored from NVS. The LED comes up at
+ * its restored level. */
+static void init_state(void)
+{
+    ESP_ERROR_CHECK(state_init());
+    init_persist();
+
+    device_state_t state;
+    state_get(&state);
+    gpio_set_level(LED, state.led);
+    ESP_ERROR_CHECK(state_listen(led_apply, NULL));
+    ESP_ERROR_CHECK(state_listen(state_push, NULL));
+}
+
+static void init_httpd(void)
+{
     (void)start_webserver();
+}
+
+static const boot_step_t boot_steps[] = {
+    [BOOT_NVS]   = { "nvs",   init_nvs },
+    [BOOT_UART]  = { "uart",  init_uart },
+    [BOOT_PINS]  = { "pins",  init_pins },
+    [BOOT_NETIF] = { "netif", init_netif },
+    [BOOT_STATE] = { "state", init_state, BOOT_AFTER(BOOT_NVS) | BOOT_AFTER(BOOT_PINS) },
+    [BOOT_HTTPD] = { "httpd", init_httpd, BOOT_AFTER(BOOT_NETIF) | BOOT_AFTER(BOOT_STATE) |
+                                          BOOT_AFTER(BOOT_UART) },
+    [BOOT_WIFI]  = { "wifi",  wifi_init_softap, BOOT_AFTER(BOOT_NVS) | BOOT_AFTER(BOOT_NETIF) },
+};
+
+void app_main(void)
+{
+    /* Console output leaves the request path; the per-request lines of the
+     * handlers may not crowd out the rest */
+    ESP_ERROR_CHECK(log_defer_init());
+    log_defer_set_rate(TAG, 20, 40);
+
+    router_set_profiles(route_profiles, sizeof(route_profiles) / sizeof(route_profiles[0]));
+    ESP_LOGI(TAG, "ESP_WIFI_MODE_AP");
+    ESP_ERROR_CHECK(boot_run(boot_steps, sizeof(boot_steps) / sizeof(boot_steps[0])));
 
     /*uart_tx[0] = 0x33;
     uart_tx[1] = 0x33;
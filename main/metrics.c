@@ -0,0 +1,544 @@
+/* Server metrics
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <esp_log.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+
+#include "arena.h"
+#include "boot.h"
+#include "connmgr.h"
+#include "log_defer.h"
+#include "metrics.h"
+#include "persist.h"
+#include "resp_cache.h"
+#include "router.h"
+#include "sched_profile.h"
+#include "trace.h"
+#include "uart_capture.h"
+#include "uart_link.h"
+
+static const char *TAG = "metrics";
+
+#define METRICS_CODE_NONE       0
+#define METRICS_CODE_OTHER      999
+#define METRICS_CHUNK           512
+
+/* Upper bounds of the latency buckets, +Inf follows */
+static const uint32_t bucket_us[] = {
+    1000, 5000, 10000, 50000, 100000, 500000, 1000000, 5000000
+};
+static const char *const bucket_le[] = {
+    "0.001", "0.005", "0.01", "0.05", "0.1", "0.5", "1", "5"
+};
+#define METRICS_BUCKETS (sizeof(bucket_us) / sizeof(bucket_us[0]))
+
+/* Tasks whose stack high-water mark is reported, if they exist */
+static const char *const watched_tasks[] = {
+    "httpd", "uart_link0", "uart_link1", "uart_link2", "log_drain", "persist",
+    "main", "tiT", "esp_timer",
+};
+
+typedef struct {
+    const char     *uri;
+    httpd_method_t  method;
+    esp_err_t     (*handler)(httpd_req_t *r);
+    void           *user_ctx;
+    bool            websocket;
+    uint8_t         n_codes;
+    uint16_t        codes[METRICS_MAX_CODES];
+    uint32_t        code_counts[METRICS_MAX_CODES];
+    uint32_t        buckets[METRICS_BUCKETS + 1];
+    uint32_t        count;
+    uint64_t        sum_us;
+} route_t;
+
+typedef struct {
+    int             fd;             /* -1 if unused */
+    route_t        *pending;        /* request waiting for its status line */
+    int64_t         start_us;
+    bool            peer_closed;
+    bool            failed;
+} session_t;
+
+static route_t routes[METRICS_MAX_ROUTES];
+static int n_routes;
+static session_t sessions[METRICS_MAX_SESSIONS] = {
+    [0 ... METRICS_MAX_SESSIONS - 1] = { .fd = -1 },
+};
+static int open_sessions;
+static int max_sessions;
+static uint32_t lru_purges;
+static uint32_t sessions_total;
+
+static atomic_uint wifi_joins;
+static atomic_uint wifi_leaves;
+
+static const char *const method_names[] = {
+    [HTTP_DELETE] = "DELETE",
+    [HTTP_GET]    = "GET",
+    [HTTP_HEAD]   = "HEAD",
+    [HTTP_POST]   = "POST",
+    [HTTP_PUT]    = "PUT",
+};
+
+static session_t *session_get(int fd)
+{
+    for (int i = 0; i < METRICS_MAX_SESSIONS; i++) {
+        if (sessions[i].fd == fd) {
+            return &sessions[i];
+        }
+    }
+    return NULL;
+}
+
+static void metrics_record(route_t *route, unsigned code, int64_t us)
+{
+    int i;
+
+    for (i = 0; i < route->n_codes; i++) {
+        if (route->codes[i] == code) {
+            break;
+        }
+    }
+    if (i == route->n_codes) {
+        if (route->n_codes < METRICS_MAX_CODES) {
+            route->codes[route->n_codes++] = code;
+        } else {
+            i = METRICS_MAX_CODES - 1;
+            route->codes[i] = METRICS_CODE_OTHER;
+        }
+    }
+    route->code_counts[i]++;
+
+    for (i = 0; i < (int)METRICS_BUCKETS && us > bucket_us[i]; i++) {
+    }
+    route->buckets[i]++;
+    route->count++;
+    route->sum_us += us;
+}
+
+/* The request still waiting for a status line gets none */
+static void session_settle(session_t *s)
+{
+    if (s->pending) {
+        metrics_record(s->pending, METRICS_CODE_NONE, esp_timer_get_time() - s->start_us);
+        s->pending = NULL;
+    }
+}
+
+static esp_err_t metrics_handler(httpd_req_t *req)
+{
+    route_t *route = req->user_ctx;
+    session_t *s = session_get(httpd_req_to_sockfd(req));
+    esp_err_t ret;
+
+    req->user_ctx = route->user_ctx;
+    if (s) {
+        session_settle(s);
+        s->pending = route;
+        s->start_us = esp_timer_get_time();
+    }
+    TRACE_BEGIN(route->uri, httpd_req_to_sockfd(req));
+    ret = route->handler(req);
+    TRACE_END(route->uri, ret);
+    if (s) {
+        if (route->websocket) {
+            session_settle(s);
+        }
+        if (ret != ESP_OK) {
+            s->failed = true;
+        }
+    }
+    return ret;
+}
+
+/* Default socket I/O plus a look at every response head */
+static int metrics_send(httpd_handle_t hd, int sockfd, const char *buf, size_t buf_len, int flags)
+{
+    session_t *s = session_get(sockfd);
+
+    if (buf_len >= 12 && memcmp(buf, "HTTP/1.1 ", 9) == 0) {
+        boot_served();
+        if (s && s->pending) {
+            unsigned code = (buf[9] - '0') * 100 + (buf[10] - '0') * 10 + (buf[11] - '0');
+            metrics_record(s->pending, code, esp_timer_get_time() - s->start_us);
+            s->pending = NULL;
+        }
+    }
+    TRACE_BEGIN("send", buf_len);
+    int ret = send(sockfd, buf, buf_len, flags);
+    TRACE_END("send", ret);
+    if (ret < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            return HTTPD_SOCK_ERR_TIMEOUT;
+        }
+        if (s) {
+            s->failed = true;
+        }
+        return HTTPD_SOCK_ERR_FAIL;
+    }
+    return ret;
+}
+
+static int metrics_recv(httpd_handle_t hd, int sockfd, char *buf, size_t buf_len, int flags)
+{
+    session_t *s = session_get(sockfd);
+
+    TRACE_BEGIN("recv", buf_len);
+    int ret = recv(sockfd, buf, buf_len, flags);
+    TRACE_END("recv", ret);
+
+    if (ret < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            return HTTPD_SOCK_ERR_TIMEOUT;
+        }
+        if (s) {
+            s->failed = true;
+        }
+        return HTTPD_SOCK_ERR_FAIL;
+    }
+    if (ret == 0 && s) {
+        s->peer_closed = true;
+    }
+    return ret;
+}
+
+void metrics_session_opened(httpd_handle_t hd, int sockfd)
+{
+    session_t *s = session_get(-1);
+
+    sessions_total++;
+    open_sessions++;
+    if (s == NULL) {
+        return;
+    }
+    *s = (session_t) { .fd = sockfd };
+    httpd_sess_set_send_override(hd, sockfd, metrics_send);
+    httpd_sess_set_recv_override(hd, sockfd, metrics_recv);
+}
+
+void metrics_session_closed(int sockfd)
+{
+    session_t *s = session_get(sockfd);
+
+    /* Closed by the server while every socket was taken and nothing went
+     * wrong: room for a new connection */
+    if (s && !s->peer_closed && !s->failed && open_sessions >= max_sessions) {
+        lru_purges++;
+    }
+    if (s) {
+        session_settle(s);
+        s->fd = -1;
+    }
+    open_sessions--;
+}
+
+void metrics_wifi_station(bool joined)
+{
+    atomic_fetch_add(joined ? &wifi_joins : &wifi_leaves, 1);
+}
+
+void metrics_wrap_uri(const httpd_uri_t *uri, httpd_uri_t *wrapped)
+{
+    route_t *route = NULL;
+
+    *wrapped = *uri;
+    for (int i = 0; i < n_routes; i++) {
+        if (routes[i].method == uri->method && strcmp(routes[i].uri, uri->uri) == 0) {
+            route = &routes[i];
+            break;
+        }
+    }
+    if (route == NULL) {
+        if (n_routes == METRICS_MAX_ROUTES) {
+            ESP_LOGW(TAG, "%s not counted, no route slot left", uri->uri);
+            return;
+        }
+        route = &routes[n_routes++];
+        route->uri = uri->uri;
+        route->method = uri->method;
+    }
+    /* A route registered again keeps its counters */
+    route->handler = uri->handler;
+    route->user_ctx = uri->user_ctx;
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+    route->websocket = uri->is_websocket;
+#endif
+    wrapped->handler = metrics_handler;
+    wrapped->user_ctx = route;
+}
+
+esp_err_t metrics_register_uri(httpd_handle_t server, const httpd_uri_t *uri)
+{
+    httpd_uri_t wrapped;
+
+    metrics_wrap_uri(uri, &wrapped);
+    return httpd_register_uri_handler(server, &wrapped);
+}
+
+/* Prometheus text output in chunks */
+typedef struct {
+    httpd_req_t    *req;
+    size_t          len;
+    char            buf[METRICS_CHUNK];
+} out_t;
+
+static void out_printf(out_t *out, const char *format, ...)
+{
+    va_list args;
+    int n;
+
+    for (int retry = 0; retry < 2; retry++) {
+        va_start(args, format);
+        n = vsnprintf(out->buf + out->len, sizeof(out->buf) - out->len, format, args);
+        va_end(args);
+        if (n >= 0 && (size_t)n < sizeof(out->buf) - out->len) {
+            out->len += n;
+            return;
+        }
+        /* Did not fit: send what is there and try again on an empty buffer */
+        httpd_resp_send_chunk(out->req, out->buf, out->len);
+        out->len = 0;
+    }
+}
+
+static void out_header(out_t *out, const char *name, const char *type, const char *help)
+{
+    out_printf(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+static void out_routes(out_t *out)
+{
+    out_header(out, "http_requests_total", "counter", "Requests per route and status code.");
+    for (int r = 0; r < n_routes; r++) {
+        const route_t *route = &routes[r];
+        for (int i = 0; i < route->n_codes; i++) {
+            char code[8];
+            if (route->codes[i] == METRICS_CODE_NONE) {
+                strcpy(code, "none");
+            } else if (route->codes[i] == METRICS_CODE_OTHER) {
+                strcpy(code, "other");
+            } else {
+                snprintf(code, sizeof(code), "%u", route->codes[i]);
+            }
+            out_printf(out, "http_requests_total{route=\"%s\",method=\"%s\",code=\"%s\"} %u\n",
+                       route->uri, method_names[route->method], code, (unsigned)route->code_counts[i]);
+        }
+    }
+
+    out_header(out, "http_request_duration_seconds", "histogram", "Time to the response head.");
+    for (int r = 0; r < n_routes; r++) {
+        const route_t *route = &routes[r];
+        const char *m = method_names[route->method];
+        uint32_t cumulative = 0;
+        if (route->count == 0) {
+            continue;
+        }
+        for (size_t i = 0; i < METRICS_BUCKETS; i++) {
+            cumulative += route->buckets[i];
+            out_printf(out, "http_request_duration_seconds_bucket{route=\"%s\",method=\"%s\",le=\"%s\"} %u\n",
+                       route->uri, m, bucket_le[i], (unsigned)cumulative);
+        }
+        out_printf(out, "http_request_duration_seconds_bucket{route=\"%s\",method=\"%s\",le=\"+Inf\"} %u\n"
+                   "http_request_duration_seconds_sum{route=\"%s\",method=\"%s\"} %llu.%06llu\n"
+                   "http_request_duration_seconds_count{route=\"%s\",method=\"%s\"} %u\n",
+                   route->uri, m, (unsigned)route->count,
+                   route->uri, m, (unsigned long long)(route->sum_us / 1000000),
+                   (unsigned long long)(route->sum_us % 1000000),
+                   route->uri, m, (unsigned)route->count);
+    }
+}
+
+static void out_gauge(out_t *out, const char *name, const char *type, const char *help, unsigned value)
+{
+    out_header(out, name, type, help);
+    out_printf(out, "%s %u\n", name, value);
+}
+
+/* One series per UART channel, labelled with the port */
+static void out_uart(out_t *out)
+{
+    static const struct {
+        const char *name;
+        const char *type;
+        const char *help;
+        size_t      offset;
+    } series[] = {
+        { "uart_tx_bytes_total", "counter", "Bytes written to the UART peer.",
+          offsetof(uart_link_stats_t, tx_bytes) },
+        { "uart_rx_bytes_total", "counter", "Bytes read from the UART peer.",
+          offsetof(uart_link_stats_t, rx_bytes) },
+        { "uart_tx_writes_total", "counter", "UART writes.", offsetof(uart_link_stats_t, tx_writes) },
+        { "uart_timeouts_total", "counter", "Requests the peer did not answer.",
+          offsetof(uart_link_stats_t, timeouts) },
+        { "uart_crc_errors_total", "counter", "Frames with a bad CRC.", offsetof(uart_link_stats_t, crc_errors) },
+    };
+    uart_link_stats_t st[UART_LINK_MAX_CHANNELS];
+    int n = 0;
+
+    while (n < UART_LINK_MAX_CHANNELS && uart_link_get_stats(n, &st[n])) {
+        n++;
+    }
+    for (size_t s = 0; s < sizeof(series) / sizeof(series[0]); s++) {
+        out_header(out, series[s].name, series[s].type, series[s].help);
+        for (int i = 0; i < n; i++) {
+            out_printf(out, "%s{port=\"%d\"} %u\n", series[s].name, uart_link_channel(i)->port,
+                       (unsigned)*(const uint32_t *)((const char *)&st[i] + series[s].offset));
+        }
+    }
+    out_header(out, "uart_queue_depth", "gauge", "UART requests and driver events waiting.");
+    for (int i = 0; i < n; i++) {
+        int port = uart_link_channel(i)->port;
+        out_printf(out, "uart_queue_depth{port=\"%d\",queue=\"tx\"} %u\n"
+                   "uart_queue_depth{port=\"%d\",queue=\"reply\"} %u\n"
+                   "uart_queue_depth{port=\"%d\",queue=\"events\"} %u\n",
+                   port, (unsigned)st[i].queued, port, (unsigned)st[i].awaiting,
+                   port, (unsigned)st[i].rx_events);
+    }
+}
+
+static esp_err_t metrics_get_handler(httpd_req_t *req)
+{
+    static out_t out;
+    arena_stats_t arena;
+    log_defer_stats_t log;
+    router_stats_t router;
+    connmgr_stats_t conn;
+    resp_cache_stats_t cache;
+    persist_stats_t persist;
+    uart_capture_stats_t capture;
+
+    /* Handlers run one at a time, the buffer stays off the httpd stack */
+    out.req = req;
+    out.len = 0;
+    httpd_resp_set_type(req, "text/plain; version=0.0.4");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+    out_routes(&out);
+
+    int64_t first = boot_first_response_us();
+    if (first >= 0) {
+        out_header(&out, "boot_first_response_seconds", "gauge", "Time from start to the first response.");
+        out_printf(&out, "boot_first_response_seconds %llu.%06llu\n",
+                   (unsigned long long)(first / 1000000), (unsigned long long)(first % 1000000));
+    }
+    out_header(&out, "sched_profile_info", "gauge", "Task layout in use.");
+    out_printf(&out, "sched_profile_info{profile=\"%s\"} 1\n", sched_profile_name(sched_profile()));
+
+    router_get_stats(&router);
+    out_gauge(&out, "router_table_swaps_total", "counter", "Route tables published.", router.swaps);
+    out_gauge(&out, "router_lookups_total", "counter", "Route lookups.", router.lookups);
+    out_gauge(&out, "router_probes_total", "counter", "Extra buckets probed on collisions.", router.probes);
+    out_gauge(&out, "router_not_found_total", "counter", "Requests without a route.", router.not_found);
+
+    out_gauge(&out, "http_sessions_open", "gauge", "Open sessions.", open_sessions);
+    out_gauge(&out, "http_sessions_total", "counter", "Sessions opened.", sessions_total);
+    out_gauge(&out, "http_lru_purges_total", "counter",
+              "Sessions closed by the server to make room for a new one.", lru_purges);
+
+    connmgr_get_stats(&conn);
+    out_gauge(&out, "connmgr_clients", "gauge", "Clients with open sessions.", conn.clients);
+    out_gauge(&out, "connmgr_keepalive_seconds", "gauge", "Idle timeout at the current pressure.",
+              conn.keepalive_s);
+    out_header(&out, "connmgr_decisions_total", "counter", "Sessions closed by the connection manager.");
+    for (int i = 0; i < CONNMGR_REASONS; i++) {
+        out_printf(&out, "connmgr_decisions_total{reason=\"%s\"} %u\n",
+                   connmgr_reason_name(i), (unsigned)conn.decisions[i]);
+    }
+
+    resp_cache_get_stats(&cache);
+    out_header(&out, "resp_cache_lookups_total", "counter", "Response cache lookups by result.");
+    out_printf(&out, "resp_cache_lookups_total{result=\"hit\"} %u\n"
+               "resp_cache_lookups_total{result=\"miss\"} %u\n"
+               "resp_cache_lookups_total{result=\"bypass\"} %u\n",
+               (unsigned)cache.hits, (unsigned)cache.misses, (unsigned)cache.bypassed);
+    out_header(&out, "resp_cache_dropped_total", "counter", "Response cache entries dropped.");
+    out_printf(&out, "resp_cache_dropped_total{reason=\"stale\"} %u\n"
+               "resp_cache_dropped_total{reason=\"evicted\"} %u\n",
+               (unsigned)cache.stale, (unsigned)cache.evicted);
+    out_gauge(&out, "resp_cache_bytes", "gauge", "Memory held by the response cache.", cache.bytes);
+    out_gauge(&out, "resp_cache_entries", "gauge", "Responses in the cache.", cache.entries);
+
+    persist_get_stats(&persist);
+    out_gauge(&out, "persist_changes_total", "counter", "Changes to persistent settings.", persist.changes);
+    out_gauge(&out, "persist_writes_total", "counter", "Settings written to NVS.", persist.writes);
+    out_gauge(&out, "persist_commits_total", "counter", "NVS commits.", persist.commits);
+    out_header(&out, "persist_writes_saved_total", "counter", "NVS writes avoided.");
+    out_printf(&out, "persist_writes_saved_total{reason=\"coalesced\"} %u\n"
+               "persist_writes_saved_total{reason=\"unchanged\"} %u\n",
+               (unsigned)persist.coalesced, (unsigned)persist.unchanged);
+    out_gauge(&out, "persist_errors_total", "counter", "Failed NVS writes.", persist.errors);
+
+    uart_capture_get_stats(&capture);
+    out_gauge(&out, "uart_capture_bytes_total", "counter", "UART bytes captured.", capture.captured);
+    out_gauge(&out, "uart_stream_bytes_total", "counter", "Captured bytes sent to streams.", capture.streamed);
+    out_gauge(&out, "uart_stream_subscribers", "gauge", "Open /uart/stream responses.", capture.subscribers);
+    out_gauge(&out, "uart_stream_overruns_total", "counter",
+              "Times a stream fell behind the capture ring.", capture.overruns);
+    out_gauge(&out, "uart_stream_skipped_bytes_total", "counter",
+              "Bytes streams missed by falling behind.", capture.skipped);
+
+    arena_get_stats(&arena);
+    out_gauge(&out, "heap_free_bytes", "gauge", "Free heap.", arena.heap_free);
+    out_gauge(&out, "heap_min_free_bytes", "gauge", "Lowest free heap since boot.", arena.heap_min_free);
+    out_gauge(&out, "heap_largest_free_block_bytes", "gauge", "Largest free heap block.", arena.heap_largest);
+    out_gauge(&out, "heap_fragmentation_percent", "gauge",
+              "Share of the free heap outside the largest block.", arena.fragmentation);
+    out_gauge(&out, "arena_overflow_blocks_total", "counter",
+              "Request arena blocks taken from the heap.", arena.overflows);
+
+    out_header(&out, "task_stack_high_water_bytes", "gauge", "Least free stack a task ever had.");
+    for (size_t i = 0; i < sizeof(watched_tasks) / sizeof(watched_tasks[0]); i++) {
+        TaskHandle_t task = xTaskGetHandle(watched_tasks[i]);
+        if (task) {
+            out_printf(&out, "task_stack_high_water_bytes{task=\"%s\"} %u\n", watched_tasks[i],
+                       (unsigned)uxTaskGetStackHighWaterMark(task));
+        }
+    }
+
+    out_uart(&out);
+
+    out_gauge(&out, "wifi_station_joins_total", "counter", "Stations that joined the AP.",
+              atomic_load(&wifi_joins));
+    out_gauge(&out, "wifi_station_leaves_total", "counter", "Stations that left the AP.",
+              atomic_load(&wifi_leaves));
+
+    log_defer_get_stats(&log);
+    out_gauge(&out, "log_lines_dropped_total", "counter", "Log lines lost to a full ring.", log.dropped);
+    out_gauge(&out, "log_lines_rate_limited_total", "counter", "Log lines over their tag's rate.",
+              log.rate_limited);
+
+    if (out.len) {
+        httpd_resp_send_chunk(req, out.buf, out.len);
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+static const httpd_uri_t uri_metrics = {
+    .uri       = "/metrics",
+    .method    = HTTP_GET,
+    .handler   = metrics_get_handler,
+    .user_ctx  = NULL
+};
+
+esp_err_t metrics_register(httpd_handle_t server, const httpd_config_t *config)
+{
+    max_sessions = config->max_open_sockets;
+    return router_register_uri(server, &uri_metrics);
+}
@@ -0,0 +1,39 @@
+/* Server metrics
+
+   GET /metrics answers in the Prometheus text format. Handlers registered
+   through the router or with metrics_register_uri() instead of
+   httpd_register_uri_handler() are counted per route: requests by status
+   code and a latency histogram. The status is read from the response head
+   as it is sent, through a send override that metrics_session_opened()
+   installs on every session, so a detached request is counted when its
+   deferred response goes out.
+   Requests without a status line (WebSocket frames, sessions closed before
+   an answer) are counted with code "none".
+
+   Everything on the request path runs in the httpd task and needs no lock:
+   two timer reads and a few increments per request.
+*/
+#pragma once
+
+#include <stdbool.h>
+#include <esp_http_server.h>
+
+#define METRICS_MAX_ROUTES      32
+#define METRICS_MAX_CODES       6       /* per route, more are counted as "other" */
+#define METRICS_MAX_SESSIONS    16
+
+/* Registers /metrics. Needs the server's config for the session limit. */
+esp_err_t metrics_register(httpd_handle_t server, const httpd_config_t *config);
+
+/* Copy of uri with the handler wrapped for counting */
+void metrics_wrap_uri(const httpd_uri_t *uri, httpd_uri_t *wrapped);
+
+/* httpd_register_uri_handler() with the handler wrapped for counting */
+esp_err_t metrics_register_uri(httpd_handle_t server, const httpd_uri_t *uri);
+
+/* Must be called from the server open_fn and close_fn */
+void metrics_session_opened(httpd_handle_t hd, int sockfd);
+void metrics_session_closed(int sockfd);
+
+/* Wi-Fi station joins and leaves, from the event handler */
+void metrics_wifi_station(bool joined);
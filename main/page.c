@@ -0,0 +1,92 @@
+/* Segmented page renderer
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <string.h>
+
+#include "page.h"
+
+static esp_err_t page_send_part(httpd_req_t *req, const char *buf, size_t len)
+{
+    /* A zero length chunk terminates the response, skip empty parts */
+    if (len == 0) {
+        return ESP_OK;
+    }
+    return httpd_resp_send_chunk(req, buf, len);
+}
+
+esp_err_t page_send(httpd_req_t *req, const page_t *page, const char *const *values)
+{
+    esp_err_t err;
+
+    for (size_t i = 0; i < page->n_parts; i++) {
+        const page_part_t *part = &page->parts[i];
+
+        err = page_send_part(req, part->data, part->len);
+        if (err != ESP_OK) {
+            return err;
+        }
+        if (part->slot != PAGE_NO_SLOT && values[part->slot] != NULL) {
+            const char *val = values[part->slot];
+            err = page_send_part(req, val, strlen(val));
+            if (err != ESP_OK) {
+                return err;
+            }
+        }
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+size_t page_length(const page_t *page, const char *const *values)
+{
+    size_t len = page->size;
+
+    for (size_t i = 0; i < page->n_slots; i++) {
+        if (values[i] != NULL) {
+            len += strlen(values[i]);
+        }
+    }
+    return len;
+}
+
+static size_t page_copy(char *buf, size_t size, size_t pos, const char *src, size_t len)
+{
+    if (pos < size) {
+        size_t n = len < size - pos ? len : size - pos;
+        memcpy(buf + pos, src, n);
+    }
+    return pos + len;
+}
+
+size_t page_render(const page_t *page, const char *const *values, char *buf, size_t size)
+{
+    size_t pos = 0;
+
+    for (size_t i = 0; i < page->n_parts; i++) {
+        const page_part_t *part = &page->parts[i];
+
+        pos = page_copy(buf, size, pos, part->data, part->len);
+        if (part->slot != PAGE_NO_SLOT && values[part->slot] != NULL) {
+            pos = page_copy(buf, size, pos, values[part->slot], strlen(values[part->slot]));
+        }
+    }
+    if (size) {
+        buf[pos < size ? pos : size - 1] = '\0';
+    }
+    return pos;
+}
+
+int page_slot_index(const page_t *page, const char *name)
+{
+    for (size_t i = 0; i < page->n_slots; i++) {
+        if (strcmp(page->slot_names[i], name) == 0) {
+            return (int)i;
+        }
+    }
+    return PAGE_NO_SLOT;
+}
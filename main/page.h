@@ -0,0 +1,45 @@
+/* Segmented page renderer
+
+   Pages are split at build time (see main/gen_assets.py) into constant segments with a
+   named slot after each one. At request time the segments and the current
+   slot values are streamed as HTTP chunks (page_send()), so the page is
+   never copied, scanned or limited by a stack buffer. A page that is kept
+   by the response cache is rendered once, straight into its entry
+   (page_render()), and sent from there.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_http_server.h>
+
+#define PAGE_NO_SLOT    (-1)
+
+typedef struct {
+    const char *data;   /* constant segment, lives in flash */
+    uint16_t    len;
+    int16_t     slot;   /* slot sent after the segment, or PAGE_NO_SLOT */
+} page_part_t;
+
+typedef struct {
+    const page_part_t *parts;
+    size_t             n_parts;
+    const char *const *slot_names;
+    size_t             n_slots;
+    size_t             size;    /* total size of all constant segments */
+} page_t;
+
+/* Stream the page. values[] holds one NUL terminated string per slot,
+ * indexed by the slot ids generated together with the page. A NULL value
+ * renders as empty. */
+esp_err_t page_send(httpd_req_t *req, const page_t *page, const char *const *values);
+
+/* Length of the page rendered with values, without rendering it */
+size_t page_length(const page_t *page, const char *const *values);
+
+/* Render the page into buf like snprintf: returns the full length, the
+ * output is cut (and NUL terminated) at size. */
+size_t page_render(const page_t *page, const char *const *values, char *buf, size_t size);
+
+/* Look up a slot id by name, returns PAGE_NO_SLOT if the page has no such slot */
+int page_slot_index(const page_t *page, const char *name);
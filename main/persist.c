@@ -0,0 +1,203 @@
+/* Persistent settings
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <esp_log.h>
+#include <nvs.h>
+
+#include "persist.h"
+#include "sched_profile.h"
+
+static const char *TAG = "persist";
+
+#define PERSIST_NAMESPACE       "srv"
+
+typedef struct {
+    char                key[PERSIST_KEY_MAX + 1];
+    persist_save_t      save;
+    void               *arg;
+    uint32_t            changes;    /* since the last write */
+    size_t              len;        /* of the value in NVS */
+    uint8_t             stored[PERSIST_MAX_VALUE];
+} item_t;
+
+static nvs_handle_t handle;
+static SemaphoreHandle_t wake;
+static SemaphoreHandle_t write_lock;
+static item_t items[PERSIST_MAX_ITEMS];
+static int n_items;
+static uint32_t dirty;
+static portMUX_TYPE dirty_lock = portMUX_INITIALIZER_UNLOCKED;
+static persist_stats_t stats;
+
+/* Marks items dirty again after a failed write, so the writer retries */
+static void persist_retry(uint32_t mask)
+{
+    portENTER_CRITICAL(&dirty_lock);
+    dirty |= mask;
+    portEXIT_CRITICAL(&dirty_lock);
+    xSemaphoreGive(wake);
+}
+
+/* Writes the dirty items and commits them, in the writer task or
+ * persist_flush(). An item counts as stored once the commit succeeded. */
+static void persist_write(void)
+{
+    uint8_t values[PERSIST_MAX_ITEMS][PERSIST_MAX_VALUE];
+    size_t lens[PERSIST_MAX_ITEMS];
+    uint32_t changes[PERSIST_MAX_ITEMS];
+    uint32_t pending;
+    uint32_t written = 0;
+    uint32_t failed = 0;
+    int n_written = 0;
+
+    xSemaphoreTake(write_lock, portMAX_DELAY);
+    portENTER_CRITICAL(&dirty_lock);
+    pending = dirty;
+    dirty = 0;
+    for (int i = 0; i < n_items; i++) {
+        changes[i] = items[i].changes;
+        items[i].changes = 0;
+    }
+    portEXIT_CRITICAL(&dirty_lock);
+
+    for (int i = 0; i < n_items; i++) {
+        item_t *item = &items[i];
+        uint8_t *buf = values[i];
+
+        if (!(pending & (1u << i))) {
+            continue;
+        }
+        stats.coalesced += changes[i] - 1;
+        size_t len = item->save(buf, PERSIST_MAX_VALUE, item->arg);
+        if (len == item->len && memcmp(buf, item->stored, len) == 0) {
+            stats.unchanged++;
+            continue;
+        }
+        esp_err_t ret = nvs_set_blob(handle, item->key, buf, len);
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "%s: %s", item->key, esp_err_to_name(ret));
+            stats.errors++;
+            failed |= 1u << i;
+            continue;
+        }
+        lens[i] = len;
+        stats.writes++;
+        written |= 1u << i;
+        n_written++;
+    }
+    if (written) {
+        esp_err_t ret = nvs_commit(handle);
+        if (ret == ESP_OK) {
+            for (int i = 0; i < n_items; i++) {
+                if (written & (1u << i)) {
+                    memcpy(items[i].stored, values[i], lens[i]);
+                    items[i].len = lens[i];
+                }
+            }
+            stats.commits++;
+        } else {
+            ESP_LOGW(TAG, "commit: %s", esp_err_to_name(ret));
+            stats.errors++;
+            failed |= written;
+        }
+        ESP_LOGD(TAG, "%d items written", n_written);
+    }
+    if (failed) {
+        persist_retry(failed);
+    }
+    xSemaphoreGive(write_lock);
+}
+
+static void persist_task(void *arg)
+{
+    const TickType_t quiet = pdMS_TO_TICKS(CONFIG_EXAMPLE_PERSIST_DELAY_MS);
+    const TickType_t limit = pdMS_TO_TICKS(CONFIG_EXAMPLE_PERSIST_MAX_DELAY_MS);
+
+    for (;;) {
+        xSemaphoreTake(wake, portMAX_DELAY);
+        /* Every change restarts the wait, up to the limit */
+        TickType_t first = xTaskGetTickCount();
+        while (xTaskGetTickCount() - first < limit && xSemaphoreTake(wake, quiet)) {
+        }
+        persist_write();
+    }
+}
+
+esp_err_t persist_init(void)
+{
+    esp_err_t ret = nvs_open(PERSIST_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "cannot open NVS: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    wake = xSemaphoreCreateBinary();
+    write_lock = xSemaphoreCreateMutex();
+    if (wake == NULL || write_lock == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (sched_task_create(SCHED_BACKGROUND, persist_task, "persist", NULL, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "cannot create task");
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+int persist_add(const char *key, persist_save_t save, persist_restore_t restore, void *arg)
+{
+    item_t *item;
+
+    if (n_items == PERSIST_MAX_ITEMS) {
+        ESP_LOGE(TAG, "no room for %s", key);
+        return -1;
+    }
+    item = &items[n_items];
+    snprintf(item->key, sizeof(item->key), "%s", key);
+    item->save = save;
+    item->arg = arg;
+    item->len = sizeof(item->stored);
+    if (nvs_get_blob(handle, item->key, item->stored, &item->len) == ESP_OK) {
+        restore(item->stored, item->len, arg);
+        stats.restored++;
+        ESP_LOGI(TAG, "%s restored", item->key);
+    } else {
+        /* Nothing stored yet, the first change is written */
+        item->len = SIZE_MAX;
+    }
+    return n_items++;
+}
+
+void persist_touch(int id)
+{
+    if (id < 0 || id >= n_items) {
+        return;
+    }
+    portENTER_CRITICAL(&dirty_lock);
+    dirty |= 1u << id;
+    items[id].changes++;
+    stats.changes++;
+    portEXIT_CRITICAL(&dirty_lock);
+    xSemaphoreGive(wake);
+}
+
+void persist_flush(void)
+{
+    persist_write();
+}
+
+void persist_get_stats(persist_stats_t *out)
+{
+    portENTER_CRITICAL(&dirty_lock);
+    *out = stats;
+    portEXIT_CRITICAL(&dirty_lock);
+}
@@ -0,0 +1,53 @@
+/* Persistent settings
+
+   Values that should survive a reset (device state, the route profile, pin
+   group levels) are registered as items under an NVS key. persist_add()
+   restores an item's stored value right away, so items are added during
+   startup before the server runs. Afterwards the owner calls
+   persist_touch() whenever the value changes; that only marks the item
+   dirty. A low priority task writes dirty items once changes have been
+   quiet for CONFIG_EXAMPLE_PERSIST_DELAY_MS, or at the latest after
+   CONFIG_EXAMPLE_PERSIST_MAX_DELAY_MS of steady changes, and commits them
+   together. A burst of changes to an item costs one flash write, and a
+   value that went back to what is stored costs none.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#define PERSIST_MAX_ITEMS       8
+#define PERSIST_MAX_VALUE       32
+#define PERSIST_KEY_MAX         15      /* NVS key length */
+
+/* Copy the current value to buf, return its length (at most size) */
+typedef size_t (*persist_save_t)(void *buf, size_t size, void *arg);
+/* Apply a stored value, at startup */
+typedef void (*persist_restore_t)(const void *buf, size_t len, void *arg);
+
+typedef struct {
+    uint32_t    changes;        /* persist_touch() calls */
+    uint32_t    writes;         /* items written to NVS */
+    uint32_t    commits;        /* batches committed */
+    uint32_t    coalesced;      /* changes merged into a later write of the item */
+    uint32_t    unchanged;      /* writes skipped, the stored value was current */
+    uint32_t    restored;       /* items restored at startup */
+    uint32_t    errors;
+} persist_stats_t;
+
+/* Opens the NVS namespace and starts the writer task, after nvs_flash_init() */
+esp_err_t persist_init(void);
+
+/* Registers an item and restores its stored value, if any. Returns the
+ * item's id for persist_touch(), -1 if there is no room. The key is copied
+ * and truncated to PERSIST_KEY_MAX. */
+int persist_add(const char *key, persist_save_t save, persist_restore_t restore, void *arg);
+
+/* The item's value changed. Cheap and safe from any task. */
+void persist_touch(int id);
+
+/* Write dirty items now */
+void persist_flush(void);
+
+void persist_get_stats(persist_stats_t *stats);
@@ -0,0 +1,275 @@
+/* Named GPIO output groups
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <esp_log.h>
+
+#include "pin_group.h"
+#include "router.h"
+
+static const char *TAG = "pin-group";
+
+/* {"group":"<name>","value":4294967295,"pins":32}, */
+#define PIN_GROUP_JSON_MAX      64
+
+typedef struct {
+    const char *name;
+    uint8_t     n;
+    uint8_t     pins[PIN_GROUP_MAX_PINS];
+    uint64_t    mask;       /* the group's pins in the bank */
+} group_t;
+
+static const gpio_bank_t *bank;
+static group_t *groups;
+static size_t n_groups;
+static pin_group_listener_t listener;
+static void *listener_arg;
+
+/* Spreads the bits of a group value onto the bank's pins */
+static uint64_t group_to_bank(const group_t *g, uint32_t value)
+{
+    uint64_t out = 0;
+
+    for (int i = 0; i < g->n; i++) {
+        if (value & (1u << i)) {
+            out |= 1ULL << g->pins[i];
+        }
+    }
+    return out;
+}
+
+static uint32_t group_from_bank(const group_t *g, uint64_t levels)
+{
+    uint32_t value = 0;
+
+    for (int i = 0; i < g->n; i++) {
+        if (levels & (1ULL << g->pins[i])) {
+            value |= 1u << i;
+        }
+    }
+    return value;
+}
+
+esp_err_t pin_group_init(const gpio_bank_t *b, const pin_group_config_t *config, size_t n)
+{
+    uint64_t used = 0;
+
+    groups = calloc(n, sizeof(group_t));
+    if (n && groups == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    for (size_t i = 0; i < n; i++) {
+        group_t *g = &groups[i];
+
+        g->name = config[i].name;
+        for (const gpio_num_t *pin = config[i].pins; *pin != GPIO_NUM_NC; pin++) {
+            if (g->n == PIN_GROUP_MAX_PINS || *pin < 0 || *pin >= 64 || (used & (1ULL << *pin))) {
+                ESP_LOGE(TAG, "%s: bad or shared pin GPIO%d", g->name, *pin);
+                free(groups);
+                groups = NULL;
+                return ESP_ERR_INVALID_ARG;
+            }
+            g->pins[g->n++] = *pin;
+            g->mask |= 1ULL << *pin;
+            used |= 1ULL << *pin;
+        }
+    }
+    bank = b;
+    n_groups = n;
+    ESP_LOGI(TAG, "%u groups on %s", (unsigned)n, bank->name);
+    /* No groups, no pins to touch */
+    return used ? bank->configure(used) : ESP_OK;
+}
+
+size_t pin_group_count(void)
+{
+    return n_groups;
+}
+
+int pin_group_find(const char *name)
+{
+    for (size_t i = 0; i < n_groups; i++) {
+        if (strcmp(groups[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+const char *pin_group_name(int group)
+{
+    return groups[group].name;
+}
+
+size_t pin_group_pins(int group)
+{
+    return groups[group].n;
+}
+
+esp_err_t pin_group_set(int group, uint32_t value, uint32_t mask)
+{
+    const group_t *g;
+
+    if (group < 0 || (size_t)group >= n_groups) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    g = &groups[group];
+    if (g->n < 32 && (mask >> g->n)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    bank->write(group_to_bank(g, mask), group_to_bank(g, value));
+    if (listener) {
+        listener(group, listener_arg);
+    }
+    return ESP_OK;
+}
+
+uint32_t pin_group_get(int group)
+{
+    return group_from_bank(&groups[group], bank->read());
+}
+
+void pin_group_listen(pin_group_listener_t fn, void *arg)
+{
+    listener_arg = arg;
+    listener = fn;
+}
+
+static int group_json(char *buf, size_t size, int group, uint64_t levels)
+{
+    const group_t *g = &groups[group];
+
+    return snprintf(buf, size, "{\"group\":\"%s\",\"value\":%u,\"pins\":%u}",
+                    g->name, (unsigned)group_from_bank(g, levels), g->n);
+}
+
+/* The group named in the query, -1 if there is no query */
+static int query_group(httpd_req_t *req, bool *unknown)
+{
+    char query[48];
+    char name[32];
+
+    *unknown = false;
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK ||
+        httpd_query_key_value(query, "group", name, sizeof(name)) != ESP_OK) {
+        return -1;
+    }
+    int group = pin_group_find(name);
+    *unknown = group < 0;
+    return group;
+}
+
+static esp_err_t pins_get_handler(httpd_req_t *req)
+{
+    char buf[PIN_GROUP_JSON_MAX];
+    bool unknown;
+    int group = query_group(req, &unknown);
+    /* One read for all groups, so they are consistent with each other */
+    uint64_t levels = bank->read();
+
+    if (unknown) {
+        return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "unknown group");
+    }
+    httpd_resp_set_type(req, HTTPD_TYPE_JSON);
+    if (group >= 0) {
+        int len = group_json(buf, sizeof(buf), group, levels);
+        return httpd_resp_send(req, buf, len);
+    }
+    httpd_resp_send_chunk(req, "[", 1);
+    for (size_t i = 0; i < n_groups; i++) {
+        int len = group_json(buf, sizeof(buf), i, levels);
+        if (i) {
+            httpd_resp_send_chunk(req, ",", 1);
+        }
+        httpd_resp_send_chunk(req, buf, len);
+    }
+    httpd_resp_send_chunk(req, "]", 1);
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+/* ESP_ERR_NOT_FOUND if the form has no such key, *out is left alone */
+static esp_err_t form_u32(const char *form, const char *key, uint32_t *out)
+{
+    char val[16];
+    char *end;
+
+    if (httpd_query_key_value(form, key, val, sizeof(val)) != ESP_OK) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    unsigned long v = strtoul(val, &end, 0);
+    if (*end != '\0' || end == val || v > UINT32_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out = v;
+    return ESP_OK;
+}
+
+static esp_err_t pins_put_handler(httpd_req_t *req)
+{
+    char body[48];
+    char buf[PIN_GROUP_JSON_MAX];
+    uint32_t value;
+    uint32_t mask;
+    bool unknown;
+    int group = query_group(req, &unknown);
+    int ret;
+
+    if (group < 0) {
+        return httpd_resp_send_err(req, unknown ? HTTPD_404_NOT_FOUND : HTTPD_400_BAD_REQUEST,
+                                   unknown ? "unknown group" : "expected ?group=NAME");
+    }
+    if (req->content_len == 0 || req->content_len >= sizeof(body)) {
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "expected value=V[&mask=M]");
+    }
+    if ((ret = httpd_req_recv(req, body, req->content_len)) <= 0) {
+        if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
+            httpd_resp_send_408(req);
+        }
+        return ESP_FAIL;
+    }
+    body[ret] = '\0';
+    body[strcspn(body, " \t\r\n")] = '\0';
+
+    mask = groups[group].n < 32 ? (1u << groups[group].n) - 1 : UINT32_MAX;
+    if (form_u32(body, "value", &value) != ESP_OK ||
+        form_u32(body, "mask", &mask) == ESP_ERR_INVALID_ARG ||
+        pin_group_set(group, value, mask) != ESP_OK) {
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "bad value or mask");
+    }
+    ESP_LOGD(TAG, "%s: 0x%x/0x%x", groups[group].name, (unsigned)value, (unsigned)mask);
+
+    httpd_resp_set_type(req, HTTPD_TYPE_JSON);
+    ret = group_json(buf, sizeof(buf), group, bank->read());
+    return httpd_resp_send(req, buf, ret);
+}
+
+static const httpd_uri_t uri_pins_get = {
+    .uri       = "/pins",
+    .method    = HTTP_GET,
+    .handler   = pins_get_handler,
+    .user_ctx  = NULL
+};
+
+static const httpd_uri_t uri_pins_put = {
+    .uri       = "/pins",
+    .method    = HTTP_PUT,
+    .handler   = pins_put_handler,
+    .user_ctx  = NULL
+};
+
+esp_err_t pin_group_register(httpd_handle_t server)
+{
+    esp_err_t ret = router_register_uri(server, &uri_pins_get);
+    if (ret == ESP_OK) {
+        ret = router_register_uri(server, &uri_pins_put);
+    }
+    return ret;
+}
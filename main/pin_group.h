@@ -0,0 +1,58 @@
+/* Named GPIO output groups
+
+   A group is a list of output pins switched together, bit n of a group
+   value being the n-th pin. pin_group_set() turns a value and a mask into
+   a single write of the GPIO bank (see gpio_bank.h), so every pin of the
+   update changes within a bus cycle; pin_group_get() reads all of them
+   back as one value. Groups must not share pins.
+
+   Over HTTP:
+
+     GET /pins                      every group
+     GET /pins?group=NAME           one group
+     PUT /pins?group=NAME           body value=V[&mask=M], the mask defaults
+                                    to every pin of the group
+
+   Values are decimal or 0x hex; the answer is {"group":NAME,"value":V,
+   "pins":N} per group.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_http_server.h>
+#include "driver/gpio.h"
+#include "gpio_bank.h"
+
+#define PIN_GROUP_MAX_PINS      32
+
+typedef struct {
+    const char          *name;
+    const gpio_num_t    *pins;      /* terminated by GPIO_NUM_NC */
+} pin_group_config_t;
+
+/* Configures the pins of every group as outputs, driven low. The arrays
+ * must stay valid. */
+esp_err_t pin_group_init(const gpio_bank_t *bank, const pin_group_config_t *groups, size_t n);
+
+size_t pin_group_count(void);
+
+/* Index of the group with this name, -1 if there is none */
+int pin_group_find(const char *name);
+
+const char *pin_group_name(int group);
+
+/* Number of pins in the group */
+size_t pin_group_pins(int group);
+
+/* Drive the pins selected by mask to the matching bits of value */
+esp_err_t pin_group_set(int group, uint32_t value, uint32_t mask);
+
+uint32_t pin_group_get(int group);
+
+/* Called after every pin_group_set(), from the caller's task */
+typedef void (*pin_group_listener_t)(int group, void *arg);
+
+void pin_group_listen(pin_group_listener_t fn, void *arg);
+
+esp_err_t pin_group_register(httpd_handle_t server);
@@ -0,0 +1,287 @@
+/* Binary control protocol
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <esp_log.h>
+
+#include "device.h"
+#include "http_async.h"
+#include "pin_group.h"
+#include "proto.h"
+#include "router.h"
+#include "ws.h"
+
+static const char *TAG = "proto";
+
+#define HTTPD_413           "413 Payload Too Large"
+#define PROTO_TYPE          "application/octet-stream"
+
+typedef struct {
+    http_async_t   *async;      /* the detached HTTP request, or */
+    ws_client_t     ws;         /* the WebSocket client, fd -1 for HTTP */
+    uint8_t         dev;        /* of the peer commands */
+    size_t          n;
+    proto_msg_t     reqs[PROTO_MAX_REQUESTS];
+    uint8_t         peer[PROTO_MAX_REQUESTS];   /* index of the peer command */
+} proto_job_t;
+
+/* Decodes all requests. Returns 0 or an error code with *bad the id of
+ * the request at fault. */
+static int proto_parse(proto_job_t *job, const uint8_t *data, size_t len, size_t *peers, uint8_t *bad)
+{
+    size_t pos = 0;
+
+    job->n = 0;
+    *peers = 0;
+    while (pos < len) {
+        proto_msg_t *m = &job->reqs[job->n];
+        int used;
+
+        *bad = data[pos];
+        if (job->n == PROTO_MAX_REQUESTS) {
+            return PROTO_ERR_TOO_MANY;
+        }
+        used = proto_decode(data + pos, len - pos, m);
+        if (used < 0 || m->id >= 0x80) {
+            return PROTO_ERR_UNKNOWN;
+        }
+        if (used == 0) {
+            return PROTO_ERR_TRUNCATED;
+        }
+        if ((m->id == PROTO_LED && m->led.level > 1) || (m->id == PROTO_PEER && m->peer.level > 1)) {
+            return PROTO_ERR_ARG;
+        }
+        if (m->id == PROTO_SEND || m->id == PROTO_PEER) {
+            uint8_t dev = m->id == PROTO_SEND ? m->send.dev : m->peer.dev;
+            if (dev > DEVICE_PEER_MAX_ADDR) {
+                return PROTO_ERR_ARG;
+            }
+            if (*peers && dev != job->dev) {
+                return PROTO_ERR_PEERS;
+            }
+            if (*peers == DEVICE_PEER_MAX_CMDS) {
+                return PROTO_ERR_TOO_MANY;
+            }
+            job->dev = dev;
+            job->peer[job->n] = (*peers)++;
+        }
+        pos += used;
+        job->n++;
+    }
+    return 0;
+}
+
+static size_t proto_error(uint8_t id, uint8_t code, uint8_t *buf, size_t size)
+{
+    const proto_msg_t msg = {
+        .id = PROTO_ERROR,
+        .error = { .id = id, .code = code },
+    };
+    return proto_encode(&msg, buf, size);
+}
+
+size_t proto_state(const device_state_t *state, uint8_t *buf, size_t size)
+{
+    const proto_msg_t msg = {
+        .id = PROTO_STATE_ANS,
+        .state_ans = { .version = state->version, .led = state->led, .peer = state->peer_led },
+    };
+    return proto_encode(&msg, buf, size);
+}
+
+/* send_ans.answer for a device answer (the /send characters) */
+static uint8_t proto_answer(char answer)
+{
+    switch (answer) {
+    case DEVICE_ANSWER_OFF:         return PROTO_ANSWER_OFF;
+    case DEVICE_ANSWER_ON:          return PROTO_ANSWER_ON;
+    case DEVICE_ANSWER_SILENT_OFF:
+    case DEVICE_ANSWER_SILENT_ON:   return PROTO_ANSWER_NO_REPLY;
+    case DEVICE_ANSWER_BUSY:        return PROTO_ANSWER_BUSY;
+    default:                        return PROTO_ANSWER_BAD_REPLY;
+    }
+}
+
+/* The answers go to the WebSocket client, the request being handled or
+ * the detached one */
+static void proto_deliver(proto_job_t *job, httpd_req_t *req, const uint8_t *buf, size_t len)
+{
+    if (job->ws.fd >= 0) {
+        if (req) {
+            ws_reply_bin(req, buf, len);
+        } else {
+            ws_send_bin_to(job->ws, buf, len);
+        }
+    } else if (req) {
+        httpd_resp_set_type(req, PROTO_TYPE);
+        httpd_resp_send(req, (const char *)buf, len);
+    } else {
+        http_async_send(job->async, HTTPD_200, PROTO_TYPE, (const char *)buf, len);
+    }
+}
+
+/* Runs the requests in order and sends the answers. answers holds one
+ * answer per peer command, NULL if no channel serves the device. */
+static void proto_run(proto_job_t *job, httpd_req_t *req, const char *answers)
+{
+    uint8_t out[PROTO_MAX_REQUESTS * PROTO_MAX_MSG];
+    device_state_t state;
+    size_t len = 0;
+
+    for (size_t i = 0; i < job->n; i++) {
+        const proto_msg_t *m = &job->reqs[i];
+        proto_msg_t a = { .id = PROTO_ERROR, .error = { .id = m->id, .code = PROTO_ERR_ARG } };
+
+        switch (m->id) {
+        case PROTO_LED:
+            device_led_set(m->led.level);
+            /* fall through */
+        case PROTO_STATE:
+            state_get(&state);
+            a.id = PROTO_STATE_ANS;
+            a.state_ans.version = state.version;
+            a.state_ans.led = state.led;
+            a.state_ans.peer = state.peer_led;
+            break;
+        case PROTO_SEND:
+        case PROTO_PEER:
+            if (answers == NULL) {
+                a.error.code = PROTO_ERR_DEVICE;
+                break;
+            }
+            device_peer_apply(job->dev, answers[job->peer[i]]);
+            a.id = PROTO_SEND_ANS;
+            a.send_ans.dev = job->dev;
+            a.send_ans.answer = proto_answer(answers[job->peer[i]]);
+            break;
+        case PROTO_PINS_SET:
+            if (pin_group_set(m->pins_set.group, m->pins_set.value, m->pins_set.mask) != ESP_OK) {
+                break;
+            }
+            /* fall through */
+        case PROTO_PINS_GET:
+            /* group is the first field of both */
+            if (m->pins_get.group >= pin_group_count()) {
+                break;
+            }
+            a.id = PROTO_PINS_ANS;
+            a.pins_ans.group = m->pins_get.group;
+            a.pins_ans.value = pin_group_get(m->pins_get.group);
+            break;
+        }
+        len += proto_encode(&a, out + len, sizeof(out) - len);
+    }
+    proto_deliver(job, req, out, len);
+    free(job);
+}
+
+/* Runs in the UART link task once the peer answered or the timeout expired */
+static void proto_done(const char *answers, size_t n, void *arg)
+{
+    proto_run(arg, NULL, answers);
+}
+
+/* Decodes and runs the requests of an HTTP body or, with ws, a WebSocket
+ * message */
+static esp_err_t proto_start(httpd_req_t *req, bool ws, const uint8_t *data, size_t len)
+{
+    char answers[DEVICE_PEER_MAX_CMDS];
+    uint8_t err[PROTO_MAX_MSG];
+    device_peer_tx_t tx;
+    size_t peers;
+    uint8_t bad;
+    proto_job_t *job = malloc(sizeof(proto_job_t));
+    int code;
+
+    if (job == NULL) {
+        return ws ? ESP_ERR_NO_MEM : httpd_resp_send_500(req);
+    }
+    job->async = NULL;
+    job->ws = ws ? ws_client(req) : (ws_client_t){ .fd = -1 };
+    code = proto_parse(job, data, len, &peers, &bad);
+    if (code) {
+        size_t n = proto_error(bad, code, err, sizeof(err));
+        ESP_LOGD(TAG, "request 0x%02x rejected: %d", bad, code);
+        free(job);
+        if (ws) {
+            return ws_reply_bin(req, err, n);
+        }
+        httpd_resp_set_status(req, HTTPD_400);
+        httpd_resp_set_type(req, PROTO_TYPE);
+        return httpd_resp_send(req, (const char *)err, n);
+    }
+    if (peers == 0) {
+        proto_run(job, req, NULL);
+        return ESP_OK;
+    }
+
+    /* The commanded peer states follow the request order */
+    device_peer_begin(&tx, job->dev);
+    for (size_t i = 0; i < job->n; i++) {
+        if (job->reqs[i].id == PROTO_SEND) {
+            device_peer_toggle(&tx);
+        } else if (job->reqs[i].id == PROTO_PEER) {
+            device_peer_set(&tx, job->reqs[i].peer.level);
+        }
+    }
+    if (!ws && (job->async = http_async_begin(req)) == NULL) {
+        free(job);
+        return httpd_resp_send_500(req);
+    }
+    esp_err_t ret = device_peer_commit(&tx, proto_done, job);
+    if (ret == ESP_ERR_NOT_FOUND) {
+        proto_run(job, NULL, NULL);
+    } else if (ret != ESP_OK) {
+        /* Too many requests in flight, answer like a failed exchange */
+        memset(answers, DEVICE_ANSWER_BUSY, peers);
+        proto_run(job, NULL, answers);
+    }
+    return ESP_OK;
+}
+
+void proto_ws_message(httpd_req_t *req, const uint8_t *data, size_t len)
+{
+    proto_start(req, true, data, len);
+}
+
+static esp_err_t proto_post_handler(httpd_req_t *req)
+{
+    uint8_t body[PROTO_MAX_BODY];
+    size_t received = 0;
+    int ret;
+
+    if (req->content_len > PROTO_MAX_BODY) {
+        httpd_resp_set_status(req, HTTPD_413);
+        return httpd_resp_sendstr(req, "too many requests");
+    }
+    while (received < req->content_len) {
+        ret = httpd_req_recv(req, (char *)body + received, req->content_len - received);
+        if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
+            continue;
+        }
+        if (ret <= 0) {
+            return ESP_FAIL;
+        }
+        received += ret;
+    }
+    return proto_start(req, false, body, received);
+}
+
+static const httpd_uri_t uri_bin = {
+    .uri       = "/bin",
+    .method    = HTTP_POST,
+    .handler   = proto_post_handler,
+    .user_ctx  = NULL
+};
+
+esp_err_t proto_register(httpd_handle_t server)
+{
+    return router_register_uri(server, &uri_bin);
+}
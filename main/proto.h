@@ -0,0 +1,64 @@
+/* Binary control protocol
+
+   A compact alternative to the text endpoints. Requests and answers are
+   fixed layout messages: an id byte and the fields, little endian, without
+   padding. They are defined once in proto.schema; gen_proto.py generates
+   the structs, the encoder and the decoder (proto_msgs.h) from it at build
+   time. Setting the LED takes 2 bytes, the state answer 7.
+
+     led       level                 -> state_ans
+     send      dev                   -> send_ans
+     peer      dev, level            -> send_ans
+     state                           -> state_ans
+     pins_get  group                 -> pins_ans
+     pins_set  group, value, mask    -> pins_ans
+
+   POST /bin takes any number of requests back to back and answers with
+   one message per request, in order (application/octet-stream). Binary
+   WebSocket messages on /ws carry requests the same way, and state changes
+   are pushed to such a client as state_ans.
+
+   The answer field of send_ans is one of the PROTO_ANSWER_* values of
+   proto.schema:
+
+     0 off        the peer reported off
+     1 on         the peer reported on
+     2 no reply   the peer did not answer within its timeout
+     3 bad reply  the peer's reply did not answer the command
+     4 busy       not sent, too many requests in flight
+
+   All requests are decoded before the first one runs; an unknown id or a
+   truncated message is answered with 400 and an error message naming it.
+   Like /batch, the peer commands of a request go out in one UART frame and
+   the answers follow its reply, so they must all address the same device.
+   A request failing on its own (an unknown pin group) is answered with an
+   error message in its place.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_http_server.h>
+
+#include "proto_msgs.h"
+#include "state.h"
+
+#define PROTO_MAX_REQUESTS      32
+#define PROTO_MAX_BODY          (PROTO_MAX_REQUESTS * PROTO_MAX_MSG)
+
+/* Codes of the error answer */
+#define PROTO_ERR_UNKNOWN       1   /* no request with this id */
+#define PROTO_ERR_TRUNCATED     2   /* the message ends early */
+#define PROTO_ERR_ARG           3   /* a field is out of range */
+#define PROTO_ERR_TOO_MANY      4   /* too many requests or peer commands */
+#define PROTO_ERR_PEERS         5   /* peer commands for different devices */
+#define PROTO_ERR_DEVICE        6   /* no UART channel serves the device */
+
+/* Registers /bin */
+esp_err_t proto_register(httpd_handle_t server);
+
+/* Runs the requests of a binary WebSocket message, see ws_register() */
+void proto_ws_message(httpd_req_t *req, const uint8_t *data, size_t len);
+
+/* Encodes the state as state_ans, returns its length */
+size_t proto_state(const device_state_t *state, uint8_t *buf, size_t size);
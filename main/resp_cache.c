@@ -0,0 +1,231 @@
+/* Response cache
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include "resp_cache.h"
+#include "state.h"
+
+static const char *TAG = "resp-cache";
+
+#define RESP_CACHE_BUDGET   CONFIG_EXAMPLE_RESP_CACHE_BUDGET
+
+typedef struct cache_entry {
+    struct cache_entry *next;
+    uint32_t            version;
+    int64_t             expires;    /* 0 if only the version counts */
+    uint32_t            used;       /* LRU stamp */
+    size_t              size;       /* allocation, counted against the budget */
+    const char         *uri;
+    const char         *type;
+    const char         *hdrs[RESP_CACHE_MAX_HDRS * 2 + 1];   /* NULL terminated */
+    size_t              n_hdrs;
+    const char         *body;
+    size_t              body_len;
+    char                data[];     /* the strings and the body */
+} cache_entry_t;
+
+static cache_entry_t *entries;
+/* Allocated by resp_cache_reserve(), not linked before resp_cache_commit() */
+static cache_entry_t *reserved;
+static uint32_t clock_stamp;
+static resp_cache_stats_t stats;
+
+/* Route part of the URI, 0 if the request has a query string */
+static size_t route_len(httpd_req_t *req)
+{
+    if (strchr(req->uri, '?')) {
+        return 0;
+    }
+    return strlen(req->uri);
+}
+
+static void entry_unlink(cache_entry_t **link)
+{
+    cache_entry_t *e = *link;
+
+    *link = e->next;
+    stats.entries--;
+    stats.bytes -= e->size;
+    free(e);
+}
+
+static bool entry_current(const cache_entry_t *e, uint32_t version, int64_t now)
+{
+    return e->version == version && (e->expires == 0 || now < e->expires);
+}
+
+static esp_err_t entry_send(httpd_req_t *req, const cache_entry_t *e)
+{
+    httpd_resp_set_type(req, e->type);
+    for (size_t i = 0; i < e->n_hdrs; i += 2) {
+        httpd_resp_set_hdr(req, e->hdrs[i], e->hdrs[i + 1]);
+    }
+    return httpd_resp_send(req, e->body, e->body_len);
+}
+
+esp_err_t resp_cache_send(httpd_req_t *req)
+{
+    size_t len = route_len(req);
+    uint32_t version = state_version();
+    int64_t now = esp_timer_get_time();
+
+    if (len == 0) {
+        stats.bypassed++;
+        return ESP_ERR_NOT_FOUND;
+    }
+    for (cache_entry_t **link = &entries; *link; link = &(*link)->next) {
+        cache_entry_t *e = *link;
+        if (strncmp(e->uri, req->uri, len) != 0 || e->uri[len] != '\0') {
+            continue;
+        }
+        if (!entry_current(e, version, now)) {
+            stats.stale++;
+            entry_unlink(link);
+            break;
+        }
+        e->used = ++clock_stamp;
+        stats.hits++;
+        return entry_send(req, e);
+    }
+    stats.misses++;
+    return ESP_ERR_NOT_FOUND;
+}
+
+/* Makes room for size bytes: the route's old entry and stale ones first,
+ * then the least recently used */
+static void cache_make_room(const char *uri, size_t uri_len, size_t size, uint32_t version, int64_t now)
+{
+    for (cache_entry_t **link = &entries; *link;) {
+        cache_entry_t *e = *link;
+        if (strncmp(e->uri, uri, uri_len) == 0 && e->uri[uri_len] == '\0') {
+            entry_unlink(link);
+        } else if (!entry_current(e, version, now)) {
+            stats.stale++;
+            entry_unlink(link);
+        } else {
+            link = &(*link)->next;
+        }
+    }
+    while (entries && stats.bytes + size > RESP_CACHE_BUDGET) {
+        cache_entry_t **lru = &entries;
+        for (cache_entry_t **link = &entries; *link; link = &(*link)->next) {
+            if ((*link)->used < (*lru)->used) {
+                lru = link;
+            }
+        }
+        stats.evicted++;
+        entry_unlink(lru);
+    }
+}
+
+static char *copy_str(char **pos, const char *s, size_t len)
+{
+    char *dst = *pos;
+
+    memcpy(dst, s, len);
+    dst[len] = '\0';
+    *pos += len + 1;
+    return dst;
+}
+
+/* An entry with room for a len byte body and its NUL, the body is left to
+ * the caller */
+static cache_entry_t *cache_alloc(httpd_req_t *req, size_t uri_len, uint32_t version, uint32_t ttl_ms,
+                                  const char *type, const char *const *hdrs, size_t len)
+{
+    size_t n_hdrs = 0;
+    size_t size = sizeof(cache_entry_t) + uri_len + 1 + strlen(type) + 1 + len + 1;
+    int64_t now = esp_timer_get_time();
+
+    while (hdrs && n_hdrs < RESP_CACHE_MAX_HDRS * 2 && hdrs[n_hdrs]) {
+        size += strlen(hdrs[n_hdrs]) + 1 + strlen(hdrs[n_hdrs + 1]) + 1;
+        n_hdrs += 2;
+    }
+    if (size > RESP_CACHE_BUDGET) {
+        stats.too_large++;
+        return NULL;
+    }
+    cache_make_room(req->uri, uri_len, size, version, now);
+
+    cache_entry_t *e = malloc(size);
+    if (e == NULL) {
+        ESP_LOGW(TAG, "no memory for %u bytes", (unsigned)size);
+        return NULL;
+    }
+    char *pos = e->data;
+    e->version = version;
+    e->expires = ttl_ms ? now + (int64_t)ttl_ms * 1000 : 0;
+    e->used = ++clock_stamp;
+    e->size = size;
+    e->uri = copy_str(&pos, req->uri, uri_len);
+    e->type = copy_str(&pos, type, strlen(type));
+    e->n_hdrs = n_hdrs;
+    for (size_t i = 0; i < n_hdrs; i++) {
+        e->hdrs[i] = copy_str(&pos, hdrs[i], strlen(hdrs[i]));
+    }
+    e->hdrs[n_hdrs] = NULL;
+    e->body = pos;
+    e->body_len = len;
+    pos[len] = '\0';
+    return e;
+}
+
+char *resp_cache_reserve(httpd_req_t *req, uint32_t version, uint32_t ttl_ms,
+                         const char *type, const char *const *hdrs, size_t len)
+{
+    size_t uri_len = route_len(req);
+
+    /* One left over was never rendered */
+    free(reserved);
+    reserved = NULL;
+    if (uri_len) {
+        reserved = cache_alloc(req, uri_len, version, ttl_ms, type, hdrs, len);
+    }
+    return reserved ? (char *)reserved->body : NULL;
+}
+
+esp_err_t resp_cache_commit(httpd_req_t *req)
+{
+    cache_entry_t *e = reserved;
+
+    reserved = NULL;
+    e->next = entries;
+    entries = e;
+    stats.stored++;
+    stats.entries++;
+    stats.bytes += e->size;
+    /* Sent from the entry, its strings outlive the response */
+    return entry_send(req, e);
+}
+
+esp_err_t resp_cache_answer(httpd_req_t *req, uint32_t version, uint32_t ttl_ms,
+                            const char *type, const char *const *hdrs,
+                            const char *body, size_t len)
+{
+    char *dst = resp_cache_reserve(req, version, ttl_ms, type, hdrs, len);
+
+    if (dst) {
+        memcpy(dst, body, len);
+        return resp_cache_commit(req);
+    }
+    httpd_resp_set_type(req, type);
+    for (size_t i = 0; hdrs && i < RESP_CACHE_MAX_HDRS * 2 && hdrs[i]; i += 2) {
+        httpd_resp_set_hdr(req, hdrs[i], hdrs[i + 1]);
+    }
+    return httpd_resp_send(req, body, len);
+}
+
+void resp_cache_get_stats(resp_cache_stats_t *out)
+{
+    *out = stats;
+}
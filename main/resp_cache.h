@@ -0,0 +1,55 @@
+/* Response cache
+
+   Keeps rendered GET answers (body, content type and headers) keyed by
+   route and the device state version they were rendered at. A handler asks
+   resp_cache_send() first; on a miss it renders and answers through
+   resp_cache_answer(), which stores a copy, or renders straight into an
+   entry from resp_cache_reserve(). A state change makes every
+   entry stale, stale entries are dropped when next looked at. An entry may
+   also expire after ttl_ms for answers showing something besides the state.
+
+   Entries are limited to CONFIG_EXAMPLE_RESP_CACHE_BUDGET bytes in total,
+   the least recently used is evicted first. Requests with a query string
+   bypass the cache. Only used from the httpd task.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_http_server.h>
+
+#define RESP_CACHE_MAX_HDRS     4
+
+typedef struct {
+    uint32_t    hits;
+    uint32_t    misses;
+    uint32_t    bypassed;       /* requests with a query string */
+    uint32_t    stored;
+    uint32_t    evicted;        /* dropped for the budget */
+    uint32_t    stale;          /* dropped for a new state version or age */
+    uint32_t    too_large;      /* answers bigger than the whole budget */
+    uint32_t    entries;
+    uint32_t    bytes;
+} resp_cache_stats_t;
+
+/* Answers req from the cache if there is a current entry for its route.
+ * ESP_ERR_NOT_FOUND when the handler has to render the answer. */
+esp_err_t resp_cache_send(httpd_req_t *req);
+
+/* Sends a 200 answer rendered at state version and keeps a copy. hdrs are
+ * name, value pairs ending with NULL, or NULL for none. ttl_ms 0 keeps the
+ * entry until the state changes. */
+esp_err_t resp_cache_answer(httpd_req_t *req, uint32_t version, uint32_t ttl_ms,
+                            const char *type, const char *const *hdrs,
+                            const char *body, size_t len);
+
+/* Like resp_cache_answer() for a body rendered in place: returns the len + 1
+ * bytes to render it into (with its NUL), NULL if the answer can't be kept
+ * (query string, over the budget, no memory) and the handler has to send
+ * it some other way. resp_cache_commit() then keeps the entry and sends it,
+ * before the next reservation. */
+char *resp_cache_reserve(httpd_req_t *req, uint32_t version, uint32_t ttl_ms,
+                         const char *type, const char *const *hdrs, size_t len);
+esp_err_t resp_cache_commit(httpd_req_t *req);
+
+void resp_cache_get_stats(resp_cache_stats_t *stats);
@@ -0,0 +1,302 @@
+/* Route table
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <esp_log.h>
+
+#include "connmgr.h"
+#include "metrics.h"
+#include "router.h"
+
+static const char *TAG = "router";
+
+typedef struct {
+    httpd_uri_t     uri;            /* wrapped by metrics */
+    uint32_t        hash;
+    uint16_t        uri_len;
+} route_t;
+
+/* Never changed once published */
+typedef struct {
+    atomic_int                  refs;
+    const router_profile_t     *profile;
+    uint16_t                    n_routes;
+    uint16_t                    mask;
+    route_t                    *routes;
+    uint8_t                    *buckets;   /* route index + 1, 0 if empty */
+} router_table_t;
+
+static const httpd_method_t router_methods[] = { HTTP_GET, HTTP_POST, HTTP_PUT, HTTP_DELETE };
+
+static const router_profile_t default_profile = { .name = "all" };
+
+/* Every route known, the tables are built from it */
+static route_t catalogue[ROUTER_MAX_ROUTES];
+static size_t n_catalogue;
+static const router_profile_t *profiles = &default_profile;
+static size_t n_profiles = 1;
+static const router_profile_t *active = &default_profile;
+
+static _Atomic(router_table_t *) current;
+static httpd_handle_t router_server;
+static SemaphoreHandle_t router_lock;
+static router_stats_t stats;
+
+/* Serialises changes. Created on first use, which is during start-up. */
+static void router_take(void)
+{
+    if (router_lock == NULL) {
+        router_lock = xSemaphoreCreateMutex();
+    }
+    xSemaphoreTake(router_lock, portMAX_DELAY);
+}
+
+static void router_give(void)
+{
+    xSemaphoreGive(router_lock);
+}
+
+/* FNV-1a */
+static uint32_t uri_hash(const char *uri, size_t len)
+{
+    uint32_t h = 2166136261u;
+
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ (uint8_t)uri[i]) * 16777619u;
+    }
+    return h;
+}
+
+static bool route_enabled(const router_profile_t *profile, const char *uri)
+{
+    for (const char *const *d = profile->disabled; d && *d; d++) {
+        if (strcmp(*d, uri) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static router_table_t *table_build(const router_profile_t *profile)
+{
+    size_t n = 0;
+    size_t size = 8;
+
+    for (size_t i = 0; i < n_catalogue; i++) {
+        n += route_enabled(profile, catalogue[i].uri.uri);
+    }
+    /* At most half full, so probe chains stay short */
+    while (size < 2 * n) {
+        size <<= 1;
+    }
+    router_table_t *t = calloc(1, sizeof(*t) + n * sizeof(route_t) + size);
+    if (t == NULL) {
+        return NULL;
+    }
+    atomic_init(&t->refs, 1);
+    t->profile = profile;
+    t->mask = size - 1;
+    t->routes = (route_t *)(t + 1);
+    t->buckets = (uint8_t *)(t->routes + n);
+
+    for (size_t i = 0; i < n_catalogue; i++) {
+        if (!route_enabled(profile, catalogue[i].uri.uri)) {
+            continue;
+        }
+        uint32_t slot = catalogue[i].hash & t->mask;
+        while (t->buckets[slot]) {
+            slot = (slot + 1) & t->mask;
+        }
+        t->routes[t->n_routes] = catalogue[i];
+        t->buckets[slot] = ++t->n_routes;
+    }
+    return t;
+}
+
+static void table_release(router_table_t *t)
+{
+    if (atomic_fetch_sub(&t->refs, 1) == 1) {
+        free(t);
+        stats.freed++;
+    }
+}
+
+static void table_release_work(void *arg)
+{
+    table_release(arg);
+}
+
+/* With router_lock held */
+static esp_err_t table_publish(const router_profile_t *profile)
+{
+    router_table_t *t = table_build(profile);
+    if (t == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    router_table_t *old = atomic_exchange(&current, t);
+    active = profile;
+    stats.swaps++;
+    stats.routes = t->n_routes;
+    stats.buckets = t->mask + 1;
+    /* Requests take their reference in the httpd task, dropping the
+     * table's own there too means none is between loading the pointer and
+     * taking one */
+    if (old && httpd_queue_work(router_server, table_release_work, old) != ESP_OK) {
+        table_release(old);
+    }
+    ESP_LOGI(TAG, "profile %s: %u routes", profile->name, t->n_routes);
+    return ESP_OK;
+}
+
+static const route_t *table_find(const router_table_t *t, const char *uri, size_t len,
+                                 int method, httpd_err_code_t *err)
+{
+    uint32_t hash = uri_hash(uri, len);
+
+    stats.lookups++;
+    *err = HTTPD_404_NOT_FOUND;
+    for (uint32_t slot = hash & t->mask; t->buckets[slot]; slot = (slot + 1) & t->mask) {
+        const route_t *route = &t->routes[t->buckets[slot] - 1];
+        if (route->hash == hash && route->uri_len == len && memcmp(route->uri.uri, uri, len) == 0) {
+            if ((int)route->uri.method == method) {
+                return route;
+            }
+            *err = HTTPD_405_METHOD_NOT_ALLOWED;
+        }
+        stats.probes++;
+    }
+    return NULL;
+}
+
+static esp_err_t router_dispatch(httpd_req_t *req)
+{
+    router_table_t *t = atomic_load(&current);
+    const char *q = strchr(req->uri, '?');
+    size_t len = q ? (size_t)(q - req->uri) : strlen(req->uri);
+    httpd_err_code_t err;
+    esp_err_t ret;
+
+    atomic_fetch_add(&t->refs, 1);
+    const route_t *route = table_find(t, req->uri, len, req->method, &err);
+    if (route) {
+        req->user_ctx = route->uri.user_ctx;
+        connmgr_request_begin(req);
+        ret = route->uri.handler(req);
+        connmgr_request_end(req);
+    } else {
+        stats.not_found++;
+        if (err == HTTPD_404_NOT_FOUND && t->profile->not_found) {
+            ret = t->profile->not_found(req, err);
+        } else {
+            httpd_resp_send_err(req, err, NULL);
+            ret = ESP_FAIL;
+        }
+    }
+    table_release(t);
+    return ret;
+}
+
+esp_err_t router_set_profiles(const router_profile_t *list, size_t n)
+{
+    if (list == NULL || n == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    router_take();
+    profiles = list;
+    n_profiles = n;
+    active = &list[0];
+    router_give();
+    return ESP_OK;
+}
+
+esp_err_t router_register_uri(httpd_handle_t server, const httpd_uri_t *uri)
+{
+    esp_err_t ret = ESP_OK;
+    route_t *route = NULL;
+
+    router_take();
+    for (size_t i = 0; i < n_catalogue; i++) {
+        if (catalogue[i].uri.method == uri->method && strcmp(catalogue[i].uri.uri, uri->uri) == 0) {
+            route = &catalogue[i];
+            break;
+        }
+    }
+    if (route == NULL && n_catalogue < ROUTER_MAX_ROUTES) {
+        route = &catalogue[n_catalogue++];
+    }
+    if (route == NULL) {
+        ESP_LOGW(TAG, "no room for %s", uri->uri);
+        ret = ESP_ERR_HTTPD_HANDLERS_FULL;
+    } else {
+        metrics_wrap_uri(uri, &route->uri);
+        route->uri_len = strlen(uri->uri);
+        route->hash = uri_hash(uri->uri, route->uri_len);
+        if (atomic_load(&current)) {
+            ret = table_publish(active);
+        }
+    }
+    router_give();
+    return ret;
+}
+
+esp_err_t router_start(httpd_handle_t server)
+{
+    esp_err_t ret;
+
+    router_take();
+    router_server = server;
+    ret = table_publish(active);
+    router_give();
+    for (size_t i = 0; ret == ESP_OK && i < sizeof(router_methods) / sizeof(router_methods[0]); i++) {
+        const httpd_uri_t uri = {
+            .uri      = "/*",
+            .method   = router_methods[i],
+            .handler  = router_dispatch,
+            .user_ctx = NULL
+        };
+        ret = httpd_register_uri_handler(server, &uri);
+    }
+    return ret;
+}
+
+esp_err_t router_apply(const char *name)
+{
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+
+    router_take();
+    for (size_t i = 0; i < n_profiles; i++) {
+        const router_profile_t *p = &profiles[i];
+        if (strcmp(p->name, name) == 0 || (p->alias && strcmp(p->alias, name) == 0)) {
+            if (router_server == NULL) {
+                /* Not started, router_start() publishes it */
+                active = p;
+                ret = ESP_OK;
+            } else {
+                ret = table_publish(p);
+            }
+            break;
+        }
+    }
+    router_give();
+    return ret;
+}
+
+const char *router_profile(void)
+{
+    return active->name;
+}
+
+void router_get_stats(router_stats_t *out)
+{
+    *out = stats;
+}
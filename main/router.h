@@ -0,0 +1,58 @@
+/* Route table
+
+   The server's routes live in a hashed table of the router instead of the
+   httpd handler slots. router_start() registers one wildcard handler per
+   method with the httpd, which looks the request up in the current table.
+   Routes needing the httpd itself (WebSockets) are registered with it
+   directly, before router_start().
+
+   A profile selects which routes are served and the 404 handler. Applying
+   one builds a new table off to the side and publishes it with a single
+   pointer swap, so a request never sees a half-applied configuration. A
+   request holds a reference to the table it was dispatched with; the old
+   table is freed in the httpd task once the last one is released.
+*/
+#pragma once
+
+#include <stdint.h>
+#include <esp_http_server.h>
+
+#define ROUTER_MAX_ROUTES       32
+
+typedef struct {
+    const char                 *name;
+    const char                 *alias;      /* optional second name */
+    const char *const          *disabled;   /* URIs left out, NULL terminated */
+    httpd_err_handler_func_t    not_found;  /* NULL for the default 404 */
+} router_profile_t;
+
+typedef struct {
+    uint32_t    swaps;          /* tables published */
+    uint32_t    freed;          /* old tables released */
+    uint32_t    lookups;
+    uint32_t    probes;         /* extra slots looked at on collisions */
+    uint32_t    not_found;
+    uint16_t    routes;         /* in the current table */
+    uint16_t    buckets;
+} router_stats_t;
+
+/* The first profile applies on start. The array must stay valid. */
+esp_err_t router_set_profiles(const router_profile_t *profiles, size_t n);
+
+/* Adds a route, httpd_register_uri_handler() style. Routes are counted by
+ * metrics. After router_start() this publishes a new table. */
+esp_err_t router_register_uri(httpd_handle_t server, const httpd_uri_t *uri);
+
+/* Registers the dispatch handlers and publishes the first table. Needs
+ * config.uri_match_fn = httpd_uri_match_wildcard. */
+esp_err_t router_start(httpd_handle_t server);
+
+/* Switches to the profile with this name or alias, ESP_ERR_NOT_FOUND if
+ * there is none. Before router_start() it selects the profile to start
+ * with. */
+esp_err_t router_apply(const char *name);
+
+/* Name of the profile in use */
+const char *router_profile(void);
+
+void router_get_stats(router_stats_t *stats);
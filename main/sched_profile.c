@@ -0,0 +1,110 @@
+/* Task layout
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include "sched_profile.h"
+
+#define PRO_CPU     0
+#define APP_CPU     1
+#define ANY         tskNO_AFFINITY
+
+/* A custom core of -1 means either */
+#define CUSTOM_CORE(c)  ((c) < 0 ? ANY : (c))
+
+static const char *const profile_names[SCHED_PROFILES] = {
+    [SCHED_PROFILE_DEFAULT]    = "default",
+    [SCHED_PROFILE_SPLIT]      = "split",
+    [SCHED_PROFILE_UART_ALONE] = "uart_alone",
+    [SCHED_PROFILE_CUSTOM]     = "custom",
+};
+
+static const sched_slot_t profiles[SCHED_PROFILES][SCHED_ROLES] = {
+    [SCHED_PROFILE_DEFAULT] = {
+        [SCHED_HTTPD]      = { ANY,     tskIDLE_PRIORITY + 5,  4096 },
+        [SCHED_UART]       = { ANY,     10,                    3072 },
+        [SCHED_BACKGROUND] = { ANY,     tskIDLE_PRIORITY + 1,  3072 },
+    },
+    [SCHED_PROFILE_SPLIT] = {
+        [SCHED_HTTPD]      = { APP_CPU, tskIDLE_PRIORITY + 5,  4096 },
+        [SCHED_UART]       = { APP_CPU, 10,                    3072 },
+        [SCHED_BACKGROUND] = { PRO_CPU, tskIDLE_PRIORITY + 1,  3072 },
+    },
+    [SCHED_PROFILE_UART_ALONE] = {
+        [SCHED_HTTPD]      = { PRO_CPU, tskIDLE_PRIORITY + 5,  4096 },
+        [SCHED_UART]       = { APP_CPU, 10,                    3072 },
+        [SCHED_BACKGROUND] = { APP_CPU, tskIDLE_PRIORITY + 1,  3072 },
+    },
+#ifdef CONFIG_EXAMPLE_SCHED_CUSTOM
+    [SCHED_PROFILE_CUSTOM] = {
+        [SCHED_HTTPD]      = { CUSTOM_CORE(CONFIG_EXAMPLE_SCHED_HTTPD_CORE),
+                               CONFIG_EXAMPLE_SCHED_HTTPD_PRIORITY, CONFIG_EXAMPLE_SCHED_HTTPD_STACK },
+        [SCHED_UART]       = { CUSTOM_CORE(CONFIG_EXAMPLE_SCHED_UART_CORE),
+                               CONFIG_EXAMPLE_SCHED_UART_PRIORITY, CONFIG_EXAMPLE_SCHED_UART_STACK },
+        [SCHED_BACKGROUND] = { CUSTOM_CORE(CONFIG_EXAMPLE_SCHED_BACKGROUND_CORE),
+                               CONFIG_EXAMPLE_SCHED_BACKGROUND_PRIORITY, CONFIG_EXAMPLE_SCHED_BACKGROUND_STACK },
+    },
+#else
+    /* Not configured, the same as default */
+    [SCHED_PROFILE_CUSTOM] = {
+        [SCHED_HTTPD]      = { ANY,     tskIDLE_PRIORITY + 5,  4096 },
+        [SCHED_UART]       = { ANY,     10,                    3072 },
+        [SCHED_BACKGROUND] = { ANY,     tskIDLE_PRIORITY + 1,  3072 },
+    },
+#endif
+};
+
+sched_profile_t sched_profile(void)
+{
+#if defined(CONFIG_EXAMPLE_SCHED_SPLIT)
+    return SCHED_PROFILE_SPLIT;
+#elif defined(CONFIG_EXAMPLE_SCHED_UART_ALONE)
+    return SCHED_PROFILE_UART_ALONE;
+#elif defined(CONFIG_EXAMPLE_SCHED_CUSTOM)
+    return SCHED_PROFILE_CUSTOM;
+#else
+    return SCHED_PROFILE_DEFAULT;
+#endif
+}
+
+const char *sched_profile_name(sched_profile_t profile)
+{
+    return profile < SCHED_PROFILES ? profile_names[profile] : NULL;
+}
+
+const sched_slot_t *sched_profile_slot(sched_profile_t profile, sched_role_t role)
+{
+    return &profiles[profile][role];
+}
+
+const sched_slot_t *sched_slot(sched_role_t role)
+{
+    return sched_profile_slot(sched_profile(), role);
+}
+
+BaseType_t sched_task_create(sched_role_t role, TaskFunction_t fn, const char *name, void *arg,
+                             TaskHandle_t *task)
+{
+    const sched_slot_t *slot = sched_slot(role);
+    BaseType_t core = slot->core;
+
+#ifdef CONFIG_FREERTOS_UNICORE
+    core = ANY;
+#endif
+    return xTaskCreatePinnedToCore(fn, name, slot->stack, arg, slot->priority, task, core);
+}
+
+void sched_httpd_config(httpd_config_t *config)
+{
+    const sched_slot_t *slot = sched_slot(SCHED_HTTPD);
+
+    config->task_priority = slot->priority;
+    config->stack_size = slot->stack;
+#ifndef CONFIG_FREERTOS_UNICORE
+    config->core_id = slot->core;
+#endif
+}
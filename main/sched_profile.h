@@ -0,0 +1,65 @@
+/* Task layout
+
+   Where the example's own tasks run, with which priority and stack, in
+   three roles:
+
+     httpd       the server task (HTTPD_DEFAULT_CONFIG() otherwise)
+     uart        the UART channel tasks (uart_link), and the UART interrupts
+     background  log_drain and persist
+
+   CONFIG_EXAMPLE_SCHED_PROFILE picks one of the profiles below, or
+   custom values from Kconfig. The Wi-Fi task stays pinned to the PRO CPU
+   (core 0) and lwIP's tcpip task unpinned, as the sdkconfig has them.
+
+     default     nothing pinned, priorities httpd 5, uart 10, background 1
+     split       httpd and uart on the APP CPU (core 1), away from Wi-Fi;
+                 background on the PRO CPU below everything else
+     uart_alone  uart alone with background on the APP CPU, httpd next to
+                 the network stack on the PRO CPU
+
+   Compare them on the device by building each profile and running the
+   load benchmark (http_server_simple_test.py bench), which records the
+   layout and the /send round trip jitter.
+*/
+#pragma once
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <esp_http_server.h>
+
+typedef enum {
+    SCHED_HTTPD,
+    SCHED_UART,
+    SCHED_BACKGROUND,
+    SCHED_ROLES
+} sched_role_t;
+
+typedef enum {
+    SCHED_PROFILE_DEFAULT,
+    SCHED_PROFILE_SPLIT,
+    SCHED_PROFILE_UART_ALONE,
+    SCHED_PROFILE_CUSTOM,
+    SCHED_PROFILES
+} sched_profile_t;
+
+typedef struct {
+    BaseType_t  core;           /* tskNO_AFFINITY for either */
+    UBaseType_t priority;
+    uint32_t    stack;          /* bytes */
+} sched_slot_t;
+
+/* The configured profile */
+sched_profile_t sched_profile(void);
+const char *sched_profile_name(sched_profile_t profile);
+
+/* Placement of a role in a profile, or in the configured one */
+const sched_slot_t *sched_profile_slot(sched_profile_t profile, sched_role_t role);
+const sched_slot_t *sched_slot(sched_role_t role);
+
+/* xTaskCreatePinnedToCore() with the role's placement */
+BaseType_t sched_task_create(sched_role_t role, TaskFunction_t fn, const char *name, void *arg,
+                             TaskHandle_t *task);
+
+/* Applies the httpd placement to a server config */
+void sched_httpd_config(httpd_config_t *config);
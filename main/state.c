@@ -0,0 +1,125 @@
+/* Device state store
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <esp_log.h>
+
+#include "state.h"
+
+static const char *TAG = "state";
+
+/* Odd while a writer is copying a new snapshot into current */
+static atomic_uint seq;
+static atomic_uint version;
+static device_state_t current;
+
+static SemaphoreHandle_t writer_lock;
+
+static struct {
+    state_listener_t    fn;
+    void               *arg;
+} listeners[STATE_MAX_LISTENERS];
+static int n_listeners;
+
+esp_err_t state_init(void)
+{
+    if (writer_lock) {
+        return ESP_OK;
+    }
+    writer_lock = xSemaphoreCreateMutex();
+    if (writer_lock == NULL) {
+        ESP_LOGE(TAG, "cannot create lock");
+        return ESP_ERR_NO_MEM;
+    }
+    current.version = 1;
+    atomic_store(&version, 1);
+    return ESP_OK;
+}
+
+void state_get(device_state_t *state)
+{
+    unsigned before, after;
+
+    do {
+        before = atomic_load_explicit(&seq, memory_order_acquire);
+        memcpy(state, &current, sizeof(*state));
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&seq, memory_order_relaxed);
+    } while ((before & 1) || before != after);
+}
+
+uint32_t state_version(void)
+{
+    return atomic_load_explicit(&version, memory_order_acquire);
+}
+
+int state_to_json(const device_state_t *state, char *buf, size_t size)
+{
+    return snprintf(buf, size, "{\"v\":%u,\"led\":%u,\"peer\":%u}",
+                    (unsigned)state->version, state->led, state->peer_led);
+}
+
+uint32_t state_update(state_update_fn_t fn, void *arg, device_state_t *state)
+{
+    device_state_t next;
+
+    xSemaphoreTake(writer_lock, portMAX_DELAY);
+    next = current;
+    fn(&next, arg);
+    next.version = current.version;
+    if (memcmp(&next, &current, sizeof(next)) != 0) {
+        unsigned s = atomic_load_explicit(&seq, memory_order_relaxed);
+
+        next.version++;
+        atomic_store_explicit(&seq, s + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        current = next;
+        atomic_store_explicit(&seq, s + 2, memory_order_release);
+        atomic_store_explicit(&version, next.version, memory_order_release);
+
+        for (int i = 0; i < n_listeners; i++) {
+            listeners[i].fn(&next, listeners[i].arg);
+        }
+    }
+    if (state) {
+        *state = next;
+    }
+    xSemaphoreGive(writer_lock);
+    return next.version;
+}
+
+static void set_led(device_state_t *state, void *arg)
+{
+    state->led = *(int *)arg ? 1 : 0;
+}
+
+uint32_t state_set_led(int level)
+{
+    return state_update(set_led, &level, NULL);
+}
+
+esp_err_t state_listen(state_listener_t fn, void *arg)
+{
+    esp_err_t ret = ESP_OK;
+
+    xSemaphoreTake(writer_lock, portMAX_DELAY);
+    if (n_listeners == STATE_MAX_LISTENERS) {
+        ret = ESP_ERR_NO_MEM;
+    } else {
+        listeners[n_listeners].fn = fn;
+        listeners[n_listeners].arg = arg;
+        n_listeners++;
+    }
+    xSemaphoreGive(writer_lock);
+    return ret;
+}
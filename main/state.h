@@ -0,0 +1,49 @@
+/* Device state store
+
+   A single versioned snapshot of the device state. Readers on any core
+   copy it with state_get() without taking a lock: a sequence counter tells
+   them to retry if a writer was publishing at the same time. Writers are
+   serialised and every change is published with a version one higher than
+   the previous one, so a reader can tell whether anything changed since a
+   version it has seen.
+
+   Listeners registered with state_listen() are called after each change,
+   in version order, from the writer's task and with the writer lock held:
+   they must be short and must not write the state themselves.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#define STATE_MAX_LISTENERS     8
+#define STATE_JSON_MAX          48
+
+typedef struct {
+    uint32_t    version;
+    uint8_t     led;        /* LED level */
+    uint8_t     peer_led;   /* LED state last commanded to the UART peer */
+} device_state_t;
+
+/* Modifies *state in place; leaving it unchanged publishes nothing */
+typedef void (*state_update_fn_t)(device_state_t *state, void *arg);
+typedef void (*state_listener_t)(const device_state_t *state, void *arg);
+
+esp_err_t state_init(void);
+
+void state_get(device_state_t *state);
+uint32_t state_version(void);
+
+/* Compact JSON form used by the HTTP and push channels, returns the length
+ * like snprintf */
+int state_to_json(const device_state_t *state, char *buf, size_t size);
+
+/* Apply fn to a copy of the current state and publish the result. Returns
+ * the version after the update, *state receives the published snapshot if
+ * not NULL. */
+uint32_t state_update(state_update_fn_t fn, void *arg, device_state_t *state);
+
+uint32_t state_set_led(int level);
+
+esp_err_t state_listen(state_listener_t fn, void *arg);
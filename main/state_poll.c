@@ -0,0 +1,199 @@
+/* Long-poll access to the device state
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include "http_async.h"
+#include "router.h"
+#include "state.h"
+#include "state_poll.h"
+
+static const char *TAG = "state-poll";
+
+#define POLL_TICK_US            (500 * 1000)
+#define HTTPD_304               "304 Not Modified"
+
+typedef struct {
+    http_async_t   *async;      /* NULL if the slot is free */
+    int             fd;
+    uint32_t        since;
+    int64_t         deadline;
+} parked_t;
+
+static parked_t parked[STATE_POLL_MAX_PARKED];
+static portMUX_TYPE parked_lock = portMUX_INITIALIZER_UNLOCKED;
+static esp_timer_handle_t poll_timer;
+
+static void poll_reply(http_async_t *async, const device_state_t *state)
+{
+    char json[STATE_JSON_MAX];
+
+    state_to_json(state, json, sizeof(json));
+    http_async_send(async, HTTPD_200, HTTPD_TYPE_JSON, json, HTTPD_RESP_USE_STRLEN);
+}
+
+/* State listener: answers every parked request the change concerns. The
+ * handles are collected under the lock and answered outside of it. */
+static void poll_on_change(const device_state_t *state, void *arg)
+{
+    http_async_t *ready[STATE_POLL_MAX_PARKED];
+    int n = 0;
+
+    portENTER_CRITICAL(&parked_lock);
+    for (int i = 0; i < STATE_POLL_MAX_PARKED; i++) {
+        if (parked[i].async && parked[i].since != state->version) {
+            ready[n++] = parked[i].async;
+            parked[i].async = NULL;
+        }
+    }
+    portEXIT_CRITICAL(&parked_lock);
+
+    for (int i = 0; i < n; i++) {
+        poll_reply(ready[i], state);
+    }
+}
+
+static void poll_expire(void *arg)
+{
+    http_async_t *expired[STATE_POLL_MAX_PARKED];
+    int64_t now = esp_timer_get_time();
+    int n = 0;
+
+    portENTER_CRITICAL(&parked_lock);
+    for (int i = 0; i < STATE_POLL_MAX_PARKED; i++) {
+        if (parked[i].async && parked[i].deadline <= now) {
+            expired[n++] = parked[i].async;
+            parked[i].async = NULL;
+        }
+    }
+    portEXIT_CRITICAL(&parked_lock);
+
+    for (int i = 0; i < n; i++) {
+        http_async_send(expired[i], HTTPD_304, HTTPD_TYPE_JSON, NULL, 0);
+    }
+}
+
+void state_poll_session_closed(int sockfd)
+{
+    http_async_t *gone = NULL;
+
+    portENTER_CRITICAL(&parked_lock);
+    for (int i = 0; i < STATE_POLL_MAX_PARKED; i++) {
+        if (parked[i].async && parked[i].fd == sockfd) {
+            gone = parked[i].async;
+            parked[i].async = NULL;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&parked_lock);
+
+    if (gone) {
+        /* The session generation already changed, this only frees it */
+        http_async_abort(gone);
+    }
+}
+
+/* Parks the detached request. Returns false if all slots are taken or the
+ * state changed meanwhile; the caller answers right away then. */
+static bool poll_park(http_async_t *async, int fd, uint32_t since)
+{
+    bool ok = false;
+
+    portENTER_CRITICAL(&parked_lock);
+    /* A change published before this point has already run the listener */
+    if (state_version() == since) {
+        for (int i = 0; i < STATE_POLL_MAX_PARKED; i++) {
+            if (parked[i].async == NULL) {
+                parked[i].async = async;
+                parked[i].fd = fd;
+                parked[i].since = since;
+                parked[i].deadline = esp_timer_get_time() +
+                                     (int64_t)CONFIG_EXAMPLE_STATE_POLL_TIMEOUT_S * 1000000;
+                ok = true;
+                break;
+            }
+        }
+    }
+    portEXIT_CRITICAL(&parked_lock);
+    return ok;
+}
+
+static esp_err_t state_get_handler(httpd_req_t *req)
+{
+    char query[32];
+    char param[12];
+    char json[STATE_JSON_MAX];
+    device_state_t state;
+    bool wait = false;
+    uint32_t since = 0;
+
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+            httpd_query_key_value(query, "since", param, sizeof(param)) == ESP_OK) {
+        char *end;
+        since = strtoul(param, &end, 10);
+        if (end == param || *end != '\0') {
+            return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "since must be a state version");
+        }
+        wait = true;
+    }
+
+    state_get(&state);
+    if (wait && state.version == since) {
+        http_async_t *async = http_async_begin(req);
+        if (async == NULL) {
+            return httpd_resp_send_500(req);
+        }
+        if (poll_park(async, httpd_req_to_sockfd(req), since)) {
+            ESP_LOGD(TAG, "parked %d since %u", httpd_req_to_sockfd(req), (unsigned)since);
+            return ESP_OK;
+        }
+        state_get(&state);
+        if (state.version == since) {
+            /* Every slot taken: tell the client to come back later */
+            http_async_send(async, "503 Service Unavailable", HTTPD_TYPE_JSON, NULL, 0);
+            return ESP_OK;
+        }
+        poll_reply(async, &state);
+        return ESP_OK;
+    }
+
+    state_to_json(&state, json, sizeof(json));
+    httpd_resp_set_type(req, HTTPD_TYPE_JSON);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    return httpd_resp_send(req, json, HTTPD_RESP_USE_STRLEN);
+}
+
+static const httpd_uri_t uri_state = {
+    .uri       = "/state",
+    .method    = HTTP_GET,
+    .handler   = state_get_handler,
+    .user_ctx  = NULL
+};
+
+esp_err_t state_poll_register(httpd_handle_t server)
+{
+    if (poll_timer == NULL) {
+        const esp_timer_create_args_t args = {
+            .callback = poll_expire,
+            .name = "state_poll",
+        };
+        esp_err_t ret = esp_timer_create(&args, &poll_timer);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        /* A fixed tick keeps parking free of timer calls, the scan is short */
+        esp_timer_start_periodic(poll_timer, POLL_TICK_US);
+        ESP_ERROR_CHECK(state_listen(poll_on_change, NULL));
+    }
+    return router_register_uri(server, &uri_state);
+}
@@ -0,0 +1,19 @@
+/* Long-poll access to the device state
+
+   GET /state returns the state as JSON. With ?since=<version> the answer
+   waits until the state version differs from <version>: the request is
+   detached with http_async_begin() and parked, so no httpd task is held,
+   and answered by the state listener on the next change or with
+   304 Not Modified once CONFIG_EXAMPLE_STATE_POLL_TIMEOUT_S expires.
+*/
+#pragma once
+
+#include <esp_http_server.h>
+
+#define STATE_POLL_MAX_PARKED   8
+
+/* Registers /state and the state listener, after state_init() */
+esp_err_t state_poll_register(httpd_handle_t server);
+
+/* Must be called from the server close_fn for every closed session */
+void state_poll_session_closed(int sockfd);
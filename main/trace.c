@@ -0,0 +1,207 @@
+/* Tracepoints
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <esp_log.h>
+#include <esp_rom_sys.h>
+#include "hal/cpu_hal.h"
+
+#include "router.h"
+#include "trace.h"
+
+#if CONFIG_EXAMPLE_TRACE
+
+#define TRACE_EVENTS            CONFIG_EXAMPLE_TRACE_EVENTS
+#define TRACE_CHUNK             512
+#define TRACE_MAX_TASKS         16
+
+_Static_assert((TRACE_EVENTS & (TRACE_EVENTS - 1)) == 0,
+               "CONFIG_EXAMPLE_TRACE_EVENTS must be a power of two");
+
+typedef struct {
+    uint64_t        cycles;
+    const char     *name;
+    TaskHandle_t    task;
+    uint32_t        arg;
+    char            phase;
+    uint8_t         core;
+} trace_event_t;
+
+/* The cycle counter extended to 64 bits, per core */
+typedef struct {
+    uint32_t        last;
+    uint32_t        wraps;
+} trace_clock_t;
+
+static const char *TAG = "trace";
+
+static trace_event_t events[TRACE_EVENTS];
+static uint32_t head;               /* events recorded so far */
+static trace_clock_t clocks[portNUM_PROCESSORS];
+static portMUX_TYPE trace_lock = portMUX_INITIALIZER_UNLOCKED;
+static atomic_bool paused;
+
+/* Tasks named in the output, if they exist */
+static const char *const known_tasks[] = {
+    "httpd", "uart_link0", "uart_link1", "uart_link2", "log_drain", "persist",
+    "main", "tiT", "esp_timer",
+};
+
+void trace_event(const char *name, char phase, uint32_t arg)
+{
+    if (atomic_load_explicit(&paused, memory_order_relaxed)) {
+        return;
+    }
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+
+    portENTER_CRITICAL(&trace_lock);
+    /* Again under the lock: a writer that passed the check above just
+     * before a dump started must not overwrite the events being sent */
+    if (atomic_load_explicit(&paused, memory_order_relaxed)) {
+        portEXIT_CRITICAL(&trace_lock);
+        return;
+    }
+    /* Read inside the lock, so the counter only moves forward per core */
+    int core = xPortGetCoreID();
+    uint32_t now = cpu_hal_get_cycle_count();
+    trace_clock_t *clock = &clocks[core];
+    if (now < clock->last) {
+        clock->wraps++;
+    }
+    clock->last = now;
+
+    trace_event_t *ev = &events[head++ & (TRACE_EVENTS - 1)];
+    ev->cycles = (uint64_t)clock->wraps << 32 | now;
+    ev->name = name;
+    ev->task = task;
+    ev->arg = arg;
+    ev->phase = phase;
+    ev->core = core;
+    portEXIT_CRITICAL(&trace_lock);
+}
+
+typedef struct {
+    httpd_req_t    *req;
+    size_t          len;
+    char            buf[TRACE_CHUNK];
+} out_t;
+
+static void out_printf(out_t *out, const char *format, ...)
+{
+    va_list args;
+    int n;
+
+    for (int retry = 0; retry < 2; retry++) {
+        va_start(args, format);
+        n = vsnprintf(out->buf + out->len, sizeof(out->buf) - out->len, format, args);
+        va_end(args);
+        if (n >= 0 && (size_t)n < sizeof(out->buf) - out->len) {
+            out->len += n;
+            return;
+        }
+        httpd_resp_send_chunk(out->req, out->buf, out->len);
+        out->len = 0;
+    }
+}
+
+/* Small thread ids for Chrome, in order of appearance */
+static int task_id(TaskHandle_t *tasks, int *n_tasks, TaskHandle_t task)
+{
+    for (int i = 0; i < *n_tasks; i++) {
+        if (tasks[i] == task) {
+            return i + 1;
+        }
+    }
+    if (*n_tasks == TRACE_MAX_TASKS) {
+        return 0;
+    }
+    tasks[(*n_tasks)++] = task;
+    return *n_tasks;
+}
+
+static esp_err_t trace_get_handler(httpd_req_t *req)
+{
+    static out_t out;
+    TaskHandle_t tasks[TRACE_MAX_TASKS];
+    int n_tasks = 0;
+    uint32_t ticks_per_us = esp_rom_get_cpu_ticks_per_us();
+    uint32_t first, last;
+
+    /* Stop recording while the ring is sent, the sends would otherwise
+     * trace themselves into it. Writers check the flag again under the
+     * lock, so none records after head is read. */
+    portENTER_CRITICAL(&trace_lock);
+    atomic_store_explicit(&paused, true, memory_order_relaxed);
+    last = head;
+    portEXIT_CRITICAL(&trace_lock);
+    first = last > TRACE_EVENTS ? last - TRACE_EVENTS : 0;
+
+    out.req = req;
+    out.len = 0;
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+    uint64_t origin = UINT64_MAX;
+    for (uint32_t i = first; i < last; i++) {
+        const trace_event_t *ev = &events[i & (TRACE_EVENTS - 1)];
+        origin = ev->cycles < origin ? ev->cycles : origin;
+    }
+
+    out_printf(&out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    for (uint32_t i = first; i < last; i++) {
+        const trace_event_t *ev = &events[i & (TRACE_EVENTS - 1)];
+        uint64_t t = ev->cycles - origin;
+        out_printf(&out, "%s{\"name\":\"%s\",\"ph\":\"%c\",%s\"ts\":%llu.%03u,\"pid\":1,\"tid\":%d,"
+                   "\"args\":{\"core\":%u,\"arg\":%u}}",
+                   i > first ? "," : "", ev->name, ev->phase, ev->phase == 'i' ? "\"s\":\"t\"," : "",
+                   (unsigned long long)(t / ticks_per_us),
+                   (unsigned)(t % ticks_per_us * 1000 / ticks_per_us),
+                   task_id(tasks, &n_tasks, ev->task), ev->core, (unsigned)ev->arg);
+    }
+    for (int i = 0; i < n_tasks; i++) {
+        const char *name = NULL;
+        for (size_t k = 0; k < sizeof(known_tasks) / sizeof(known_tasks[0]); k++) {
+            if (xTaskGetHandle(known_tasks[k]) == tasks[i]) {
+                name = known_tasks[k];
+                break;
+            }
+        }
+        if (name) {
+            out_printf(&out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                       "\"args\":{\"name\":\"%s\"}}", last > first || i ? "," : "", i + 1, name);
+        }
+    }
+    out_printf(&out, "],\"otherData\":{\"events\":%u,\"overwritten\":%u}}",
+               (unsigned)(last - first), (unsigned)first);
+    httpd_resp_send_chunk(req, out.buf, out.len);
+    esp_err_t ret = httpd_resp_send_chunk(req, NULL, 0);
+
+    ESP_LOGI(TAG, "sent %u events", (unsigned)(last - first));
+    atomic_store(&paused, false);
+    return ret;
+}
+
+static const httpd_uri_t uri_trace = {
+    .uri       = "/trace",
+    .method    = HTTP_GET,
+    .handler   = trace_get_handler,
+    .user_ctx  = NULL
+};
+
+esp_err_t trace_register(httpd_handle_t server)
+{
+    return router_register_uri(server, &uri_trace);
+}
+
+#endif
@@ -0,0 +1,43 @@
+/* Tracepoints
+
+   TRACE_BEGIN() and TRACE_END() mark a span, TRACE_INSTANT() a point in
+   time. With CONFIG_EXAMPLE_TRACE they record the CPU cycle counter, the
+   calling task and a 32-bit argument into a ring of
+   CONFIG_EXAMPLE_TRACE_EVENTS events, the oldest overwritten first; without
+   it they compile to nothing. Names must be string literals or otherwise
+   outlive the ring, and a span's begin and end must be in the same task.
+
+   GET /trace returns the ring as Chrome trace-event JSON for Perfetto or
+   chrome://tracing. Recording pauses while it is written. The counters of
+   the two cores are not synchronised, so spans on different cores can be
+   offset slightly. Idle gaps longer than a counter wrap (17.9 s at
+   240 MHz) come out shortened.
+*/
+#pragma once
+
+#include <stdint.h>
+#include <esp_http_server.h>
+
+#if CONFIG_EXAMPLE_TRACE
+
+#define TRACE_BEGIN(name, arg)      trace_event((name), 'B', (arg))
+#define TRACE_END(name, arg)        trace_event((name), 'E', (arg))
+#define TRACE_INSTANT(name, arg)    trace_event((name), 'i', (arg))
+
+void trace_event(const char *name, char phase, uint32_t arg);
+
+/* Registers /trace */
+esp_err_t trace_register(httpd_handle_t server);
+
+#else
+
+#define TRACE_BEGIN(name, arg)      do { } while (0)
+#define TRACE_END(name, arg)        do { } while (0)
+#define TRACE_INSTANT(name, arg)    do { } while (0)
+
+static inline esp_err_t trace_register(httpd_handle_t server)
+{
+    return ESP_OK;
+}
+
+#endif
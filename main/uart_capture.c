@@ -0,0 +1,275 @@
+/* UART receive capture
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include "capture_ring.h"
+#include "connmgr.h"
+#include "router.h"
+#include "uart_capture.h"
+#include "uart_link.h"
+
+static const char *TAG = "uart_capture";
+
+#define CAPTURE_SIZE        CONFIG_EXAMPLE_UART_CAPTURE_SIZE
+#define CAPTURE_CHUNK       (CAPTURE_SIZE / 4)
+
+_Static_assert((CAPTURE_SIZE & (CAPTURE_SIZE - 1)) == 0, "capture size must be a power of two");
+
+#define STREAM_HEAD "HTTP/1.1 200 OK\r\n"                       \
+                    "Content-Type: application/octet-stream\r\n"  \
+                    "Transfer-Encoding: chunked\r\n"            \
+                    "Cache-Control: no-store\r\n\r\n"
+
+typedef struct {
+    int             fd;             /* -1 if free */
+    int             channel;
+    uint32_t        cursor;         /* next ring position to send */
+    uint32_t        chunk_left;     /* bytes of the current chunk still to send */
+    bool            started;        /* a chunk is open, the next header ends it */
+    uint8_t         hdr_len;
+    uint8_t         hdr_sent;
+    char            hdr[16];        /* "\r\n" <size> "\r\n" */
+} subscriber_t;
+
+static capture_ring_t rings[UART_LINK_MAX_CHANNELS];
+static int n_rings;
+
+static httpd_handle_t capture_server;
+static esp_timer_handle_t poll_timer;
+static atomic_bool pump_queued;
+static atomic_int n_subscribers;
+static _Atomic uint32_t captured;
+
+/* httpd task only */
+static subscriber_t subscribers[UART_CAPTURE_MAX_SUBSCRIBERS] = {
+    [0 ... UART_CAPTURE_MAX_SUBSCRIBERS - 1] = { .fd = -1 },
+};
+static uint32_t streamed, overruns, skipped;
+
+static void capture_pump(void *arg);
+
+/* At most one pump is queued however fast the bytes come in */
+static void capture_kick(void)
+{
+    if (!atomic_exchange(&pump_queued, true) &&
+            httpd_queue_work(capture_server, capture_pump, NULL) != ESP_OK) {
+        atomic_store(&pump_queued, false);
+    }
+}
+
+/* In the channel's task */
+static void capture_tap(int index, const uint8_t *data, size_t len, void *arg)
+{
+    if (index >= n_rings) {
+        return;
+    }
+    capture_ring_write(&rings[index], data, len);
+    atomic_fetch_add_explicit(&captured, len, memory_order_relaxed);
+    if (atomic_load_explicit(&n_subscribers, memory_order_relaxed)) {
+        capture_kick();
+    }
+}
+
+static void poll_timer_cb(void *arg)
+{
+    capture_kick();
+}
+
+static void subscriber_free(subscriber_t *s)
+{
+    s->fd = -1;
+    if (atomic_fetch_sub(&n_subscribers, 1) == 1) {
+        esp_timer_stop(poll_timer);
+    }
+}
+
+/* Sends what the socket takes without blocking, at most a ring's worth.
+ * Returns 0 or the error of a failed send. */
+static int subscriber_pump(subscriber_t *s)
+{
+    capture_ring_t *ring = &rings[s->channel];
+    size_t budget = ring->size;
+    int ret;
+
+    for (;;) {
+        if (s->hdr_sent < s->hdr_len) {
+            ret = httpd_socket_send(capture_server, s->fd, s->hdr + s->hdr_sent,
+                                    s->hdr_len - s->hdr_sent, MSG_DONTWAIT);
+            if (ret <= 0) {
+                break;
+            }
+            s->hdr_sent += ret;
+            continue;
+        }
+
+        const uint8_t *data;
+        uint32_t skip;
+        size_t len = capture_ring_peek(ring, &s->cursor, s->chunk_left ? s->chunk_left : CAPTURE_CHUNK,
+                                       &data, &skip);
+        if (skip) {
+            overruns++;
+            skipped += skip;
+        }
+        if (len == 0 || budget == 0) {
+            return 0;
+        }
+        if (s->chunk_left == 0) {
+            /* The header of the next chunk ends the previous one */
+            s->hdr_len = snprintf(s->hdr, sizeof(s->hdr), "%s%x\r\n", s->started ? "\r\n" : "",
+                                  (unsigned)len);
+            s->hdr_sent = 0;
+            s->started = true;
+            s->chunk_left = len;
+            continue;
+        }
+
+        /* Straight from the ring; the writer may overtake the send */
+        uint32_t pos = s->cursor;
+        if (len > budget) {
+            len = budget;
+        }
+        ret = httpd_socket_send(capture_server, s->fd, (const char *)data, len, MSG_DONTWAIT);
+        if (ret <= 0) {
+            break;
+        }
+        if (capture_ring_lost(ring, pos)) {
+            overruns++;
+        }
+        s->cursor += ret;
+        s->chunk_left -= ret;
+        streamed += ret;
+        budget -= ret;
+    }
+    return ret == HTTPD_SOCK_ERR_TIMEOUT || ret == 0 ? 0 : ret;
+}
+
+static void capture_pump(void *arg)
+{
+    atomic_store(&pump_queued, false);
+    for (int i = 0; i < UART_CAPTURE_MAX_SUBSCRIBERS; i++) {
+        subscriber_t *s = &subscribers[i];
+        if (s->fd != -1 && subscriber_pump(s) < 0) {
+            ESP_LOGD(TAG, "stream on %d failed", s->fd);
+            httpd_sess_trigger_close(capture_server, s->fd);
+            subscriber_free(s);
+        }
+    }
+}
+
+/* Channel index of a UART port, -1 if no channel uses it */
+static int capture_channel(int port)
+{
+    for (int i = 0; i < n_rings; i++) {
+        if (uart_link_channel(i)->port == port) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static esp_err_t stream_get_handler(httpd_req_t *req)
+{
+    char query[32];
+    char val[8];
+    int channel = n_rings ? 0 : -1;
+    bool backlog = false;
+    subscriber_t *s = NULL;
+
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        if (httpd_query_key_value(query, "port", val, sizeof(val)) == ESP_OK) {
+            channel = capture_channel(atoi(val));
+        }
+        backlog = httpd_query_key_value(query, "backlog", val, sizeof(val)) == ESP_OK &&
+                  strcmp(val, "1") == 0;
+    }
+    if (channel < 0) {
+        return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "unknown port");
+    }
+    for (int i = 0; i < UART_CAPTURE_MAX_SUBSCRIBERS && s == NULL; i++) {
+        if (subscribers[i].fd == -1) {
+            s = &subscribers[i];
+        }
+    }
+    if (s == NULL) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        return httpd_resp_sendstr(req, "too many streams");
+    }
+
+    /* The head goes out now, the body from the pump */
+    if (httpd_send(req, STREAM_HEAD, strlen(STREAM_HEAD)) < 0) {
+        return ESP_FAIL;
+    }
+    memset(s, 0, sizeof(*s));
+    s->fd = httpd_req_to_sockfd(req);
+    s->channel = channel;
+    s->cursor = backlog ? capture_ring_tail(&rings[channel]) : capture_ring_head(&rings[channel]);
+    connmgr_stream(s->fd);
+    if (atomic_fetch_add(&n_subscribers, 1) == 0) {
+        esp_timer_start_periodic(poll_timer, UART_CAPTURE_POLL_MS * 1000);
+    }
+    ESP_LOGI(TAG, "streaming UART%d to %d", uart_link_channel(channel)->port, s->fd);
+    capture_kick();
+    return ESP_OK;
+}
+
+static const httpd_uri_t uri_stream = {
+    .uri       = "/uart/stream",
+    .method    = HTTP_GET,
+    .handler   = stream_get_handler,
+    .user_ctx  = NULL
+};
+
+void uart_capture_session_closed(int sockfd)
+{
+    for (int i = 0; i < UART_CAPTURE_MAX_SUBSCRIBERS; i++) {
+        if (subscribers[i].fd == sockfd) {
+            subscriber_free(&subscribers[i]);
+        }
+    }
+}
+
+void uart_capture_get_stats(uart_capture_stats_t *stats)
+{
+    stats->captured = atomic_load_explicit(&captured, memory_order_relaxed);
+    stats->streamed = streamed;
+    stats->overruns = overruns;
+    stats->skipped = skipped;
+    stats->subscribers = atomic_load_explicit(&n_subscribers, memory_order_relaxed);
+}
+
+esp_err_t uart_capture_register(httpd_handle_t server)
+{
+    const esp_timer_create_args_t timer_args = {
+        .callback = poll_timer_cb,
+        .name = "uart_capture",
+    };
+
+    if (poll_timer == NULL) {
+        for (int i = 0; uart_link_channel(i); i++) {
+            uint8_t *data = malloc(CAPTURE_SIZE);
+            if (data == NULL) {
+                return ESP_ERR_NO_MEM;
+            }
+            capture_ring_init(&rings[i], data, CAPTURE_SIZE);
+            n_rings = i + 1;
+        }
+        ESP_ERROR_CHECK(esp_timer_create(&timer_args, &poll_timer));
+        uart_link_set_rx_tap(capture_tap, NULL);
+    }
+    capture_server = server;
+    return router_register_uri(server, &uri_stream);
+}
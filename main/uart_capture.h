@@ -0,0 +1,44 @@
+/* UART receive capture
+
+   Everything a UART channel receives, frames and noise alike, is kept in a
+   ring of CONFIG_EXAMPLE_UART_CAPTURE_SIZE bytes per channel (capture_ring.h)
+   by the channel's task, and streamed from there to HTTP clients:
+
+     GET /uart/stream?port=<uart port>[&backlog=1]
+
+   answers with a chunked application/octet-stream that carries the raw
+   bytes as they arrive, from now on or, with backlog=1, from the oldest byte
+   still held. Without port it follows the first channel. At most
+   UART_CAPTURE_MAX_SUBSCRIBERS streams run at a time, further ones get 503.
+
+   The bytes go from the ring to the socket without a copy, in chunks of
+   at most a quarter of the ring, and never block: the httpd task sends what
+   the socket takes when new bytes arrive and retries every
+   UART_CAPTURE_POLL_MS. A subscriber more than the ring behind skips ahead
+   to the oldest byte held; bytes overwritten while they were being sent
+   count as an overrun. Stream sessions are not closed for being idle.
+*/
+#pragma once
+
+#include <stdint.h>
+#include <esp_http_server.h>
+
+#define UART_CAPTURE_MAX_SUBSCRIBERS    4
+#define UART_CAPTURE_POLL_MS            50
+
+typedef struct {
+    uint32_t    captured;       /* bytes received, all channels */
+    uint32_t    streamed;       /* bytes sent to subscribers */
+    uint32_t    overruns;       /* subscribers that fell behind the writer */
+    uint32_t    skipped;        /* bytes they missed */
+    uint16_t    subscribers;
+} uart_capture_stats_t;
+
+/* Allocates a ring per UART channel and registers /uart/stream. The
+ * channels must have been added. */
+esp_err_t uart_capture_register(httpd_handle_t server);
+
+/* Must be called from the server close_fn */
+void uart_capture_session_closed(int sockfd);
+
+void uart_capture_get_stats(uart_capture_stats_t *stats);
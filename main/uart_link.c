@@ -0,0 +1,416 @@
+/* Asynchronous UART transactions
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <esp_ipc.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include "sched_profile.h"
+#include "trace.h"
+#include "uart_link.h"
+
+static const char *TAG = "uart-link";
+
+/* Posted to the driver event queue to wake the task for transmission */
+#define UART_LINK_EVENT_TX      UART_EVENT_MAX
+
+#define SLOT_FRAME_LEN          (UART_LINK_MAX_PAYLOAD + FRAME_OVERHEAD)
+#define UART_LINK_RX_BUFFER     256
+
+typedef enum {
+    SLOT_FREE,
+    SLOT_CLAIMED,   /* id taken, frame being encoded */
+    SLOT_QUEUED,
+    SLOT_SENT,
+} slot_state_t;
+
+typedef struct {
+    slot_state_t        state;
+    uint16_t            id;         /* low byte is the frame sequence number */
+    uint32_t            order;      /* submission order */
+    uint32_t            timeout_ms;
+    int64_t             deadline;   /* us, once sent */
+    uart_link_done_t    done;
+    void               *arg;
+    size_t              len;
+    uint8_t             frame[SLOT_FRAME_LEN];
+} slot_t;
+
+typedef struct {
+    uart_link_config_t  cfg;
+    int                 index;
+    QueueHandle_t       events;
+    slot_t              slots[UART_LINK_MAX_PENDING];
+    uint16_t            next_id;
+    uint32_t            next_order;
+    portMUX_TYPE        lock;
+    frame_parser_t      parser;
+    uart_link_stats_t   stats;
+    uint8_t             tx_buf[UART_LINK_MAX_PENDING * SLOT_FRAME_LEN];
+} link_t;
+
+/* Added at startup, before any request is made */
+static link_t *links[UART_LINK_MAX_CHANNELS];
+static int n_links;
+
+static uart_link_rx_tap_t rx_tap;
+static void *rx_tap_arg;
+
+static link_t *link_by_addr(uint8_t addr)
+{
+    for (int i = 0; i < n_links; i++) {
+        if (links[i]->cfg.addr == addr) {
+            return links[i];
+        }
+    }
+    return NULL;
+}
+
+/* Oldest slot in the given state, NULL if none */
+static slot_t *slot_oldest(link_t *link, slot_state_t state)
+{
+    slot_t *oldest = NULL;
+    for (int i = 0; i < UART_LINK_MAX_PENDING; i++) {
+        slot_t *slot = &link->slots[i];
+        if (slot->state == state && (oldest == NULL || (int32_t)(slot->order - oldest->order) < 0)) {
+            oldest = slot;
+        }
+    }
+    return oldest;
+}
+
+static void slot_complete(link_t *link, slot_t *slot, uart_link_status_t status, const uint8_t *reply, size_t len)
+{
+    uart_link_result_t result = {
+        .id = slot->id,
+        .status = status,
+        .reply = reply,
+        .reply_len = len,
+    };
+    uart_link_done_t done = slot->done;
+    void *arg = slot->arg;
+
+    portENTER_CRITICAL(&link->lock);
+    slot->state = SLOT_FREE;
+    portEXIT_CRITICAL(&link->lock);
+    if (done) {
+        done(&result, arg);
+    }
+}
+
+/* Writes every queued frame with a single uart write */
+static void link_transmit(link_t *link)
+{
+    slot_t *sent[UART_LINK_MAX_PENDING];
+    size_t n_sent = 0;
+    size_t len = 0;
+
+    for (;;) {
+        portENTER_CRITICAL(&link->lock);
+        slot_t *slot = slot_oldest(link, SLOT_QUEUED);
+        if (slot) {
+            slot->state = SLOT_SENT;
+            slot->deadline = INT64_MAX;
+        }
+        portEXIT_CRITICAL(&link->lock);
+        if (slot == NULL) {
+            break;
+        }
+        memcpy(link->tx_buf + len, slot->frame, slot->len);
+        len += slot->len;
+        sent[n_sent++] = slot;
+    }
+    if (n_sent == 0) {
+        return;
+    }
+
+    TRACE_BEGIN("uart_write", len);
+    uart_write_bytes(link->cfg.port, link->tx_buf, len);
+    TRACE_END("uart_write", n_sent);
+    link->stats.tx_writes++;
+    link->stats.tx_frames += n_sent;
+    link->stats.tx_bytes += len;
+
+    int64_t now = esp_timer_get_time();
+    for (size_t i = 0; i < n_sent; i++) {
+        sent[i]->deadline = now + (int64_t)sent[i]->timeout_ms * 1000;
+        ESP_LOGD(TAG, "UART%d: request %u sent", link->cfg.port, sent[i]->id);
+    }
+}
+
+static void link_on_frame(uint8_t seq, const uint8_t *payload, size_t len, void *arg)
+{
+    link_t *link = arg;
+    slot_t *slot = NULL;
+
+    portENTER_CRITICAL(&link->lock);
+    for (int i = 0; i < UART_LINK_MAX_PENDING; i++) {
+        if (link->slots[i].state == SLOT_SENT && (uint8_t)link->slots[i].id == seq) {
+            slot = &link->slots[i];
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&link->lock);
+
+    link->stats.rx_frames++;
+    TRACE_INSTANT("uart_reply", seq);
+    if (slot == NULL) {
+        link->stats.unmatched++;
+        ESP_LOGW(TAG, "UART%d: unsolicited reply, seq %u", link->cfg.port, seq);
+        return;
+    }
+    slot_complete(link, slot, UART_LINK_OK, payload, len);
+}
+
+static void link_receive(link_t *link, size_t size)
+{
+    uint8_t buf[128];
+
+    while (size > 0) {
+        int n = uart_read_bytes(link->cfg.port, buf, size < sizeof(buf) ? size : sizeof(buf), 0);
+        if (n <= 0) {
+            break;
+        }
+        size -= n;
+        link->stats.rx_bytes += n;
+        if (rx_tap) {
+            rx_tap(link->index, buf, n, rx_tap_arg);
+        }
+        frame_parser_feed(&link->parser, buf, n, link_on_frame, link);
+    }
+    link->stats.crc_errors = link->parser.crc_errors;
+    link->stats.dropped = link->parser.dropped;
+}
+
+/* Expires timed out requests, returns ticks until the next deadline */
+static TickType_t link_expire(link_t *link)
+{
+    int64_t now = esp_timer_get_time();
+    int64_t next = INT64_MAX;
+
+    for (int i = 0; i < UART_LINK_MAX_PENDING; i++) {
+        slot_t *slot = &link->slots[i];
+        if (slot->state != SLOT_SENT) {
+            continue;
+        }
+        if (slot->deadline <= now) {
+            ESP_LOGD(TAG, "UART%d: request %u timed out", link->cfg.port, slot->id);
+            link->stats.timeouts++;
+            slot_complete(link, slot, UART_LINK_TIMEOUT, NULL, 0);
+        } else if (slot->deadline < next) {
+            next = slot->deadline;
+        }
+    }
+    if (next == INT64_MAX) {
+        return portMAX_DELAY;
+    }
+    return pdMS_TO_TICKS((next - now + 999) / 1000) + 1;
+}
+
+static void uart_link_task(void *arg)
+{
+    link_t *link = arg;
+    uart_event_t event;
+    TickType_t wait = portMAX_DELAY;
+
+    for (;;) {
+        if (xQueueReceive(link->events, &event, wait)) {
+            switch (event.type) {
+            case UART_DATA:
+                link_receive(link, event.size);
+                break;
+            case UART_FIFO_OVF:
+            case UART_BUFFER_FULL:
+                ESP_LOGW(TAG, "UART%d: rx overflow, flushing", link->cfg.port);
+                uart_flush_input(link->cfg.port);
+                frame_parser_reset(&link->parser);
+                break;
+            default:
+                break;
+            }
+        }
+        /* Every pass, so a wakeup lost to a full event queue only delays */
+        link_transmit(link);
+        wait = link_expire(link);
+    }
+}
+
+typedef struct {
+    link_t     *link;
+    esp_err_t   ret;
+} driver_install_t;
+
+/* The driver's interrupt is allocated on the core that installs it */
+static void link_driver_install(void *arg)
+{
+    driver_install_t *install = arg;
+    link_t *link = install->link;
+
+    install->ret = uart_driver_install(link->cfg.port, UART_LINK_RX_BUFFER, 0, 20, &link->events, 0);
+}
+
+esp_err_t uart_link_add(const uart_link_config_t *cfg)
+{
+    const uart_config_t uart_config = {
+        .baud_rate  = cfg->baud_rate,
+        .data_bits  = UART_DATA_8_BITS,
+        .parity     = UART_PARITY_DISABLE,
+        .stop_bits  = UART_STOP_BITS_1,
+        .flow_ctrl  = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_APB
+    };
+    char name[16];
+    link_t *link;
+    driver_install_t install;
+    BaseType_t core = sched_slot(SCHED_UART)->core;
+
+    if (n_links == UART_LINK_MAX_CHANNELS || link_by_addr(cfg->addr)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    for (int i = 0; i < n_links; i++) {
+        if (links[i]->cfg.port == cfg->port) {
+            return ESP_ERR_INVALID_STATE;
+        }
+    }
+    link = calloc(1, sizeof(link_t));
+    if (link == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    link->cfg = *cfg;
+    link->lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+    frame_parser_init(&link->parser);
+
+    /* On the channel task's core when the layout pins it */
+    install.link = link;
+    if (core == tskNO_AFFINITY || esp_ipc_call_blocking(core, link_driver_install, &install) != ESP_OK) {
+        link_driver_install(&install);
+    }
+    if (install.ret != ESP_OK) {
+        ESP_LOGE(TAG, "UART%d: cannot install the driver", cfg->port);
+        free(link);
+        return install.ret;
+    }
+    uart_param_config(cfg->port, &uart_config);
+    uart_set_pin(cfg->port, cfg->tx_pin, cfg->rx_pin, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+
+    /* In place before the task that reads them starts */
+    link->index = n_links;
+    links[n_links++] = link;
+    snprintf(name, sizeof(name), "uart_link%d", cfg->port);
+    if (sched_task_create(SCHED_UART, uart_link_task, name, link, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "UART%d: cannot create task", cfg->port);
+        links[--n_links] = NULL;
+        uart_driver_delete(cfg->port);
+        free(link);
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "UART%d: device %u, %d baud, %u ms timeout", cfg->port, cfg->addr,
+             cfg->baud_rate, (unsigned)cfg->timeout_ms);
+    return ESP_OK;
+}
+
+/* A sequence number no outstanding request uses, called with the lock held */
+static uint16_t link_next_id(link_t *link)
+{
+    for (;;) {
+        uint16_t id = link->next_id++;
+        bool busy = false;
+        for (int i = 0; i < UART_LINK_MAX_PENDING; i++) {
+            if (link->slots[i].state != SLOT_FREE && (uint8_t)link->slots[i].id == (uint8_t)id) {
+                busy = true;
+                break;
+            }
+        }
+        if (!busy) {
+            return id;
+        }
+    }
+}
+
+esp_err_t uart_link_request(uint8_t addr, const uint8_t *payload, size_t len, uint32_t timeout_ms,
+                            uart_link_done_t done, void *arg, uint16_t *id)
+{
+    link_t *link = link_by_addr(addr);
+    slot_t *slot = NULL;
+
+    if (link == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (len > UART_LINK_MAX_PAYLOAD) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    portENTER_CRITICAL(&link->lock);
+    for (int i = 0; i < UART_LINK_MAX_PENDING; i++) {
+        if (link->slots[i].state == SLOT_FREE) {
+            slot = &link->slots[i];
+            break;
+        }
+    }
+    if (slot) {
+        slot->id = link_next_id(link);
+        slot->order = link->next_order++;
+        slot->state = SLOT_CLAIMED;
+    }
+    portEXIT_CRITICAL(&link->lock);
+
+    if (slot == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    /* The slot is ours until it is queued, the CRC is computed unlocked */
+    slot->timeout_ms = timeout_ms ? timeout_ms : link->cfg.timeout_ms;
+    slot->done = done;
+    slot->arg = arg;
+    slot->len = frame_encode(slot->frame, sizeof(slot->frame), (uint8_t)slot->id, payload, len);
+    if (id) {
+        *id = slot->id;
+    }
+    portENTER_CRITICAL(&link->lock);
+    slot->state = SLOT_QUEUED;
+    portEXIT_CRITICAL(&link->lock);
+
+    const uart_event_t wake = { .type = UART_LINK_EVENT_TX };
+    xQueueSend(link->events, &wake, 0);
+    return ESP_OK;
+}
+
+void uart_link_set_rx_tap(uart_link_rx_tap_t tap, void *arg)
+{
+    rx_tap_arg = arg;
+    rx_tap = tap;
+}
+
+const uart_link_config_t *uart_link_channel(int index)
+{
+    return index < n_links ? &links[index]->cfg : NULL;
+}
+
+bool uart_link_get_stats(int index, uart_link_stats_t *out)
+{
+    if (index >= n_links) {
+        return false;
+    }
+    link_t *link = links[index];
+    *out = link->stats;
+    out->queued = 0;
+    out->awaiting = 0;
+    portENTER_CRITICAL(&link->lock);
+    for (int i = 0; i < UART_LINK_MAX_PENDING; i++) {
+        out->queued += link->slots[i].state == SLOT_QUEUED;
+        out->awaiting += link->slots[i].state == SLOT_SENT;
+    }
+    portEXIT_CRITICAL(&link->lock);
+    out->rx_events = uxQueueMessagesWaiting(link->events);
+    return true;
+}
@@ -0,0 +1,88 @@
+/* Asynchronous UART transactions
+
+   Every peer sits on its own UART channel, added with uart_link_add() and
+   known by a device address. A channel is owned by one task with its own
+   driver event queue and request slots, so a slow or silent peer only
+   delays the requests addressed to it. Callers submit a command payload
+   (see frame.h) for a device with a completion callback; the channel's task
+   frames it, writes everything queued in one go, matches each reply frame
+   to its request by sequence number and calls the callback with the reply
+   payload or with UART_LINK_TIMEOUT once the request's timeout expires.
+   Nobody waits on a UART, so the httpd task is never held up.
+*/
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "driver/uart.h"
+#include "frame.h"
+
+#define UART_LINK_MAX_CHANNELS  UART_NUM_MAX
+#define UART_LINK_MAX_PENDING   8       /* per channel */
+#define UART_LINK_MAX_PAYLOAD   128
+
+typedef enum {
+    UART_LINK_OK,
+    UART_LINK_TIMEOUT,
+} uart_link_status_t;
+
+typedef struct {
+    uart_port_t port;
+    int         tx_pin;
+    int         rx_pin;
+    int         baud_rate;
+    uint32_t    timeout_ms;     /* reply timeout of requests without their own */
+    uint8_t     addr;           /* device address of the peer */
+} uart_link_config_t;
+
+typedef struct {
+    uint16_t            id;         /* correlation id returned on submit */
+    uart_link_status_t  status;
+    const uint8_t      *reply;      /* reply payload, a command list */
+    size_t              reply_len;
+} uart_link_result_t;
+
+typedef struct {
+    uint32_t    tx_frames;
+    uint32_t    tx_bytes;
+    uint32_t    tx_writes;          /* uart writes, several frames each under load */
+    uint32_t    rx_frames;
+    uint32_t    rx_bytes;
+    uint32_t    crc_errors;
+    uint32_t    dropped;            /* rx bytes outside valid frames */
+    uint32_t    unmatched;          /* replies without an outstanding request */
+    uint32_t    timeouts;
+    uint32_t    queued;             /* requests waiting for transmission */
+    uint32_t    awaiting;           /* requests waiting for their reply */
+    uint32_t    rx_events;          /* driver events not yet handled */
+} uart_link_stats_t;
+
+/* Called from the channel's task, must not block */
+typedef void (*uart_link_done_t)(const uart_link_result_t *result, void *arg);
+
+/* Gets every byte a channel receives, as it is read and before the frame
+ * parser sees it. Called from the channel's task, must not block. */
+typedef void (*uart_link_rx_tap_t)(int index, const uint8_t *data, size_t len, void *arg);
+
+/* Install the driver of cfg->port and start its channel. The config is
+ * copied. ESP_ERR_INVALID_STATE if the port or the address is taken. */
+esp_err_t uart_link_add(const uart_link_config_t *cfg);
+
+/* Queue a command payload for the device at addr. The reply timeout starts
+ * when the frame has been written, 0 takes the channel's. ESP_ERR_NOT_FOUND
+ * for an unknown address, ESP_ERR_NO_MEM if UART_LINK_MAX_PENDING requests
+ * are already outstanding on its channel. */
+esp_err_t uart_link_request(uint8_t addr, const uint8_t *payload, size_t len, uint32_t timeout_ms,
+                            uart_link_done_t done, void *arg, uint16_t *id);
+
+/* Installs the receive tap, one for all channels. NULL removes it. */
+void uart_link_set_rx_tap(uart_link_rx_tap_t tap, void *arg);
+
+/* Channels in the order they were added, NULL past the last one */
+const uart_link_config_t *uart_link_channel(int index);
+
+/* Statistics of the channel at index, false past the last one */
+bool uart_link_get_stats(int index, uart_link_stats_t *stats);
@@ -0,0 +1,148 @@
+/* Streaming request bodies
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <esp_log.h>
+#include <esp_rom_crc.h>
+#include <esp_timer.h>
+
+#include "upload.h"
+
+static const char *TAG = "upload";
+
+#define UPLOAD_SAMPLE_LEN   32
+
+/* Handlers run one at a time in the httpd task */
+static char upload_buf[CONFIG_EXAMPLE_UPLOAD_BUFFER_SIZE];
+
+static esp_err_t echo_write(httpd_req_t *req, upload_t *up, const char *data, size_t len)
+{
+    return httpd_resp_send_chunk(req, data, len);
+}
+
+static esp_err_t echo_finish(httpd_req_t *req, upload_t *up)
+{
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+static esp_err_t discard_write(httpd_req_t *req, upload_t *up, const char *data, size_t len)
+{
+    return ESP_OK;
+}
+
+static esp_err_t discard_finish(httpd_req_t *req, upload_t *up)
+{
+    char json[64];
+
+    snprintf(json, sizeof(json), "{\"bytes\":%u,\"us\":%lld}", (unsigned)up->bytes,
+             (long long)(esp_timer_get_time() - up->start_us));
+    httpd_resp_set_type(req, HTTPD_TYPE_JSON);
+    return httpd_resp_sendstr(req, json);
+}
+
+static esp_err_t checksum_write(httpd_req_t *req, upload_t *up, const char *data, size_t len)
+{
+    up->crc32 = esp_rom_crc32_le(up->crc32, (const uint8_t *)data, len);
+    return ESP_OK;
+}
+
+static esp_err_t checksum_finish(httpd_req_t *req, upload_t *up)
+{
+    char json[80];
+
+    snprintf(json, sizeof(json), "{\"bytes\":%u,\"us\":%lld,\"crc32\":\"%08x\"}", (unsigned)up->bytes,
+             (long long)(esp_timer_get_time() - up->start_us), (unsigned)up->crc32);
+    httpd_resp_set_type(req, HTTPD_TYPE_JSON);
+    return httpd_resp_sendstr(req, json);
+}
+
+const upload_sink_t upload_sink_echo = {
+    .name   = "echo",
+    .write  = echo_write,
+    .finish = echo_finish,
+};
+
+const upload_sink_t upload_sink_discard = {
+    .name   = "discard",
+    .write  = discard_write,
+    .finish = discard_finish,
+};
+
+const upload_sink_t upload_sink_checksum = {
+    .name   = "checksum",
+    .write  = checksum_write,
+    .finish = checksum_finish,
+};
+
+static const upload_sink_t *const sinks[] = {
+    &upload_sink_echo,
+    &upload_sink_discard,
+    &upload_sink_checksum,
+};
+
+const upload_sink_t *upload_sink_find(const char *name)
+{
+    for (size_t i = 0; i < sizeof(sinks) / sizeof(sinks[0]); i++) {
+        if (strcmp(sinks[i]->name, name) == 0) {
+            return sinks[i];
+        }
+    }
+    return NULL;
+}
+
+/* Sampled progress instead of a log line per chunk */
+static void upload_log_progress(httpd_req_t *req, upload_t *up, int64_t now)
+{
+    if (up->chunks == 1) {
+        ESP_LOGD(TAG, "%s: %.*s", req->uri, (int)(up->bytes < UPLOAD_SAMPLE_LEN ? up->bytes : UPLOAD_SAMPLE_LEN),
+                 upload_buf);
+    }
+    if (now - up->last_log_us >= (int64_t)CONFIG_EXAMPLE_UPLOAD_LOG_INTERVAL_MS * 1000) {
+        up->last_log_us = now;
+        ESP_LOGI(TAG, "%s: %u of %u bytes", req->uri, (unsigned)up->bytes, (unsigned)req->content_len);
+    }
+}
+
+esp_err_t upload_receive(httpd_req_t *req, const upload_sink_t *sink)
+{
+    upload_t up = { 0 };
+    size_t remaining = req->content_len;
+    int ret;
+
+    up.start_us = esp_timer_get_time();
+    up.last_log_us = up.start_us;
+    while (remaining > 0) {
+        ret = httpd_req_recv(req, upload_buf,
+                             remaining < sizeof(upload_buf) ? remaining : sizeof(upload_buf));
+        if (ret <= 0) {
+            if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
+                /* Retry receiving if timeout occurred */
+                continue;
+            }
+            ESP_LOGW(TAG, "%s: connection lost after %u of %u bytes", req->uri,
+                     (unsigned)up.bytes, (unsigned)req->content_len);
+            return ESP_FAIL;
+        }
+        remaining -= ret;
+        up.bytes += ret;
+        up.chunks++;
+        if (sink->write(req, &up, upload_buf, ret) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        upload_log_progress(req, &up, esp_timer_get_time());
+    }
+
+    esp_err_t err = sink->finish(req, &up);
+    int64_t us = esp_timer_get_time() - up.start_us;
+    ESP_LOGI(TAG, "%s %s: %u bytes in %u chunks, %lld ms, %u KB/s", req->uri, sink->name,
+             (unsigned)up.bytes, (unsigned)up.chunks, (long long)(us / 1000),
+             (unsigned)(us > 0 ? (uint64_t)up.bytes * 1000000 / 1024 / us : 0));
+    return err;
+}
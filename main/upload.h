@@ -0,0 +1,44 @@
+/* Streaming request bodies
+
+   upload_receive() reads a request body through one window-sized buffer
+   (CONFIG_EXAMPLE_UPLOAD_BUFFER_SIZE) and hands every chunk to a sink:
+
+     echo       sends the body back as a chunked response
+     discard    drops it
+     checksum   computes its CRC-32
+
+   The discard and checksum sinks answer {"bytes":N,"us":T} (plus "crc32").
+   Progress is logged at most once per CONFIG_EXAMPLE_UPLOAD_LOG_INTERVAL_MS
+   and a summary line closes every upload.
+
+   The buffer is shared: upload_receive() must only run in the httpd task.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_http_server.h>
+
+typedef struct {
+    size_t      bytes;
+    uint32_t    chunks;     /* reads that returned data */
+    int64_t     start_us;
+    int64_t     last_log_us;
+    uint32_t    crc32;
+} upload_t;
+
+typedef struct {
+    const char *name;
+    esp_err_t (*write)(httpd_req_t *req, upload_t *up, const char *data, size_t len);
+    /* Sends the response */
+    esp_err_t (*finish)(httpd_req_t *req, upload_t *up);
+} upload_sink_t;
+
+extern const upload_sink_t upload_sink_echo;
+extern const upload_sink_t upload_sink_discard;
+extern const upload_sink_t upload_sink_checksum;
+
+/* NULL for an unknown name */
+const upload_sink_t *upload_sink_find(const char *name);
+
+esp_err_t upload_receive(httpd_req_t *req, const upload_sink_t *sink);
@@ -0,0 +1,302 @@
+/* WebSocket push channel
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <esp_log.h>
+
+#include "connmgr.h"
+#include "metrics.h"
+#include "ws.h"
+
+static const char *TAG = "ws";
+
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+
+static httpd_handle_t ws_server;
+static ws_command_fn_t ws_on_command;
+static ws_binary_fn_t ws_on_binary;
+
+/* Clients that sent a binary message, only used in the httpd task */
+static int binary_fds[CONFIG_LWIP_MAX_SOCKETS] = {
+    [0 ... CONFIG_LWIP_MAX_SOCKETS - 1] = -1,
+};
+
+/* Session generations, bumped whenever a socket is closed. Only touched from
+ * the httpd task. */
+#define SESSION_GEN_SLOTS   64
+
+static uint32_t session_gen[SESSION_GEN_SLOTS];
+
+typedef struct {
+    int     fd;             /* -1 for every client */
+    uint32_t gen;           /* session of fd */
+    size_t  text_len;       /* 0 if there is only the binary form */
+    size_t  bin_len;        /* 0 if there is only the text form */
+    uint8_t data[];         /* text, then binary */
+} ws_msg_t;
+
+static uint32_t *gen_slot(int fd)
+{
+    return &session_gen[(unsigned)fd % SESSION_GEN_SLOTS];
+}
+
+static int *binary_slot(int fd)
+{
+    for (int i = 0; i < CONFIG_LWIP_MAX_SOCKETS; i++) {
+        if (binary_fds[i] == fd) {
+            return &binary_fds[i];
+        }
+    }
+    return NULL;
+}
+
+static void ws_send_one(int fd, const ws_msg_t *msg)
+{
+    bool binary = msg->bin_len && (msg->text_len == 0 || binary_slot(fd));
+    httpd_ws_frame_t frame = {
+        .final = true,
+        .type = binary ? HTTPD_WS_TYPE_BINARY : HTTPD_WS_TYPE_TEXT,
+        .payload = (uint8_t *)msg->data + (binary ? msg->text_len : 0),
+        .len = binary ? msg->bin_len : msg->text_len,
+    };
+    if (httpd_ws_send_frame_async(ws_server, fd, &frame) != ESP_OK) {
+        ESP_LOGD(TAG, "send to %d failed, closing", fd);
+        httpd_sess_trigger_close(ws_server, fd);
+    }
+}
+
+/* Runs in the httpd task */
+static void ws_send_work(void *arg)
+{
+    ws_msg_t *msg = arg;
+    int fds[CONFIG_LWIP_MAX_SOCKETS];
+    size_t n = sizeof(fds) / sizeof(fds[0]);
+
+    if (msg->fd >= 0) {
+        if (msg->gen != *gen_slot(msg->fd)) {
+            ESP_LOGD(TAG, "client %d gone before the message was sent", msg->fd);
+        } else if (httpd_ws_get_fd_info(ws_server, msg->fd) == HTTPD_WS_CLIENT_WEBSOCKET) {
+            ws_send_one(msg->fd, msg);
+        }
+    } else if (httpd_get_client_list(ws_server, &n, fds) == ESP_OK) {
+        for (size_t i = 0; i < n; i++) {
+            if (httpd_ws_get_fd_info(ws_server, fds[i]) == HTTPD_WS_CLIENT_WEBSOCKET) {
+                ws_send_one(fds[i], msg);
+            }
+        }
+    }
+    free(msg);
+}
+
+static esp_err_t ws_queue(ws_client_t client, const char *text, const void *bin, size_t bin_len)
+{
+    size_t len = text ? strlen(text) : 0;
+    ws_msg_t *msg;
+
+    if (ws_server == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    msg = malloc(sizeof(*msg) + len + bin_len);
+    if (msg == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    msg->fd = client.fd;
+    msg->gen = client.gen;
+    msg->text_len = len;
+    msg->bin_len = bin_len;
+    if (len) {
+        memcpy(msg->data, text, len);
+    }
+    if (bin_len) {
+        memcpy(msg->data + len, bin, bin_len);
+    }
+    if (httpd_queue_work(ws_server, ws_send_work, msg) != ESP_OK) {
+        free(msg);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static const ws_client_t ws_everyone = { .fd = -1 };
+
+esp_err_t ws_broadcast(const char *msg)
+{
+    return ws_queue(ws_everyone, msg, NULL, 0);
+}
+
+esp_err_t ws_publish(const char *msg, const void *bin, size_t bin_len)
+{
+    return ws_queue(ws_everyone, msg, bin, bin_len);
+}
+
+ws_client_t ws_client(httpd_req_t *req)
+{
+    int fd = httpd_req_to_sockfd(req);
+    return (ws_client_t){ .fd = fd, .gen = *gen_slot(fd) };
+}
+
+esp_err_t ws_send_to(ws_client_t client, const char *msg)
+{
+    return ws_queue(client, msg, NULL, 0);
+}
+
+esp_err_t ws_send_bin_to(ws_client_t client, const void *data, size_t len)
+{
+    return ws_queue(client, NULL, data, len);
+}
+
+esp_err_t ws_reply(httpd_req_t *req, const char *msg)
+{
+    httpd_ws_frame_t frame = {
+        .final = true,
+        .type = HTTPD_WS_TYPE_TEXT,
+        .payload = (uint8_t *)msg,
+        .len = strlen(msg),
+    };
+    return httpd_ws_send_frame(req, &frame);
+}
+
+esp_err_t ws_reply_bin(httpd_req_t *req, const void *data, size_t len)
+{
+    httpd_ws_frame_t frame = {
+        .final = true,
+        .type = HTTPD_WS_TYPE_BINARY,
+        .payload = (uint8_t *)data,
+        .len = len,
+    };
+    return httpd_ws_send_frame(req, &frame);
+}
+
+static esp_err_t ws_handler(httpd_req_t *req)
+{
+    int fd = httpd_req_to_sockfd(req);
+    uint8_t buf[WS_MAX_MESSAGE + 1];
+    httpd_ws_frame_t frame = { .payload = buf };
+    esp_err_t ret;
+
+    if (req->method == HTTP_GET) {
+        if (httpd_ws_get_fd_info(req->handle, fd) != HTTPD_WS_CLIENT_WEBSOCKET) {
+            return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "WebSocket upgrade expected");
+        }
+        ESP_LOGI(TAG, "client %d connected", fd);
+        connmgr_websocket(fd);
+        return ESP_OK;
+    }
+
+    /* Length first, then the payload */
+    ret = httpd_ws_recv_frame(req, &frame, 0);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (frame.len > WS_MAX_MESSAGE) {
+        /* The payload is still in the socket and can't be skipped with the
+         * frame API, so the session goes */
+        ESP_LOGW(TAG, "client %d: %u byte message, closing", fd, (unsigned)frame.len);
+        return ESP_FAIL;
+    }
+    ret = httpd_ws_recv_frame(req, &frame, WS_MAX_MESSAGE);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (frame.type == HTTPD_WS_TYPE_BINARY) {
+        int *slot;
+        if (binary_slot(fd) == NULL && (slot = binary_slot(-1)) != NULL) {
+            *slot = fd;
+        }
+        if (ws_on_binary) {
+            ws_on_binary(req, buf, frame.len);
+        }
+        return ESP_OK;
+    }
+    if (frame.type != HTTPD_WS_TYPE_TEXT) {
+        return ESP_OK;
+    }
+    buf[frame.len] = '\0';
+    ESP_LOGD(TAG, "client %d: %s", fd, buf);
+    if (ws_on_command) {
+        ws_on_command(req, (const char *)buf);
+    }
+    return ESP_OK;
+}
+
+void ws_session_closed(int sockfd)
+{
+    int *slot = binary_slot(sockfd);
+
+    (*gen_slot(sockfd))++;
+    if (slot) {
+        *slot = -1;
+    }
+}
+
+esp_err_t ws_register(httpd_handle_t server, ws_command_fn_t on_command, ws_binary_fn_t on_binary)
+{
+    const httpd_uri_t uri_ws = {
+        .uri        = WS_URI,
+        .method     = HTTP_GET,
+        .handler    = ws_handler,
+        .user_ctx   = NULL,
+        .is_websocket = true,
+    };
+
+    ws_server = server;
+    ws_on_command = on_command;
+    ws_on_binary = on_binary;
+    return metrics_register_uri(server, &uri_ws);
+}
+
+#else /* !CONFIG_HTTPD_WS_SUPPORT */
+
+esp_err_t ws_register(httpd_handle_t server, ws_command_fn_t on_command, ws_binary_fn_t on_binary)
+{
+    ESP_LOGW(TAG, "CONFIG_HTTPD_WS_SUPPORT is off, " WS_URI " not available");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t ws_broadcast(const char *msg)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t ws_publish(const char *msg, const void *bin, size_t bin_len)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void ws_session_closed(int sockfd)
+{
+}
+
+ws_client_t ws_client(httpd_req_t *req)
+{
+    return (ws_client_t){ .fd = httpd_req_to_sockfd(req) };
+}
+
+esp_err_t ws_send_to(ws_client_t client, const char *msg)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t ws_send_bin_to(ws_client_t client, const void *data, size_t len)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t ws_reply(httpd_req_t *req, const char *msg)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t ws_reply_bin(httpd_req_t *req, const void *data, size_t len)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif
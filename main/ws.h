@@ -0,0 +1,52 @@
+/* WebSocket push channel
+
+   /ws keeps one socket per browser. Clients send short text commands
+   upstream, the server pushes state changes to every connected client as
+   small JSON messages. A client may send binary messages instead (see
+   proto.h); from its first one on it gets the binary form of pushes that
+   have one. ws_broadcast() and ws_send_to() may be called from any task;
+   the frames are written from the httpd task through httpd_queue_work().
+*/
+#pragma once
+
+#include <esp_http_server.h>
+
+#define WS_URI              "/ws"
+#define WS_MAX_MESSAGE      64      /* a longer message closes the session */
+
+/* Handles one text command of a client, runs in the httpd task */
+typedef void (*ws_command_fn_t)(httpd_req_t *req, const char *cmd);
+
+/* Handles one binary message of a client, runs in the httpd task */
+typedef void (*ws_binary_fn_t)(httpd_req_t *req, const uint8_t *data, size_t len);
+
+esp_err_t ws_register(httpd_handle_t server, ws_command_fn_t on_command, ws_binary_fn_t on_binary);
+
+/* Must be called from the server close_fn */
+void ws_session_closed(int sockfd);
+
+/* Send a text message to every connected client */
+esp_err_t ws_broadcast(const char *msg);
+
+/* Like ws_broadcast(), clients that send binary messages get bin instead */
+esp_err_t ws_publish(const char *msg, const void *bin, size_t bin_len);
+
+/* A client to answer later; the socket number alone may belong to another
+ * client by then. fd is -1 for none. */
+typedef struct {
+    int         fd;
+    uint32_t    gen;
+} ws_client_t;
+
+/* The client of the current request, from the command callbacks */
+ws_client_t ws_client(httpd_req_t *req);
+
+/* Send a text message to one client, dropped if it disconnected meanwhile */
+esp_err_t ws_send_to(ws_client_t client, const char *msg);
+
+/* Send a binary message to one client */
+esp_err_t ws_send_bin_to(ws_client_t client, const void *data, size_t len);
+
+/* Answer the client of the current request, from the command callback */
+esp_err_t ws_reply(httpd_req_t *req, const char *msg);
+esp_err_t ws_reply_bin(httpd_req_t *req, const void *data, size_t len);